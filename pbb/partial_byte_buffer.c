@@ -1,9 +1,23 @@
 #include "partial_byte_buffer.h"
+#include "pbb_kernels.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define PBB_HAVE_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define PBB_HAVE_POSIX 0
+#endif
+
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define CLAMP(val, min, max) ( (val) < (min) ? (min) : ( (val) > (max) ? (max) : (val) ) )
@@ -14,70 +28,358 @@ static const uint8_t BITSIZEOF_LONG = sizeof(long) << 3;
 static const uint8_t BITSIZEOF_INT64 = sizeof(int64_t) << 3;
 static const uint8_t BITSIZEOF_FLOAT = sizeof(float) << 3;
 
-static const int CAPACITY_DOUBLE = 0;
-static const int CAPACITY_HALF = 1;
+/**
+ * Format of IEEE-754 doubles, the source of pbb_write_double_as and the destination of pbb_read_double_as.
+ */
+static const int DOUBLE_EXP_BITS = 11;
+static const int DOUBLE_MANT_BITS = 52;
+static const int DOUBLE_EXP_BIAS = 1023;
+static const uint64_t DOUBLE_EXP_MASK = 0x7FF;
+
+/**
+ * Number of values resized at once by the double array functions, on the stack.
+ */
+#define RESIZE_BLOCK_SIZE 256
+
+/**
+ * Buckets of the delta codes, indexed by the number of leading one bits of their prefix:
+ * width of the two's complement residual following the prefix.
+ */
+#define DELTA_BUCKET_COUNT 6
+static const uint8_t DELTA_RESIDUAL_BITS[DELTA_BUCKET_COUNT] = {0, 7, 9, 12, 32, 64};
+
+/**
+ * Widest delta code: the 5-bit prefix of the last bucket and a 64-bit residual.
+ */
+#define DELTA_CODE_MAX_BITS 69
+
+/**
+ * Bytes a delta code may load from its first byte: a 9-byte window for the prefix,
+ * and another for the residual, which starts at most one byte later.
+ */
+#define DELTA_WINDOW_BYTES 10
+
+struct flr_decode_table {
+    /**
+     * Number of bits of the codes, sign included.
+     */
+    uint8_t bits;
+
+    /**
+     * Doubles of the (1 << [bits]) codes, indexed by code.
+     */
+    double* values;
+};
+
+/**
+ * Number of zeroed bytes kept behind the last usable byte of every buffer allocation.
+ * Bits are written and read with whole 64-bit word accesses at the byte under the cursor,
+ * so up to 7 bytes past [capacity] may be touched. They only ever receive zero bits.
+ */
+static const size_t BUFFER_PADDING = sizeof(uint64_t);
+
+/**
+ * Number of entries passed to one writev call by pbb_writev, within the IOV_MAX limit.
+ */
+#if defined(IOV_MAX) && IOV_MAX < 64
+#define IOVEC_BATCH IOV_MAX
+#else
+#define IOVEC_BATCH 64
+#endif
+
+/**
+ * Size of the zero-padded copy used to read the last bytes of memory that has no tail padding.
+ * It holds up to 8 remaining bytes plus room for a 9-byte window load from any of them.
+ */
+#define TAIL_COPY_SIZE (2 * sizeof(uint64_t))
+
+/**
+ * Segment size bounds of segmented buffers, as base-2 logarithms.
+ * A segment of at least 16 bytes guarantees that a field of up to 9 bytes spans at most 2 segments.
+ */
+static const uint8_t MIN_SEGMENT_SHIFT = 4;
+static const uint8_t MAX_SEGMENT_SHIFT = 30;
+
+/**
+ * Smallest refill window of a streaming reader, so that any single field fits in it.
+ */
+static const size_t MIN_READER_WINDOW = 16;
 
+/**
+ * Growth mode of new buffers: 0 (PBB_GROWTH_DOUBLE) or 1 (PBB_GROWTH_HALF).
+ * Each buffer can switch to another policy at runtime with pbb_set_growth_policy.
+ */
 #ifndef CAPACITY_GROWTH_MODE
-#define CAPACITY_GROWTH_MODE CAPACITY_DOUBLE
+#define CAPACITY_GROWTH_MODE PBB_GROWTH_DOUBLE
+#endif
+
+/**
+ * Allocate a partial_byte_buffer structure for [buffer] of [capacity] bytes, with both cursors at 0.
+ * Returns NULL if memory allocation fails; [buffer] is not released then.
+ */
+static partial_byte_buffer* create_header(uint8_t* buffer, size_t capacity, pbb_storage storage);
+
+/**
+ * Merge the lowest [bits] bits (1-64) of [data] into memory, [bit_pos] (0-7) bits into [dst].
+ * The bits are aligned in a 64-bit register and merged with a single word load/store,
+ * plus one extra byte when the field straddles 9 bytes.
+ * Bits past [bit_pos] must be zero and 9 bytes from [dst] must be writable.
+ */
+static inline void put_bits(uint8_t* dst, uint8_t bit_pos, uint64_t data, uint8_t bits);
+
+/**
+ * Return the [bits] bits (1-64) found [bit_pos] (0-7) bits into [src] as an unsigned value.
+ * A 64-bit window is refilled with one unaligned big-endian load, and the field is cut out
+ * with a shift, borrowing one more byte when it straddles 9 bytes.
+ * 9 bytes from [src] must be readable.
+ */
+static inline uint64_t get_bits(const uint8_t* src, uint8_t bit_pos, uint8_t bits);
+
+/**
+ * Extracted function to write the lowest [bits] bits (1-64) of [data] at the write cursor.
+ * The caller must have ensured capacity for [bits] more bits.
+ */
+static void write_bits(partial_byte_buffer* pbb, uint64_t data, uint8_t bits);
+
+/**
+ * Extracted function to read [bits] bits (1-64) at the read cursor as an unsigned value.
+ * The caller must have checked that [bits] bits are available.
+ */
+static uint64_t read_bits(partial_byte_buffer* pbbr, uint8_t bits);
+
+/**
+ * Get the [bits] bits (1-64) at the read cursor as read_bits does, without consuming them.
+ */
+static uint64_t peek_bits(const partial_byte_buffer* pbbr, uint8_t bits);
+
+/**
+ * Append one zeroed segment, with tail padding, to a segmented buffer.
+ * Returns 0 if memory allocation fails.
+ */
+static int add_segment(partial_byte_buffer* pbb);
+
+/**
+ * Return the address of byte [byte_pos] of a segmented or ring buffer.
+ */
+static inline uint8_t* segment_byte(const partial_byte_buffer* pbb, size_t byte_pos);
+
+/**
+ * Return how many of [count] fields of [bits] bits starting at bit [pos] of a segmented or ring buffer
+ * end inside the segment holding [pos], or before the end of the ring. These can use the padded
+ * word accesses directly.
+ */
+static inline size_t segment_run(const partial_byte_buffer* pbb, size_t pos, size_t count, uint8_t bits);
+
+/**
+ * Copy [size] bytes from [byte_pos] of a segmented or ring buffer into [dst],
+ * across segment boundaries or around the end of the ring.
+ */
+static void gather_bytes(const partial_byte_buffer* pbb, size_t byte_pos, uint8_t* dst, size_t size);
+
+/**
+ * OR [size] bytes of [src] into [byte_pos] of a segmented or ring buffer,
+ * across segment boundaries or around the end of the ring.
+ * Merging rather than copying keeps the bytes right when a small ring wraps onto the first one.
+ */
+static void merge_bytes(partial_byte_buffer* pbb, size_t byte_pos, const uint8_t* src, size_t size);
+
+/**
+ * Return the number of contiguous bytes of a segmented or ring buffer from [byte_pos] up to
+ * the next segment boundary or the end of the ring, and set [data] to their address.
+ * [byte_pos] may go past the end of a ring, in which case it wraps around.
+ */
+static inline size_t storage_span(const partial_byte_buffer* pbb, size_t byte_pos, uint8_t** data);
+
+/**
+ * Return the number of contiguous bytes of the written data (see pbb_get_length) from [offset] on,
+ * and set [data] to their address. [offset] is counted from the first byte of the data.
+ */
+static inline size_t data_span(const partial_byte_buffer* pbb, size_t offset, uint8_t** data);
+
+#if PBB_HAVE_POSIX
+/**
+ * Fill up to [iov_count] entries describing the written data from [offset] on.
+ * With [stop], returns the number of entries filled, else the number needed for all the data.
+ */
+static size_t fill_iovec(const partial_byte_buffer* pbb, size_t offset, struct iovec* iov, size_t iov_count, int stop);
 #endif
 
 /**
- * Extracted function to write data into the current byte of partial_byte_buffer.
- * This function is called multiple times to write a number of data bits at a time, until all bits are written.
- * @param data The data to write. Use 64-bit to accommodate supported types.
- * @param data_bits Number of data bits remaining, will be updated after each succeeded write.
+ * Clear [bits] bits of a ring buffer from bit [pos] on, wrapping around its end.
+ * Read bits are cleared so that the free part of the ring stays zeroed for the OR-based writes.
  */
-static void write_byte(partial_byte_buffer* pbb, uint64_t data, uint8_t* data_bits);
+static void clear_ring_bits(partial_byte_buffer* pbb, size_t pos, size_t bits);
 
 /**
- * Extracted function to read a byte with specified bit length from the buffer into an accumulator.
- * This function is called multiple times by a higher-level read method until all bits are read.
- * @param acc Accumulator to store the read value. Use 64-bit to accommodate supported types.
- * @param read_bits Number of bits remaining to read; will be updated after each successful read.
+ * Move a cursor of a ring buffer by [bits] bits, wrapping around its end.
  */
-static uint8_t read_byte(partial_byte_buffer* pbbr, uint64_t* acc, uint8_t* read_bits);
+static inline size_t wrap_ring_pos(const partial_byte_buffer* pbb, size_t pos, size_t bits);
 
 /**
- * Return a sensible minimum number of bytes for reading [bits] bits from the current position.
- * This is used to check if there is enough data in the buffer before reading.
+ * Return the number of bits that can be read from the current position,
+ * counting up to the end of the last written byte, or the unread bits of a ring buffer.
  */
-static size_t required_length(const partial_byte_buffer* pbbr, uint8_t bits);
+static size_t available_bits(const partial_byte_buffer* pbbr);
 
 /**
- * Find a right allocation size to cover [n] bytes of buffer.
- * @param n Number of bytes requested.
+ * Find a right allocation size to cover [required] bytes of a buffer of [capacity] bytes,
+ * following the growth [policy] and clamped to its maximum capacity.
+ * The result is below [required] when the policy cannot provide it.
  */
-static size_t next_capacity(size_t n);
+static size_t next_capacity(const pbb_growth_policy* policy, size_t capacity, size_t required);
 
 /**
  * Ensure a partial_byte_buffer has enough capacity to write [bits] more bits 
  * by reallocating its internal buffer if necessary.
+ * A buffer that is not owned is first copied into an owned allocation.
+ * Returns 0 if the growth policy refuses to grow or memory allocation fails,
+ * in which case nothing must be written.
+ */
+static int ensure_capacity(partial_byte_buffer* pbb, size_t bits);
+
+/**
+ * Reallocate the buffer array to [capacity] bytes (not less than the current one) plus padding,
+ * copying memory that is not owned, or add segments to reach it for segmented buffers.
+ * Returns 0 if memory allocation fails.
+ */
+static int resize_storage(partial_byte_buffer* pbb, size_t capacity);
+
+/**
+ * Release the buffer array according to its storage: free owned memory, unmap file mappings.
+ */
+static void release_storage(partial_byte_buffer* pbb);
+
+/**
+ * Return the number of bytes that may be loaded from the buffer array: tail padding included
+ * for owned and ring buffers, only [capacity] for memory that is not owned.
+ */
+static size_t readable_bytes(const partial_byte_buffer* pbbr);
+
+/**
+ * Return how many of [count] values of [bits] bits from the read cursor can be decoded
+ * with 9-byte window loads staying inside readable_bytes.
+ */
+static size_t loadable_values(const partial_byte_buffer* pbbr, size_t count, uint8_t bits);
+
+/**
+ * Copy the readable bytes from [byte_pos] on into the zeroed [tail],
+ * so that window loads near the end of memory without padding stay in bounds.
+ */
+static void copy_tail(const partial_byte_buffer* pbbr, size_t byte_pos, uint8_t tail[TAIL_COPY_SIZE]);
+
+/**
+ * Hand the complete bytes of a streaming writer to its sink and move the partial last byte
+ * to the start of the buffer. Returns 0 if the sink fails, leaving the buffer untouched.
+ */
+static int drain_to_sink(partial_byte_buffer* pbb);
+
+/**
+ * Number of the next [count] fields of [bits] bits a streaming writer packs at once, about [watermark] bytes,
+ * after flushing the complete bytes when they do not fit in the buffer, so that array writes never grow it.
+ */
+static size_t writer_run(partial_byte_buffer* pbb, size_t count, uint8_t bits);
+
+/**
+ * Check that [bits] bits can be read from the current position, pulling more bytes
+ * from the source of a streaming reader when needed.
+ */
+static int ensure_readable(partial_byte_buffer* pbbr, size_t bits);
+
+/**
+ * Drop the bytes fully read from the window of a streaming reader, then pull bytes from its source
+ * until [bits] bits are available or the source ends.
+ */
+static void refill_from_source(partial_byte_buffer* pbbr, size_t bits);
+
+/**
+ * Sources of the readers created by pbb_create_fd_reader and pbb_create_file_reader.
+ */
+#if PBB_HAVE_POSIX
+static size_t read_from_fd(uint8_t* dst, size_t size, void* context);
+#endif
+static size_t read_from_file(uint8_t* dst, size_t size, void* context);
+
+/**
+ * Sinks of the writers created by pbb_create_fd_writer and pbb_create_file_writer.
  */
-static void ensure_capacity(partial_byte_buffer* pbb, uint8_t bits);
+#if PBB_HAVE_POSIX
+static int write_to_fd(const uint8_t* data, size_t size, void* context);
+#endif
+static int write_to_file(const uint8_t* data, size_t size, void* context);
 
 /**
  * Extend the sign bit of a 64-bit value from [bits] bits to a full 64-bit integer.
  */
 static void extend_sign(uint64_t* value, uint8_t bits);
 
+/**
+ * Read up to [count] fields of [bits] bits into [values], as pbb_read_int32_array and pbb_read_int64_array do,
+ * sign-extended unless [sign_extend] is 0.
+ */
+static size_t read_int32_array(partial_byte_buffer* pbbr, int32_t* values, size_t count, uint8_t bits, int sign_extend);
+static size_t read_int64_array(partial_byte_buffer* pbbr, int64_t* values, size_t count, uint8_t bits, int sign_extend);
+
+/**
+ * Write and read doubles resized to floats of [exp_bits] exponent bits, [mant_bits] mantissa bits
+ * and [sign_bits] (0 or 1) sign bit, as the pbb_*_double_as and pbb_*_unsigned_double_as functions do.
+ * Writes narrow the mantissa with [rounding].
+ */
+static void write_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits, flr_rounding rounding);
+static double read_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits);
+static size_t write_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits, flr_rounding rounding);
+static size_t read_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits);
+
+/**
+ * Choose the format of a column as flr_select_format and flr_select_format_nearest do, for values resized with [rounding].
+ */
+static int select_format(const double* samples, size_t count, double precision, int allow_unsigned, flr_rounding rounding, flr_format_spec* spec);
+
+/**
+ * Residual of [value] against the prediction of [coder], which then moves past [value].
+ * The first value of a channel is its own residual.
+ */
+static inline int64_t delta_residual(pbb_delta_coder* coder, int64_t value);
+
+/**
+ * Value of [residual] against the prediction of [coder], which then moves past it.
+ */
+static inline int64_t delta_value(pbb_delta_coder* coder, int64_t residual);
+
+/**
+ * Split the code of [residual] in a head of [head_bits] bits (the prefix, followed by the residual
+ * for every bucket but the last) and return the number of residual bits following it: 0 or 64.
+ */
+static inline uint8_t delta_code(int64_t residual, uint64_t* head, uint8_t* head_bits);
+
+/**
+ * Read the residual of the next delta code, or the 64 bits of the first value of a channel when [first].
+ * Returns 0 if the buffer runs out of bits, without consuming any of them.
+ */
+static int read_delta_residual(partial_byte_buffer* pbbr, int first, int64_t* residual);
+
+/**
+ * Pack the codes of [count] values (at most RESIZE_BLOCK_SIZE) into [staged], as 64-bit words
+ * holding the bits MSB-first. Returns the number of bits packed.
+ */
+static size_t stage_delta_codes(pbb_delta_coder* coder, const int64_t* values, size_t count, uint64_t* staged);
+
+/**
+ * Decode delta codes of a buffer in contiguous memory straight from it, while their windows stay
+ * inside its readable bytes. Returns the number of values decoded, up to [count].
+ */
+static size_t decode_delta_direct(partial_byte_buffer* pbbr, pbb_delta_coder* coder, int64_t* values, size_t count);
+
 partial_byte_buffer* pbb_create(int initial_capacity) {
     if (initial_capacity <= 0) return NULL;
     
-    partial_byte_buffer* pbb = (partial_byte_buffer*)malloc(sizeof(partial_byte_buffer));
-    if (pbb == NULL) return NULL;
-    
     /**
      * calloc initializes memory to zero, which is neccessary for bitwise operations.
      */
-    pbb->buffer = (uint8_t*)calloc(initial_capacity, 1);
-    if (pbb->buffer == NULL) {
-        free(pbb);
-        return NULL;
-    }
+    uint8_t* buffer = (uint8_t*)calloc(initial_capacity + BUFFER_PADDING, 1);
+    if (buffer == NULL) return NULL;
 
-    pbb->capacity = initial_capacity;
-    pbb->write_pos = 0;
-    pbb->read_pos = 0;
+    partial_byte_buffer* pbb = create_header(buffer, initial_capacity, PBB_STORAGE_OWNED);
+    if (pbb == NULL) free(buffer);
 
     return pbb;
 }
@@ -85,172 +387,809 @@ partial_byte_buffer* pbb_create(int initial_capacity) {
 partial_byte_buffer* pbb_from_array(const uint8_t* array, size_t size) {
     if (array == NULL || size == 0) return NULL;
     
-    partial_byte_buffer* pbb = (partial_byte_buffer*)malloc(sizeof(partial_byte_buffer));
-    if (pbb == NULL) return NULL;
+    uint8_t* buffer = (uint8_t*)malloc(size + BUFFER_PADDING);
+    if (buffer == NULL) return NULL;
     
-    pbb->buffer = (uint8_t*)malloc(size);
-    if (pbb->buffer == NULL) {
-        free(pbb);
+    memcpy(buffer, array, size);
+    memset(buffer + size, 0, BUFFER_PADDING);
+
+    partial_byte_buffer* pbb = create_header(buffer, size, PBB_STORAGE_OWNED);
+    if (pbb == NULL) {
+        free(buffer);
         return NULL;
     }
-    
-    memcpy(pbb->buffer, array, size);
-    pbb->capacity = size;
     pbb->write_pos = size * 8;
-    pbb->read_pos = 0;
     
     return pbb;
 }
 
-void pbb_destroy(partial_byte_buffer** pbb) {
-    if (*pbb != NULL && (*pbb)->buffer != NULL) free((*pbb)->buffer);
-    if (pbb != NULL) free(*pbb);
-    *pbb = NULL;
-}
+partial_byte_buffer* pbb_wrap_array(const uint8_t* array, size_t size) {
+    if (array == NULL || size == 0) return NULL;
 
-size_t pbb_get_length(const partial_byte_buffer* pbb) {
-    if (pbb == NULL) return 0;
-    return (pbb->write_pos + 7) >> 3;
+    /**
+     * The const qualifier is dropped to share the field with owned buffers.
+     * Writes never reach borrowed memory since ensure_capacity copies it first.
+     */
+    partial_byte_buffer* pbb = create_header((uint8_t*)array, size, PBB_STORAGE_BORROWED);
+    if (pbb == NULL) return NULL;
+    pbb->write_pos = size * 8;
+
+    return pbb;
 }
 
-void pbb_write_byte(partial_byte_buffer* pbb, int8_t byte, uint8_t bits) {
-    if (pbb == NULL || bits <= 0 || bits > 8) return;
+partial_byte_buffer* pbb_open_mmap(const char* path) {
+#if PBB_HAVE_POSIX
+    if (path == NULL) return NULL;
 
-    ensure_capacity(pbb, bits);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
 
-    uint8_t remaining_bits = bits;
-    while (remaining_bits > 0) {
-        write_byte(pbb, byte, &remaining_bits);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
     }
-}
-
-void pbb_write_int(partial_byte_buffer* pbb, int value, uint8_t bits) {
-    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT) return;
+    size_t size = (size_t)st.st_size;
 
-    ensure_capacity(pbb, bits);
-    
-    uint8_t remaining_bits = bits;
-    while (remaining_bits > 0) {
-        write_byte(pbb, value, &remaining_bits);
-    }
-}
+    // The mapping stays valid after the descriptor is closed
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
 
-int8_t pbb_read_byte(partial_byte_buffer* pbbr, uint8_t bits) {
-    if (pbbr == NULL || bits <= 0 || bits > 8) return 0;
-    if (required_length(pbbr, bits) > pbb_get_length(pbbr)) return 0;
+    // A hint only, and failures are harmless. Sequential access lets the kernel read ahead of the pages touched
+    // and drop those behind, without prefaulting the whole file, so resident memory follows what is read.
+    madvise(mapping, size, MADV_SEQUENTIAL);
 
-    uint64_t result = 0;
-    uint8_t remaining_bit_len = bits;
-    
-    while (remaining_bit_len > 0) {
-        read_byte(pbbr, &result, &remaining_bit_len);
+    partial_byte_buffer* pbb = create_header((uint8_t*)mapping, size, PBB_STORAGE_MAPPED);
+    if (pbb == NULL) {
+        munmap(mapping, size);
+        return NULL;
     }
+    pbb->write_pos = size * 8;
 
-    if (bits < 8) {
-        extend_sign(&result, bits);
-    }
-    
-    return (int8_t)result;
+    return pbb;
+#else
+    (void)path;
+    return NULL;
+#endif
 }
 
-int pbb_read_int(partial_byte_buffer* pbbr, uint8_t bits) {
-    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT) return 0;
-    if (required_length(pbbr, bits) > pbb_get_length(pbbr)) return 0;
+partial_byte_buffer* pbb_create_segmented(size_t segment_size) {
+    if (segment_size == 0 || segment_size > ((size_t)1 << MAX_SEGMENT_SHIFT)) return NULL;
 
-    uint64_t result = 0;
-    uint8_t remaining_bit_len = bits;
-    
-    while (remaining_bit_len > 0) {
-        read_byte(pbbr, &result, &remaining_bit_len);
-    }
+    uint8_t segment_shift = MIN_SEGMENT_SHIFT;
+    while (((size_t)1 << segment_shift) < segment_size) ++segment_shift;
 
-    // Sign extension for negative values
-    if (bits < BITSIZEOF_INT) {
-        extend_sign(&result, bits);
+    partial_byte_buffer* pbb = create_header(NULL, 0, PBB_STORAGE_SEGMENTED);
+    if (pbb == NULL) return NULL;
+    pbb->segment_shift = segment_shift;
+
+    if (!add_segment(pbb)) {
+        pbb_destroy(&pbb);
+        return NULL;
     }
-    
-    return (int) result;
+
+    return pbb;
 }
 
-void pbb_write_int32(partial_byte_buffer* pbb, int32_t value, uint8_t bits) {
-    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return;
+partial_byte_buffer* pbb_create_ring(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 3)) return NULL;
 
-    ensure_capacity(pbb, bits);
-    
-    uint8_t remaining_bits = bits;
-    while (remaining_bits > 0) {
-        write_byte(pbb, value, &remaining_bits);
-    }
-}
+    uint8_t* buffer = (uint8_t*)calloc(capacity + BUFFER_PADDING, 1);
+    if (buffer == NULL) return NULL;
 
-int32_t pbb_read_int32(partial_byte_buffer* pbbr, uint8_t bits) {
-    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return 0;
-    if (required_length(pbbr, bits) > pbb_get_length(pbbr)) return 0;
+    partial_byte_buffer* pbb = create_header(buffer, capacity, PBB_STORAGE_RING);
+    if (pbb == NULL) free(buffer);
 
-    uint64_t result = 0;
-    uint8_t remaining_bit_len = bits;
-    while (remaining_bit_len > 0) {
-        read_byte(pbbr, &result, &remaining_bit_len);
-    }
+    return pbb;
+}
 
-    // Sign extension for negative values
-    if (bits < BITSIZEOF_INT32) {
-        extend_sign(&result, bits);
-    }
-    
-    return (int32_t) result;
+size_t pbb_ring_free_bits(const partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->storage != PBB_STORAGE_RING) return 0;
+    return (pbb->capacity << 3) - pbb->ring_fill;
 }
 
-void pbb_write_float(partial_byte_buffer* pbb, float value) {
-    if (pbb == NULL) return;
-    
-    qword q;
-    q.float_val = value;
-    pbb_write_int32(pbb, q.int32_val, BITSIZEOF_FLOAT);
+size_t pbb_ring_used_bits(const partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->storage != PBB_STORAGE_RING) return 0;
+    return pbb->ring_fill;
 }
 
-float pbb_read_float(partial_byte_buffer* pbbr) {
-    if (pbbr == NULL) return 0.0f;
-    
-    qword q;
-    q.int32_val = pbb_read_int32(pbbr, BITSIZEOF_FLOAT);
-    return q.float_val;
+int pbb_ring_is_full(const partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->storage != PBB_STORAGE_RING) return 0;
+    return pbb->ring_fill == pbb->capacity << 3;
 }
 
-void pbb_write_int64(partial_byte_buffer* pbb, int64_t value, uint8_t bits) {
-    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return;
+int pbb_ring_is_empty(const partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->storage != PBB_STORAGE_RING) return 0;
+    return pbb->ring_fill == 0;
+}
 
-    ensure_capacity(pbb, bits);
-    
-    uint8_t remaining_bits = bits;
-    while (remaining_bits > 0) {
-        write_byte(pbb, value, &remaining_bits);
+size_t pbb_ring_write(partial_byte_buffer* pbb, const uint8_t* src, size_t bits) {
+    if (pbb == NULL || src == NULL || pbb->storage != PBB_STORAGE_RING) return 0;
+
+    bits = MIN(bits, pbb_ring_free_bits(pbb));
+    size_t whole_bytes = bits >> 3;
+    for (size_t i = 0; i < whole_bytes; ++i) {
+        write_bits(pbb, src[i], 8);
     }
+
+    // The bits of a last partial byte are its most significant ones
+    uint8_t remaining = bits & 7;
+    if (remaining > 0) {
+        write_bits(pbb, src[whole_bytes] >> (8 - remaining), remaining);
+    }
+
+    return bits;
 }
 
-int64_t pbb_read_int64(partial_byte_buffer* pbbr, uint8_t bits) {
-    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return 0;
-    if (required_length(pbbr, bits) > pbb_get_length(pbbr)) return 0;
+size_t pbb_ring_read(partial_byte_buffer* pbbr, uint8_t* dst, size_t bits) {
+    if (pbbr == NULL || dst == NULL || pbbr->storage != PBB_STORAGE_RING) return 0;
 
-    uint64_t result = 0;
-    uint8_t remaining_bit_len = bits;
-    
-    while (remaining_bit_len > 0) {
-        read_byte(pbbr, &result, &remaining_bit_len);
+    bits = MIN(bits, pbbr->ring_fill);
+    size_t whole_bytes = bits >> 3;
+    for (size_t i = 0; i < whole_bytes; ++i) {
+        dst[i] = (uint8_t)read_bits(pbbr, 8);
     }
 
-    // Sign extension for negative values
-    if (bits < BITSIZEOF_INT64) {
-        extend_sign(&result, bits);
+    uint8_t remaining = bits & 7;
+    if (remaining > 0) {
+        dst[whole_bytes] = (uint8_t)(read_bits(pbbr, remaining) << (8 - remaining));
     }
-    
-    return (int64_t) result;
+
+    return bits;
 }
 
-uint64_t flr_resize_float_long(
-    uint64_t src, 
-    int src_exp_bits, int src_mant_bits,
-    int dst_exp_bits, int dst_mant_bits
+partial_byte_buffer* pbb_create_writer(size_t watermark, pbb_sink_fn sink, void* context) {
+    if (watermark == 0 || watermark > INT32_MAX / 2 || sink == NULL) return NULL;
+
+    // Room for the pending bytes and a 64-bit field, so that most writes never grow the buffer
+    partial_byte_buffer* pbb = pbb_create((int)watermark + (int)sizeof(uint64_t) + 1);
+    if (pbb == NULL) return NULL;
+
+    pbb->sink = sink;
+    pbb->sink_context = context;
+    pbb->watermark = watermark;
+
+    return pbb;
+}
+
+partial_byte_buffer* pbb_create_fd_writer(int fd, size_t watermark) {
+#if PBB_HAVE_POSIX
+    if (fd < 0) return NULL;
+    return pbb_create_writer(watermark, write_to_fd, (void*)(intptr_t)fd);
+#else
+    (void)fd;
+    (void)watermark;
+    return NULL;
+#endif
+}
+
+partial_byte_buffer* pbb_create_file_writer(FILE* file, size_t watermark) {
+    if (file == NULL) return NULL;
+    return pbb_create_writer(watermark, write_to_file, file);
+}
+
+int pbb_flush(partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->sink == NULL) return 0;
+    return drain_to_sink(pbb);
+}
+
+int pbb_finish(partial_byte_buffer* pbb) {
+    if (pbb == NULL || pbb->sink == NULL) return 0;
+
+    // The padding bits are already zero
+    pbb->write_pos = (pbb->write_pos + 7) & ~(size_t)7;
+    return drain_to_sink(pbb);
+}
+
+partial_byte_buffer* pbb_create_reader(size_t window, pbb_source_fn source, void* context) {
+    if (window > INT32_MAX || source == NULL) return NULL;
+
+    partial_byte_buffer* pbb = pbb_create((int)MAX(window, MIN_READER_WINDOW));
+    if (pbb == NULL) return NULL;
+
+    pbb->source = source;
+    pbb->source_context = context;
+
+    return pbb;
+}
+
+partial_byte_buffer* pbb_create_fd_reader(int fd, size_t window) {
+#if PBB_HAVE_POSIX
+    if (fd < 0) return NULL;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return pbb_create_reader(window, read_from_fd, (void*)(intptr_t)fd);
+#else
+    (void)fd;
+    (void)window;
+    return NULL;
+#endif
+}
+
+partial_byte_buffer* pbb_create_file_reader(FILE* file, size_t window) {
+    if (file == NULL) return NULL;
+    return pbb_create_reader(window, read_from_file, file);
+}
+
+size_t pbb_export(const partial_byte_buffer* pbb, uint8_t* dst, size_t size) {
+    if (pbb == NULL || dst == NULL) return 0;
+
+    size = MIN(size, pbb_get_length(pbb));
+    if (pbb->storage == PBB_STORAGE_SEGMENTED) {
+        gather_bytes(pbb, 0, dst, size);
+    } else if (pbb->storage == PBB_STORAGE_RING) {
+        gather_bytes(pbb, pbb->read_pos >> 3, dst, size);
+    } else {
+        memcpy(dst, pbb->buffer, size);
+    }
+
+    return size;
+}
+
+int pbb_flatten(partial_byte_buffer* pbb) {
+    if (pbb == NULL) return 0;
+    if (pbb->storage != PBB_STORAGE_SEGMENTED) return 1;
+
+    uint8_t* buffer = (uint8_t*)calloc(pbb->capacity + BUFFER_PADDING, 1);
+    if (buffer == NULL) return 0;
+
+    // Bytes past the written length are zero in both storages
+    gather_bytes(pbb, 0, buffer, pbb_get_length(pbb));
+    release_storage(pbb);
+
+    pbb->buffer = buffer;
+    pbb->storage = PBB_STORAGE_OWNED;
+    pbb->segments = NULL;
+    pbb->segment_count = 0;
+    pbb->segment_shift = 0;
+
+    return 1;
+}
+
+size_t pbb_to_iovec(const partial_byte_buffer* pbb, struct iovec* iov, size_t iov_count) {
+#if PBB_HAVE_POSIX
+    if (pbb == NULL) return 0;
+    return fill_iovec(pbb, 0, iov, iov == NULL ? 0 : iov_count, 0);
+#else
+    (void)pbb;
+    (void)iov;
+    (void)iov_count;
+    return 0;
+#endif
+}
+
+int pbb_writev(const partial_byte_buffer* pbb, int fd) {
+#if PBB_HAVE_POSIX
+    if (pbb == NULL || fd < 0) return 0;
+
+    size_t length = pbb_get_length(pbb);
+    size_t offset = 0;
+    struct iovec batch[IOVEC_BATCH];
+
+    while (offset < length) {
+        int count = (int)fill_iovec(pbb, offset, batch, IOVEC_BATCH, 1);
+        ssize_t written = writev(fd, batch, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        offset += (size_t)written;
+    }
+
+    return 1;
+#else
+    (void)pbb;
+    (void)fd;
+    return 0;
+#endif
+}
+
+int pbb_set_growth_policy(partial_byte_buffer* pbb, const pbb_growth_policy* policy) {
+    if (pbb == NULL || policy == NULL) return 0;
+
+    switch (policy->mode) {
+    case PBB_GROWTH_DOUBLE:
+    case PBB_GROWTH_HALF:
+        break;
+    case PBB_GROWTH_FIXED:
+        if (policy->increment == 0) return 0;
+        break;
+    case PBB_GROWTH_CALLBACK:
+        if (policy->callback == NULL) return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    pbb->growth = *policy;
+    return 1;
+}
+
+int pbb_reserve(partial_byte_buffer* pbb, size_t bits) {
+    if (pbb == NULL) return 0;
+    if (pbb->storage == PBB_STORAGE_RING) return bits <= pbb_ring_free_bits(pbb);
+
+    size_t required_bytes = (pbb->write_pos + bits + 7) >> 3;
+    int writable = pbb->storage == PBB_STORAGE_OWNED || pbb->storage == PBB_STORAGE_SEGMENTED;
+    if (required_bytes <= pbb->capacity && writable) return 1;
+    if (pbb->growth.max_capacity != 0 && required_bytes > pbb->growth.max_capacity) return 0;
+
+    // Borrowed and mapped memory is copied now, even when large enough, rather than by the next write
+    return resize_storage(pbb, MAX(required_bytes, pbb->capacity));
+}
+
+void pbb_destroy(partial_byte_buffer** pbb) {
+    if (*pbb != NULL) release_storage(*pbb);
+    if (pbb != NULL) free(*pbb);
+    *pbb = NULL;
+}
+
+size_t pbb_get_length(const partial_byte_buffer* pbb) {
+    if (pbb == NULL) return 0;
+    if (pbb->storage == PBB_STORAGE_RING) return ((pbb->read_pos & 7) + pbb->ring_fill + 7) >> 3;
+    return (pbb->write_pos + 7) >> 3;
+}
+
+void pbb_write_byte(partial_byte_buffer* pbb, int8_t byte, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > 8) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, byte, bits);
+}
+
+void pbb_write_int(partial_byte_buffer* pbb, int value, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, value, bits);
+}
+
+int8_t pbb_read_byte(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > 8) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    uint64_t result = read_bits(pbbr, bits);
+
+    if (bits < 8) {
+        extend_sign(&result, bits);
+    }
+    
+    return (int8_t)result;
+}
+
+int pbb_read_int(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    uint64_t result = read_bits(pbbr, bits);
+
+    // Sign extension for negative values
+    if (bits < BITSIZEOF_INT) {
+        extend_sign(&result, bits);
+    }
+    
+    return (int) result;
+}
+
+void pbb_write_int32(partial_byte_buffer* pbb, int32_t value, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, value, bits);
+}
+
+int32_t pbb_read_int32(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    uint64_t result = read_bits(pbbr, bits);
+
+    // Sign extension for negative values
+    if (bits < BITSIZEOF_INT32) {
+        extend_sign(&result, bits);
+    }
+    
+    return (int32_t) result;
+}
+
+void pbb_write_uint32(partial_byte_buffer* pbb, uint32_t value, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, value, bits);
+}
+
+uint32_t pbb_read_uint32(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    return (uint32_t)read_bits(pbbr, bits);
+}
+
+void pbb_write_float(partial_byte_buffer* pbb, float value) {
+    if (pbb == NULL) return;
+    
+    qword q;
+    q.float_val = value;
+    pbb_write_int32(pbb, q.int32_val, BITSIZEOF_FLOAT);
+}
+
+float pbb_read_float(partial_byte_buffer* pbbr) {
+    if (pbbr == NULL) return 0.0f;
+    
+    qword q;
+    q.int32_val = pbb_read_int32(pbbr, BITSIZEOF_FLOAT);
+    return q.float_val;
+}
+
+void pbb_write_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits) {
+    write_double_as(pbb, value, exp_bits, mant_bits, 1, FLR_ROUND_TRUNCATE);
+}
+
+double pbb_read_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits) {
+    return read_double_as(pbbr, exp_bits, mant_bits, 1);
+}
+
+size_t pbb_write_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return write_double_array_as(pbb, values, count, exp_bits, mant_bits, 1, FLR_ROUND_TRUNCATE);
+}
+
+size_t pbb_read_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return read_double_array_as(pbbr, values, count, exp_bits, mant_bits, 1);
+}
+
+void pbb_write_double_nearest_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits) {
+    write_double_as(pbb, value, exp_bits, mant_bits, 1, FLR_ROUND_NEAREST_EVEN);
+}
+
+size_t pbb_write_double_array_nearest_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return write_double_array_as(pbb, values, count, exp_bits, mant_bits, 1, FLR_ROUND_NEAREST_EVEN);
+}
+
+void pbb_write_unsigned_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits) {
+    write_double_as(pbb, value, exp_bits, mant_bits, 0, FLR_ROUND_TRUNCATE);
+}
+
+double pbb_read_unsigned_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits) {
+    return read_double_as(pbbr, exp_bits, mant_bits, 0);
+}
+
+size_t pbb_write_unsigned_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return write_double_array_as(pbb, values, count, exp_bits, mant_bits, 0, FLR_ROUND_TRUNCATE);
+}
+
+size_t pbb_read_unsigned_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return read_double_array_as(pbbr, values, count, exp_bits, mant_bits, 0);
+}
+
+void pbb_write_unsigned_double_nearest_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits) {
+    write_double_as(pbb, value, exp_bits, mant_bits, 0, FLR_ROUND_NEAREST_EVEN);
+}
+
+size_t pbb_write_unsigned_double_array_nearest_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits) {
+    return write_double_array_as(pbb, values, count, exp_bits, mant_bits, 0, FLR_ROUND_NEAREST_EVEN);
+}
+
+size_t pbb_read_double_array_table(partial_byte_buffer* pbbr, const flr_decode_table* table, double* values, size_t count) {
+    if (pbbr == NULL || table == NULL || values == NULL) return 0;
+
+    uint32_t block[RESIZE_BLOCK_SIZE];
+    size_t done = 0;
+
+    // Codes fit in 32 bits, so they go through the narrower packing kernels, without sign extension
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        size_t read = pbb_read_uint32_array(pbbr, block, chunk, table->bits);
+        for (size_t i = 0; i < read; ++i) {
+            values[done + i] = table->values[block[i]];
+        }
+
+        done += read;
+        if (read < chunk) break;
+    }
+
+    return done;
+}
+
+void pbb_write_double_fixed(partial_byte_buffer* pbb, const fxp_format* format, double value) {
+    if (pbb == NULL || format == NULL || !ensure_capacity(pbb, format->bits)) return;
+    write_bits(pbb, quantize_value(format, value), format->bits);
+}
+
+double pbb_read_double_fixed(partial_byte_buffer* pbbr, const fxp_format* format) {
+    if (pbbr == NULL || format == NULL || !ensure_readable(pbbr, format->bits)) return 0.0;
+    return dequantize_value(format, read_bits(pbbr, format->bits));
+}
+
+size_t pbb_write_double_array_fixed(partial_byte_buffer* pbb, const fxp_format* format, const double* values, size_t count) {
+    if (pbb == NULL || format == NULL || values == NULL) return 0;
+
+    uint64_t block[RESIZE_BLOCK_SIZE];
+    size_t done = 0;
+
+    // Codes have no bit above format->bits, as the packing kernels require
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        pbb_kernels->quantize(format, values + done, block, chunk);
+
+        size_t written = pbb_write_uint64_array(pbb, block, chunk, format->bits);
+        done += written;
+        if (written < chunk) break;
+    }
+
+    return done;
+}
+
+size_t pbb_read_double_array_fixed(partial_byte_buffer* pbbr, const fxp_format* format, double* values, size_t count) {
+    if (pbbr == NULL || format == NULL || values == NULL) return 0;
+
+    uint64_t block[RESIZE_BLOCK_SIZE];
+    size_t done = 0;
+
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        size_t read = pbb_read_uint64_array(pbbr, block, chunk, format->bits);
+        pbb_kernels->dequantize(format, block, values + done, read);
+
+        done += read;
+        if (read < chunk) break;
+    }
+
+    return done;
+}
+
+void pbb_write_int64(partial_byte_buffer* pbb, int64_t value, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, value, bits);
+}
+
+int64_t pbb_read_int64(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    uint64_t result = read_bits(pbbr, bits);
+
+    // Sign extension for negative values
+    if (bits < BITSIZEOF_INT64) {
+        extend_sign(&result, bits);
+    }
+    
+    return (int64_t) result;
+}
+
+void pbb_write_uint64(partial_byte_buffer* pbb, uint64_t value, uint8_t bits) {
+    if (pbb == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return;
+
+    if (!ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, value, bits);
+}
+
+uint64_t pbb_read_uint64(partial_byte_buffer* pbbr, uint8_t bits) {
+    if (pbbr == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return 0;
+    if (!ensure_readable(pbbr, bits)) return 0;
+
+    return read_bits(pbbr, bits);
+}
+
+size_t pbb_write_int32_array(partial_byte_buffer* pbb, const int32_t* values, size_t count, uint8_t bits) {
+    if (pbb == NULL || values == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return 0;
+
+    /**
+     * A ring takes the values that fit. They are written one by one since the packing kernels
+     * store whole words, which could overwrite unread bits following the free space.
+     */
+    if (pbb->storage == PBB_STORAGE_RING) {
+        count = MIN(count, pbb_ring_free_bits(pbb) / bits);
+        for (size_t i = 0; i < count; ++i) {
+            write_bits(pbb, (uint64_t)values[i], bits);
+        }
+        return count;
+    }
+
+    // A streaming writer packs the array in runs flushed in between, keeping memory around [watermark] bytes
+    if (pbb->sink != NULL) {
+        for (size_t i = 0; i < count;) {
+            size_t run = writer_run(pbb, count - i, bits);
+            if (!ensure_capacity(pbb, run * bits)) return i;
+            pbb_kernels->pack_int32(pbb->buffer + (pbb->write_pos >> 3), pbb->write_pos & 7, values + i, run, bits);
+            pbb->write_pos += run * bits;
+            i += run;
+        }
+        return count;
+    }
+
+    if (!ensure_capacity(pbb, count * bits)) return 0;
+
+    if (pbb->storage != PBB_STORAGE_SEGMENTED) {
+        pbb_kernels->pack_int32(pbb->buffer + (pbb->write_pos >> 3), pbb->write_pos & 7, values, count, bits);
+        pbb->write_pos += count * bits;
+        return count;
+    }
+
+    // Pack the values of each segment in one go, and the value crossing into the next one alone
+    for (size_t i = 0; i < count;) {
+        size_t run = segment_run(pbb, pbb->write_pos, count - i, bits);
+        if (run == 0) {
+            write_bits(pbb, (uint64_t)values[i++], bits);
+            continue;
+        }
+        pbb_kernels->pack_int32(segment_byte(pbb, pbb->write_pos >> 3), pbb->write_pos & 7, values + i, run, bits);
+        pbb->write_pos += run * bits;
+        i += run;
+    }
+
+    return count;
+}
+
+size_t pbb_write_int64_array(partial_byte_buffer* pbb, const int64_t* values, size_t count, uint8_t bits) {
+    if (pbb == NULL || values == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return 0;
+
+    /**
+     * A ring takes the values that fit. They are written one by one since the packing kernels
+     * store whole words, which could overwrite unread bits following the free space.
+     */
+    if (pbb->storage == PBB_STORAGE_RING) {
+        count = MIN(count, pbb_ring_free_bits(pbb) / bits);
+        for (size_t i = 0; i < count; ++i) {
+            write_bits(pbb, (uint64_t)values[i], bits);
+        }
+        return count;
+    }
+
+    // A streaming writer packs the array in runs flushed in between, keeping memory around [watermark] bytes
+    if (pbb->sink != NULL) {
+        for (size_t i = 0; i < count;) {
+            size_t run = writer_run(pbb, count - i, bits);
+            if (!ensure_capacity(pbb, run * bits)) return i;
+            pbb_kernels->pack_int64(pbb->buffer + (pbb->write_pos >> 3), pbb->write_pos & 7, values + i, run, bits);
+            pbb->write_pos += run * bits;
+            i += run;
+        }
+        return count;
+    }
+
+    if (!ensure_capacity(pbb, count * bits)) return 0;
+
+    if (pbb->storage != PBB_STORAGE_SEGMENTED) {
+        pbb_kernels->pack_int64(pbb->buffer + (pbb->write_pos >> 3), pbb->write_pos & 7, values, count, bits);
+        pbb->write_pos += count * bits;
+        return count;
+    }
+
+    // Pack the values of each segment in one go, and the value crossing into the next one alone
+    for (size_t i = 0; i < count;) {
+        size_t run = segment_run(pbb, pbb->write_pos, count - i, bits);
+        if (run == 0) {
+            write_bits(pbb, (uint64_t)values[i++], bits);
+            continue;
+        }
+        pbb_kernels->pack_int64(segment_byte(pbb, pbb->write_pos >> 3), pbb->write_pos & 7, values + i, run, bits);
+        pbb->write_pos += run * bits;
+        i += run;
+    }
+
+    return count;
+}
+
+size_t pbb_write_uint32_array(partial_byte_buffer* pbb, const uint32_t* values, size_t count, uint8_t bits) {
+    return pbb_write_int32_array(pbb, (const int32_t*)values, count, bits);
+}
+
+size_t pbb_write_uint64_array(partial_byte_buffer* pbb, const uint64_t* values, size_t count, uint8_t bits) {
+    return pbb_write_int64_array(pbb, (const int64_t*)values, count, bits);
+}
+
+size_t pbb_read_int32_array(partial_byte_buffer* pbbr, int32_t* values, size_t count, uint8_t bits) {
+    return read_int32_array(pbbr, values, count, bits, 1);
+}
+
+size_t pbb_read_uint32_array(partial_byte_buffer* pbbr, uint32_t* values, size_t count, uint8_t bits) {
+    return read_int32_array(pbbr, (int32_t*)values, count, bits, 0);
+}
+
+size_t pbb_read_int64_array(partial_byte_buffer* pbbr, int64_t* values, size_t count, uint8_t bits) {
+    return read_int64_array(pbbr, values, count, bits, 1);
+}
+
+size_t pbb_read_uint64_array(partial_byte_buffer* pbbr, uint64_t* values, size_t count, uint8_t bits) {
+    return read_int64_array(pbbr, (int64_t*)values, count, bits, 0);
+}
+
+void pbb_delta_coder_init(pbb_delta_coder* coder, pbb_delta_order order) {
+    if (coder == NULL) return;
+
+    coder->order = order;
+    coder->count = 0;
+    coder->previous = 0;
+    coder->previous_delta = 0;
+}
+
+int pbb_write_delta(partial_byte_buffer* pbb, pbb_delta_coder* coder, int64_t value) {
+    if (pbb == NULL || coder == NULL) return 0;
+
+    pbb_delta_coder next = *coder;
+    int64_t residual = delta_residual(&next, value);
+    uint64_t head = 0;
+    uint8_t head_bits = 0;
+    uint8_t tail_bits = coder->count == 0 ? 64 : delta_code(residual, &head, &head_bits);
+
+    if (!ensure_capacity(pbb, head_bits + tail_bits)) return 0;
+    if (head_bits > 0) write_bits(pbb, head, head_bits);
+    if (tail_bits > 0) write_bits(pbb, (uint64_t)residual, tail_bits);
+
+    *coder = next;
+    return 1;
+}
+
+int64_t pbb_read_delta(partial_byte_buffer* pbbr, pbb_delta_coder* coder) {
+    int64_t residual;
+    if (pbbr == NULL || coder == NULL || !read_delta_residual(pbbr, coder->count == 0, &residual)) return 0;
+    return delta_value(coder, residual);
+}
+
+size_t pbb_write_delta_array(partial_byte_buffer* pbb, pbb_delta_coder* coder, const int64_t* values, size_t count) {
+    if (pbb == NULL || coder == NULL || values == NULL) return 0;
+
+    uint64_t staged[(RESIZE_BLOCK_SIZE * DELTA_CODE_MAX_BITS + 63) / 64 + 1];
+    size_t done = 0;
+
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        pbb_delta_coder next = *coder;
+        size_t bits = stage_delta_codes(&next, values + done, chunk, staged);
+
+        // A block that does not fit is written value by value, up to the last code the buffer takes
+        if (!ensure_capacity(pbb, bits)) {
+            while (done < count && pbb_write_delta(pbb, coder, values[done])) ++done;
+            break;
+        }
+
+        size_t words = bits >> 6;
+        pbb_write_uint64_array(pbb, staged, words, 64);
+        if ((bits & 63) != 0) {
+            pbb_write_uint64(pbb, staged[words] >> (64 - (bits & 63)), bits & 63);
+        }
+
+        *coder = next;
+        done += chunk;
+    }
+
+    return done;
+}
+
+size_t pbb_read_delta_array(partial_byte_buffer* pbbr, pbb_delta_coder* coder, int64_t* values, size_t count) {
+    if (pbbr == NULL || coder == NULL || values == NULL) return 0;
+
+    size_t done = 0;
+    int64_t residual;
+
+    // The first value of a channel is a plain 64-bit field
+    if (count > 0 && coder->count == 0) {
+        if (!read_delta_residual(pbbr, 1, &residual)) return 0;
+        values[done++] = delta_value(coder, residual);
+    }
+
+    int direct = pbbr->source == NULL && pbbr->storage != PBB_STORAGE_SEGMENTED && pbbr->storage != PBB_STORAGE_RING;
+    if (direct) {
+        done += decode_delta_direct(pbbr, coder, values + done, count - done);
+    }
+
+    // Segmented, ring and streaming buffers, and the last codes of the others, are read code by code
+    while (done < count && read_delta_residual(pbbr, 0, &residual)) {
+        values[done++] = delta_value(coder, residual);
+    }
+
+    return done;
+}
+
+uint64_t flr_resize_float_long(
+    uint64_t src, 
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
 ) {
     uint64_t dst_exp_mask = ((uint64_t)1 << dst_exp_bits) - 1;
     uint64_t dst_bias = dst_exp_mask >> 1;
@@ -276,100 +1215,709 @@ uint64_t flr_resize_float_long(
             dst_exponent = (src_exponent - src_bias + dst_bias) & dst_exp_mask;
         }
     }
-    
-    /*
-    * Resize mantissa
-    */ 
-    uint64_t src_mant_mask = ((uint64_t)1 << src_mant_bits) - 1;
-    uint64_t dst_mant_mask = ((uint64_t)1 << dst_mant_bits) - 1;
-    int mant_bits_diff = dst_mant_bits - src_mant_bits;
-    int mant_shift_left = mant_bits_diff > 0 ? mant_bits_diff : 0;
-    int mant_shift_right = - mant_bits_diff > 0 ? - mant_bits_diff : 0;
-    uint64_t dst_mant = ((src & src_mant_mask) << mant_shift_left >> mant_shift_right) & dst_mant_mask;
-    
-    /*
-    * Combine sign, exponent, and mantissa
-    */ 
-    uint64_t dst_sign = (src >> (src_exp_bits + src_mant_bits)) & 1;
-    return (((dst_sign << dst_exp_bits) | dst_exponent) << dst_mant_bits) | dst_mant;
+    
+    /*
+    * Resize mantissa
+    */ 
+    uint64_t src_mant_mask = ((uint64_t)1 << src_mant_bits) - 1;
+    uint64_t dst_mant_mask = ((uint64_t)1 << dst_mant_bits) - 1;
+    int mant_bits_diff = dst_mant_bits - src_mant_bits;
+    int mant_shift_left = mant_bits_diff > 0 ? mant_bits_diff : 0;
+    int mant_shift_right = - mant_bits_diff > 0 ? - mant_bits_diff : 0;
+    uint64_t dst_mant = ((src & src_mant_mask) << mant_shift_left >> mant_shift_right) & dst_mant_mask;
+    
+    /*
+    * Combine sign, exponent, and mantissa
+    */ 
+    uint64_t dst_sign = (src >> (src_exp_bits + src_mant_bits)) & 1;
+    return (((dst_sign << dst_exp_bits) | dst_exponent) << dst_mant_bits) | dst_mant;
+}
+
+uint64_t flr_resize_float_double(
+    double src, 
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    qword wq;
+    wq.double_val = src;
+    return flr_resize_float_long(wq.uint64_val, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+}
+
+uint64_t flr_resize_float_long_nearest(
+    uint64_t src,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    flr_format format;
+    flr_format_init(&format, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+    flr_format_set_rounding(&format, FLR_ROUND_NEAREST_EVEN);
+    return flr_resize(&format, src);
+}
+
+uint64_t flr_resize_float_double_nearest(
+    double src,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    qword wq;
+    wq.double_val = src;
+    return flr_resize_float_long_nearest(wq.uint64_val, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+}
+
+uint64_t flr_resize_double(const flr_format* format, double src) {
+    qword wq;
+    wq.double_val = src;
+    return flr_resize(format, wq.uint64_val);
+}
+
+void flr_resize_array(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count) {
+    if (format == NULL || src == NULL || dst == NULL) return;
+    pbb_kernels->resize_float(format, src, dst, count);
+}
+
+void flr_resize_array_double(const flr_format* format, const double* src, uint64_t* dst, size_t count) {
+    if (format == NULL || src == NULL || dst == NULL) return;
+
+    // The kernels load the values bytewise or with vector loads, which may alias doubles
+    pbb_kernels->resize_float(format, (const uint64_t*)(const void*)src, dst, count);
+}
+
+void flr_resize_long_array(
+    const uint64_t* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    if (src == NULL || dst == NULL) return;
+
+    flr_format format;
+    flr_format_init(&format, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+    flr_resize_array(&format, src, dst, count);
+}
+
+void flr_resize_double_array(
+    const double* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    if (src == NULL || dst == NULL) return;
+
+    flr_format format;
+    flr_format_init(&format, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+    flr_resize_array_double(&format, src, dst, count);
+}
+
+void flr_resize_long_array_nearest(
+    const uint64_t* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    if (src == NULL || dst == NULL) return;
+
+    flr_format format;
+    flr_format_init(&format, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+    flr_format_set_rounding(&format, FLR_ROUND_NEAREST_EVEN);
+    flr_resize_array(&format, src, dst, count);
+}
+
+void flr_resize_double_array_nearest(
+    const double* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    if (src == NULL || dst == NULL) return;
+
+    flr_format format;
+    flr_format_init(&format, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+    flr_format_set_rounding(&format, FLR_ROUND_NEAREST_EVEN);
+    flr_resize_array_double(&format, src, dst, count);
+}
+
+int flr_select_format(const double* samples, size_t count, double precision, int allow_unsigned, flr_format_spec* spec) {
+    return select_format(samples, count, precision, allow_unsigned, FLR_ROUND_TRUNCATE, spec);
+}
+
+int flr_select_format_decimals(const double* samples, size_t count, int decimals, int allow_unsigned, flr_format_spec* spec) {
+    return flr_select_format(samples, count, 0.5 * pow(10.0, -decimals), allow_unsigned, spec);
+}
+
+int flr_select_format_nearest(const double* samples, size_t count, double precision, int allow_unsigned, flr_format_spec* spec) {
+    return select_format(samples, count, precision, allow_unsigned, FLR_ROUND_NEAREST_EVEN, spec);
+}
+
+int flr_select_format_decimals_nearest(const double* samples, size_t count, int decimals, int allow_unsigned, flr_format_spec* spec) {
+    return flr_select_format_nearest(samples, count, 0.5 * pow(10.0, -decimals), allow_unsigned, spec);
+}
+
+uint16_t flr_float_to_half(float src) {
+    qword q;
+    q.float_val = src;
+    return float_bits_to_half(q.uint32_val);
+}
+
+float flr_half_to_float(uint16_t src) {
+    qword q;
+    q.uint32_val = half_to_float_bits(src);
+    return q.float_val;
+}
+
+uint16_t flr_float_to_bfloat16(float src) {
+    qword q;
+    q.float_val = src;
+    return float_bits_to_bfloat16(q.uint32_val);
+}
+
+float flr_bfloat16_to_float(uint16_t src) {
+    qword q;
+    q.uint32_val = bfloat16_to_float_bits(src);
+    return q.float_val;
+}
+
+void flr_float_to_half_array(const float* src, uint16_t* dst, size_t count) {
+    if (src == NULL || dst == NULL) return;
+    pbb_kernels->float_to_half(src, dst, count);
+}
+
+void flr_half_to_float_array(const uint16_t* src, float* dst, size_t count) {
+    if (src == NULL || dst == NULL) return;
+    pbb_kernels->half_to_float(src, dst, count);
+}
+
+void flr_float_to_bfloat16_array(const float* src, uint16_t* dst, size_t count) {
+    if (src == NULL || dst == NULL) return;
+    pbb_kernels->float_to_bfloat16(src, dst, count);
+}
+
+void flr_bfloat16_to_float_array(const uint16_t* src, float* dst, size_t count) {
+    if (src == NULL || dst == NULL) return;
+    pbb_kernels->bfloat16_to_float(src, dst, count);
+}
+
+flr_decode_table* flr_decode_table_create(int exp_bits, int mant_bits) {
+    flr_format format;
+    if (!flr_format_init(&format, exp_bits, mant_bits, DOUBLE_EXP_BITS, DOUBLE_MANT_BITS)) return NULL;
+    if (1 + exp_bits + mant_bits > FLR_DECODE_TABLE_MAX_BITS) return NULL;
+
+    flr_decode_table* table = (flr_decode_table*)malloc(sizeof(flr_decode_table));
+    if (table == NULL) return NULL;
+
+    table->bits = (uint8_t)(1 + exp_bits + mant_bits);
+
+    size_t size = (size_t)1 << table->bits;
+    table->values = (double*)malloc(size * sizeof(double));
+    if (table->values == NULL) {
+        free(table);
+        return NULL;
+    }
+
+    for (size_t code = 0; code < size; ++code) {
+        qword q;
+        q.uint64_val = flr_resize(&format, code);
+        table->values[code] = q.double_val;
+    }
+
+    return table;
+}
+
+double flr_decode(const flr_decode_table* table, uint64_t src) {
+    if (table == NULL) return 0.0;
+    return table->values[src & (((uint64_t)1 << table->bits) - 1)];
+}
+
+void flr_decode_array(const flr_decode_table* table, const uint64_t* src, double* dst, size_t count) {
+    if (table == NULL || src == NULL || dst == NULL) return;
+
+    uint64_t code_mask = ((uint64_t)1 << table->bits) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = table->values[src[i] & code_mask];
+    }
+}
+
+void flr_decode_table_destroy(flr_decode_table** table) {
+    if (*table != NULL) {
+        free((*table)->values);
+        free(*table);
+    }
+
+    *table = NULL;
+}
+
+int fxp_format_init(fxp_format* format, double min, double max, double step) {
+    if (format == NULL || !isfinite(min) || !isfinite(max) || !(step > 0.0) || !(max >= min)) return 0;
+
+    double scale = 1.0 / step;
+    double codes = (max - min) * scale;
+    if (!(codes <= FXP_MAGIC - 1)) return 0;
+
+    // Rounded as quantize_value does, so that [max] gets the largest code
+    uint64_t max_code = (uint64_t)nearbyint(codes);
+    uint8_t bits = 1;
+    while ((max_code >> bits) != 0) ++bits;
+
+    format->min = min;
+    format->step = step;
+    format->scale = scale;
+    format->max_code = max_code;
+    format->code_limit = (double)max_code;
+    format->bits = bits;
+    format->code_mask = ((uint64_t)1 << bits) - 1;
+
+    return 1;
+}
+
+uint64_t fxp_quantize(const fxp_format* format, double value) {
+    if (format == NULL) return 0;
+    return quantize_value(format, value);
+}
+
+double fxp_dequantize(const fxp_format* format, uint64_t code) {
+    if (format == NULL) return 0.0;
+    return dequantize_value(format, code);
+}
+
+void fxp_quantize_array(const fxp_format* format, const double* src, uint64_t* dst, size_t count) {
+    if (format == NULL || src == NULL || dst == NULL) return;
+    pbb_kernels->quantize(format, src, dst, count);
+}
+
+void fxp_dequantize_array(const fxp_format* format, const uint64_t* src, double* dst, size_t count) {
+    if (format == NULL || src == NULL || dst == NULL) return;
+    pbb_kernels->dequantize(format, src, dst, count);
+}
+
+static partial_byte_buffer* create_header(uint8_t* buffer, size_t capacity, pbb_storage storage) {
+    partial_byte_buffer* pbb = (partial_byte_buffer*)malloc(sizeof(partial_byte_buffer));
+    if (pbb == NULL) return NULL;
+
+    pbb->buffer = buffer;
+    pbb->capacity = capacity;
+    pbb->write_pos = 0;
+    pbb->read_pos = 0;
+    pbb->storage = storage;
+    pbb->segments = NULL;
+    pbb->segment_count = 0;
+    pbb->segment_shift = 0;
+
+    pbb->growth.mode = (pbb_growth_mode)CAPACITY_GROWTH_MODE;
+    pbb->growth.increment = 0;
+    pbb->growth.max_capacity = 0;
+    pbb->growth.callback = NULL;
+    pbb->growth.context = NULL;
+    pbb->ring_fill = 0;
+
+    pbb->sink = NULL;
+    pbb->sink_context = NULL;
+    pbb->watermark = 0;
+    pbb->flushed = 0;
+    pbb->source = NULL;
+    pbb->source_context = NULL;
+
+    return pbb;
+}
+
+static inline void put_bits(uint8_t* dst, uint8_t bit_pos, uint64_t data, uint8_t bits) {
+    /**
+     * Move the field to the top of the register, then down to the cursor's bit offset.
+     * Bits below the field are zero, so OR-ing the whole word leaves the following bytes intact.
+     */
+    uint64_t aligned = data << (64 - bits);
+    store_be64(dst, load_be64(dst) | (aligned >> bit_pos));
+
+    // A field longer than 64 - bit_pos bits spills its lowest bits into the 9th byte
+    if (bit_pos + bits > 64) {
+        dst[8] |= (uint8_t)(aligned << (8 - bit_pos));
+    }
+}
+
+static inline uint64_t get_bits(const uint8_t* src, uint8_t bit_pos, uint8_t bits) {
+    // Refill the window so that the field starts at its most significant bit
+    uint64_t window = load_be64(src) << bit_pos;
+    if (bit_pos + bits > 64) {
+        window |= src[8] >> (8 - bit_pos);
+    }
+
+    return window >> (64 - bits);
 }
 
-uint64_t flr_resize_float_double(
-    double src, 
-    int src_exp_bits, int src_mant_bits,
-    int dst_exp_bits, int dst_mant_bits
-) {
-    qword wq;
-    wq.double_val = src;
-    return flr_resize_float_long(wq.uint64_val, src_exp_bits, src_mant_bits, dst_exp_bits, dst_mant_bits);
+static uint64_t read_bits(partial_byte_buffer* pbbr, uint8_t bits) {
+    uint64_t value = peek_bits(pbbr, bits);
+
+    if (pbbr->storage == PBB_STORAGE_RING) {
+        clear_ring_bits(pbbr, pbbr->read_pos, bits);
+        pbbr->read_pos = wrap_ring_pos(pbbr, pbbr->read_pos, bits);
+        pbbr->ring_fill -= bits;
+    } else {
+        pbbr->read_pos += bits;
+    }
+
+    return value;
 }
 
-static uint8_t read_byte(partial_byte_buffer* pbbr, uint64_t* acc, uint8_t* read_bits) {
-    uint8_t available_bits = 8 - (pbbr->read_pos & 7);
-    uint8_t bits_to_read = MIN(available_bits, *read_bits);
-    
+static uint64_t peek_bits(const partial_byte_buffer* pbbr, uint8_t bits) {
     size_t byte_pos = pbbr->read_pos >> 3;
     uint8_t bit_pos = pbbr->read_pos & 7;
-    // Extract bits from the buffer at current position
-    uint8_t read = (uint8_t)(pbbr->buffer[byte_pos] << bit_pos) >> (8 - bits_to_read);
-    *acc = (*acc << bits_to_read) | read;
+    const uint8_t* src;
+    uint8_t tail[TAIL_COPY_SIZE];
 
-    // Update position
-    pbbr->read_pos += bits_to_read;
-    *read_bits -= bits_to_read;
-    
-    return read;
+    if (pbbr->storage == PBB_STORAGE_SEGMENTED || pbbr->storage == PBB_STORAGE_RING) {
+        src = segment_byte(pbbr, byte_pos);
+        if (segment_run(pbbr, pbbr->read_pos, 1, bits) == 0) {
+            // The field crosses into the next segment: read it from a copy of the bytes around the boundary
+            memset(tail, 0, TAIL_COPY_SIZE);
+            gather_bytes(pbbr, byte_pos, tail, (bit_pos + bits + 7) >> 3);
+            src = tail;
+        }
+    } else {
+        src = pbbr->buffer + byte_pos;
+        if (byte_pos + sizeof(uint64_t) + 1 > readable_bytes(pbbr)) {
+            copy_tail(pbbr, byte_pos, tail);
+            src = tail;
+        }
+    }
+
+    return get_bits(src, bit_pos, bits);
 }
 
-static void write_byte(partial_byte_buffer* pbb, uint64_t data, uint8_t* data_bits) {
-    /** 
-     * Concatenate data bits at the write cursor position.
-     */
+static void write_bits(partial_byte_buffer* pbb, uint64_t data, uint8_t bits) {
     size_t byte_pos = pbb->write_pos >> 3;
-    uint8_t available_bits = 8 - (pbb->write_pos & 7);
-    uint8_t write_bits = MIN(available_bits, *data_bits);
-    pbb->buffer[byte_pos] |= data << (64 - *data_bits) >> (64 - write_bits) << (available_bits - write_bits);
+    uint8_t bit_pos = pbb->write_pos & 7;
+
+    if (pbb->storage == PBB_STORAGE_OWNED) {
+        put_bits(pbb->buffer + byte_pos, bit_pos, data, bits);
+    } else if (segment_run(pbb, pbb->write_pos, 1, bits) == 1) {
+        put_bits(segment_byte(pbb, byte_pos), bit_pos, data, bits);
+    } else {
+        // The field crosses into the next segment: build it in a zeroed window merged around the boundary
+        uint8_t window[TAIL_COPY_SIZE];
+        memset(window, 0, TAIL_COPY_SIZE);
+        put_bits(window, bit_pos, data, bits);
+        merge_bytes(pbb, byte_pos, window, (bit_pos + bits + 7) >> 3);
+    }
+
+    if (pbb->storage == PBB_STORAGE_RING) {
+        pbb->write_pos = wrap_ring_pos(pbb, pbb->write_pos, bits);
+        pbb->ring_fill += bits;
+    } else {
+        pbb->write_pos += bits;
+    }
+}
+
+static int add_segment(partial_byte_buffer* pbb) {
+    // The segment table doubles whenever the count reaches a power of 2
+    size_t count = pbb->segment_count;
+    if ((count & (count - 1)) == 0) {
+        size_t slots = count == 0 ? 1 : count << 1;
+        uint8_t** segments = (uint8_t**)realloc(pbb->segments, slots * sizeof(uint8_t*));
+        if (segments == NULL) return 0;
+        pbb->segments = segments;
+    }
+
+    size_t segment_size = (size_t)1 << pbb->segment_shift;
+    uint8_t* segment = (uint8_t*)calloc(segment_size + BUFFER_PADDING, 1);
+    if (segment == NULL) return 0;
+
+    pbb->segments[count] = segment;
+    pbb->segment_count = count + 1;
+    pbb->capacity += segment_size;
+
+    return 1;
+}
+
+static inline uint8_t* segment_byte(const partial_byte_buffer* pbb, size_t byte_pos) {
+    if (pbb->storage == PBB_STORAGE_RING) return pbb->buffer + byte_pos;
+
+    size_t offset_mask = ((size_t)1 << pbb->segment_shift) - 1;
+    return pbb->segments[byte_pos >> pbb->segment_shift] + (byte_pos & offset_mask);
+}
+
+static inline size_t segment_run(const partial_byte_buffer* pbb, size_t pos, size_t count, uint8_t bits) {
+    size_t room;
+    if (pbb->storage == PBB_STORAGE_RING) {
+        room = (pbb->capacity << 3) - pos;
+    } else {
+        size_t segment_bits = (size_t)1 << (pbb->segment_shift + 3);
+        room = segment_bits - (pos & (segment_bits - 1));
+    }
+    return MIN(count, room / bits);
+}
+
+static inline size_t storage_span(const partial_byte_buffer* pbb, size_t byte_pos, uint8_t** data) {
+    if (pbb->storage == PBB_STORAGE_RING) {
+        byte_pos %= pbb->capacity;
+        *data = pbb->buffer + byte_pos;
+        return pbb->capacity - byte_pos;
+    }
+
+    size_t segment_size = (size_t)1 << pbb->segment_shift;
+    size_t offset = byte_pos & (segment_size - 1);
+    *data = pbb->segments[byte_pos >> pbb->segment_shift] + offset;
+    return segment_size - offset;
+}
+
+static void gather_bytes(const partial_byte_buffer* pbb, size_t byte_pos, uint8_t* dst, size_t size) {
+    while (size > 0) {
+        uint8_t* data;
+        size_t chunk = MIN(size, storage_span(pbb, byte_pos, &data));
+        memcpy(dst, data, chunk);
+        dst += chunk;
+        byte_pos += chunk;
+        size -= chunk;
+    }
+}
 
-    // Update the write cursor
-    pbb->write_pos += write_bits;
+static void merge_bytes(partial_byte_buffer* pbb, size_t byte_pos, const uint8_t* src, size_t size) {
+    while (size > 0) {
+        uint8_t* data;
+        size_t chunk = MIN(size, storage_span(pbb, byte_pos, &data));
+        for (size_t i = 0; i < chunk; ++i) data[i] |= src[i];
+        src += chunk;
+        byte_pos += chunk;
+        size -= chunk;
+    }
+}
+
+static inline size_t data_span(const partial_byte_buffer* pbb, size_t offset, uint8_t** data) {
+    switch (pbb->storage) {
+    case PBB_STORAGE_SEGMENTED:
+        return storage_span(pbb, offset, data);
+    case PBB_STORAGE_RING:
+        return storage_span(pbb, (pbb->read_pos >> 3) + offset, data);
+    default:
+        *data = pbb->buffer + offset;
+        return pbb_get_length(pbb) - offset;
+    }
+}
+
+#if PBB_HAVE_POSIX
+static size_t fill_iovec(const partial_byte_buffer* pbb, size_t offset, struct iovec* iov, size_t iov_count, int stop) {
+    size_t length = pbb_get_length(pbb);
+    size_t entries = 0;
+
+    while (offset < length && (!stop || entries < iov_count)) {
+        uint8_t* data;
+        size_t chunk = MIN(length - offset, data_span(pbb, offset, &data));
+        if (entries < iov_count) {
+            iov[entries].iov_base = data;
+            iov[entries].iov_len = chunk;
+        }
+        ++entries;
+        offset += chunk;
+    }
+
+    return entries;
+}
+#endif
+
+static void clear_ring_bits(partial_byte_buffer* pbb, size_t pos, size_t bits) {
+    size_t ring_bits = pbb->capacity << 3;
+    while (bits > 0) {
+        size_t chunk = MIN(bits, ring_bits - pos);
+        size_t end = pos + chunk;
+        size_t first_byte = pos >> 3;
+        size_t last_byte = (end - 1) >> 3;
+        uint8_t head_mask = (uint8_t)(0xFF >> (pos & 7));
+        uint8_t tail_mask = (uint8_t)(0xFF << ((8 - (end & 7)) & 7));
+
+        if (first_byte == last_byte) {
+            pbb->buffer[first_byte] &= (uint8_t)~(head_mask & tail_mask);
+        } else {
+            pbb->buffer[first_byte] &= (uint8_t)~head_mask;
+            memset(pbb->buffer + first_byte + 1, 0, last_byte - first_byte - 1);
+            pbb->buffer[last_byte] &= (uint8_t)~tail_mask;
+        }
+
+        bits -= chunk;
+        pos = 0;
+    }
+}
 
-    *data_bits -= write_bits;
+static inline size_t wrap_ring_pos(const partial_byte_buffer* pbb, size_t pos, size_t bits) {
+    size_t ring_bits = pbb->capacity << 3;
+    pos += bits;
+    return pos >= ring_bits ? pos - ring_bits : pos;
 }
 
-static size_t next_capacity(size_t n) {
-    switch (CAPACITY_GROWTH_MODE)
+static size_t next_capacity(const pbb_growth_policy* policy, size_t capacity, size_t required) {
+    /**
+     * Multiplying modes grow from the current capacity, or from the required bytes
+     * if that is still not enough, which leaves headroom after a large write.
+     */
+    size_t grown;
+    switch (policy->mode)
     {
-    case CAPACITY_DOUBLE:
-        return n << 1;
-    case CAPACITY_HALF:
-        return n + (n >> 1);
+    case PBB_GROWTH_DOUBLE:
+        grown = capacity << 1;
+        if (grown < required) grown = required << 1;
+        break;
+    case PBB_GROWTH_HALF:
+        grown = capacity + (capacity >> 1);
+        if (grown < required) grown = required + (required >> 1);
+        break;
+    case PBB_GROWTH_FIXED:
+        grown = capacity + (required - capacity + policy->increment - 1) / policy->increment * policy->increment;
+        break;
+    case PBB_GROWTH_CALLBACK:
+        grown = policy->callback(capacity, required, policy->context);
+        break;
     default:
+        grown = required;
         break;
     }
+
+    if (policy->max_capacity != 0 && grown > policy->max_capacity) {
+        grown = policy->max_capacity;
+    }
+
+    return grown;
 }
 
-static void ensure_capacity(partial_byte_buffer* pbb, uint8_t bits) {
+static int ensure_capacity(partial_byte_buffer* pbb, size_t bits) {
+    // A streaming writer past its watermark flushes first, keeping the data if the sink fails
+    if (pbb->sink != NULL && (pbb->write_pos >> 3) >= pbb->watermark) {
+        drain_to_sink(pbb);
+    }
+
+    // A ring never grows: it only takes writes fitting in its free bits
+    if (pbb->storage == PBB_STORAGE_RING) return bits <= pbb_ring_free_bits(pbb);
+
     size_t required_bytes = (pbb->write_pos + bits + 7) >> 3;
-    if (required_bytes <= pbb->capacity)
-        return;
+    int writable = pbb->storage == PBB_STORAGE_OWNED || pbb->storage == PBB_STORAGE_SEGMENTED;
+    if (required_bytes <= pbb->capacity && writable)
+        return 1;
 
-    /**
-     * Calculate the new capacity for the buffer.
-     * If the new capacity based on current capacity is still not enough,
-     * use the required bytes to calculate a larger capacity. 
-     */
-    size_t capacity = next_capacity(pbb->capacity);
-    if (capacity < required_bytes) {
-        capacity = next_capacity(required_bytes);
+    // Segments are small steps already: only the maximum capacity of the policy applies
+    if (pbb->storage == PBB_STORAGE_SEGMENTED) {
+        if (pbb->growth.max_capacity != 0 && required_bytes > pbb->growth.max_capacity) return 0;
+        return resize_storage(pbb, required_bytes);
+    }
+
+    // Memory that is not owned is copied at its current size when it is large enough
+    size_t capacity = pbb->capacity;
+    if (required_bytes > capacity) {
+        capacity = next_capacity(&pbb->growth, pbb->capacity, required_bytes);
+        if (capacity < required_bytes) return 0;
+    }
+
+    return resize_storage(pbb, capacity);
+}
+
+static int resize_storage(partial_byte_buffer* pbb, size_t capacity) {
+    // Segmented buffers grow by whole segments, leaving the written ones in place
+    if (pbb->storage == PBB_STORAGE_SEGMENTED) {
+        while (pbb->capacity < capacity) {
+            if (!add_segment(pbb)) return 0;
+        }
+        return 1;
     }
 
-    uint8_t* new_buffer = (uint8_t*)realloc(pbb->buffer, capacity);
-    if (new_buffer == NULL) return;
+    uint8_t* new_buffer;
+    if (pbb->storage == PBB_STORAGE_OWNED) {
+        new_buffer = (uint8_t*)realloc(pbb->buffer, capacity + BUFFER_PADDING);
+    } else {
+        // Copy on write: borrowed and mapped memory is never modified
+        new_buffer = (uint8_t*)malloc(capacity + BUFFER_PADDING);
+        if (new_buffer == NULL) return 0;
+        memcpy(new_buffer, pbb->buffer, pbb->capacity);
+        release_storage(pbb);
+    }
+    if (new_buffer == NULL) return 0;
 
-    // Initialize the newly allocated memory to zero
-    memset(new_buffer + pbb->capacity, 0, capacity - pbb->capacity);
+    // Initialize the newly allocated memory (and the moved padding) to zero
+    memset(new_buffer + pbb->capacity, 0, capacity - pbb->capacity + BUFFER_PADDING);
     pbb->buffer = new_buffer;
     pbb->capacity = capacity;
+    pbb->storage = PBB_STORAGE_OWNED;
+
+    return 1;
+}
+
+static int ensure_readable(partial_byte_buffer* pbbr, size_t bits) {
+    if (bits <= available_bits(pbbr)) return 1;
+    if (pbbr->source == NULL) return 0;
+
+    refill_from_source(pbbr, bits);
+    return bits <= available_bits(pbbr);
+}
+
+static void refill_from_source(partial_byte_buffer* pbbr, size_t bits) {
+    // Keep the unread bytes only, at the start of the window; the source always provides whole bytes
+    size_t consumed = pbbr->read_pos >> 3;
+    size_t length = pbbr->write_pos >> 3;
+    memmove(pbbr->buffer, pbbr->buffer + consumed, length - consumed);
+    memset(pbbr->buffer + length - consumed, 0, consumed);
+    pbbr->read_pos -= consumed << 3;
+    pbbr->write_pos -= consumed << 3;
+
+    size_t required_bytes = (pbbr->read_pos + bits + 7) >> 3;
+    if (required_bytes > pbbr->capacity && !resize_storage(pbbr, required_bytes)) return;
+
+    while (bits > available_bits(pbbr)) {
+        size_t filled = pbbr->write_pos >> 3;
+        size_t provided = pbbr->source(pbbr->buffer + filled, pbbr->capacity - filled, pbbr->source_context);
+        if (provided == 0) break;
+        pbbr->write_pos += provided << 3;
+    }
+}
+
+#if PBB_HAVE_POSIX
+static size_t read_from_fd(uint8_t* dst, size_t size, void* context) {
+    int fd = (int)(intptr_t)context;
+    for (;;) {
+        ssize_t provided = read(fd, dst, size);
+        if (provided >= 0) return (size_t)provided;
+        if (errno != EINTR) return 0;
+    }
+}
+#endif
+
+static size_t read_from_file(uint8_t* dst, size_t size, void* context) {
+    return fread(dst, 1, size, (FILE*)context);
+}
+
+static int drain_to_sink(partial_byte_buffer* pbb) {
+    size_t complete = pbb->write_pos >> 3;
+    if (complete == 0) return 1;
+    if (!pbb->sink(pbb->buffer, complete, pbb->sink_context)) return 0;
+
+    // Bytes past the partial one are zero already
+    uint8_t partial = pbb->buffer[complete];
+    memset(pbb->buffer, 0, complete + 1);
+    pbb->buffer[0] = partial;
+
+    size_t flushed_bits = complete << 3;
+    pbb->write_pos -= flushed_bits;
+    pbb->read_pos = pbb->read_pos > flushed_bits ? pbb->read_pos - flushed_bits : 0;
+    pbb->flushed += complete;
+
+    return 1;
+}
+
+static size_t writer_run(partial_byte_buffer* pbb, size_t count, uint8_t bits) {
+    size_t run = MIN(count, MAX(pbb->watermark * 8 / bits, 1));
+
+    // A failing sink keeps the data, and the buffer grows as with single writes
+    if (((pbb->write_pos + run * bits + 7) >> 3) > pbb->capacity) drain_to_sink(pbb);
+
+    return run;
+}
+
+#if PBB_HAVE_POSIX
+static int write_to_fd(const uint8_t* data, size_t size, void* context) {
+    int fd = (int)(intptr_t)context;
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 1;
+}
+#endif
+
+static int write_to_file(const uint8_t* data, size_t size, void* context) {
+    return fwrite(data, 1, size, (FILE*)context) == size;
 }
 
 static void extend_sign(uint64_t* value, uint8_t bits) {
@@ -380,6 +1928,417 @@ static void extend_sign(uint64_t* value, uint8_t bits) {
     }
 }
 
-static size_t required_length(const partial_byte_buffer* pbbr, uint8_t bit_len) {
-    return (pbbr->read_pos + bit_len + 7) >> 3;
+static size_t available_bits(const partial_byte_buffer* pbbr) {
+    if (pbbr->storage == PBB_STORAGE_RING) return pbbr->ring_fill;
+    return (pbb_get_length(pbbr) << 3) - pbbr->read_pos;
+}
+
+static void release_storage(partial_byte_buffer* pbb) {
+    switch (pbb->storage) {
+    case PBB_STORAGE_OWNED:
+    case PBB_STORAGE_RING:
+        free(pbb->buffer);
+        break;
+    case PBB_STORAGE_SEGMENTED:
+        for (size_t i = 0; i < pbb->segment_count; ++i) free(pbb->segments[i]);
+        free(pbb->segments);
+        break;
+#if PBB_HAVE_POSIX
+    case PBB_STORAGE_MAPPED:
+        munmap(pbb->buffer, pbb->capacity);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+static size_t readable_bytes(const partial_byte_buffer* pbbr) {
+    int padded = pbbr->storage == PBB_STORAGE_OWNED || pbbr->storage == PBB_STORAGE_RING;
+    return padded ? pbbr->capacity + BUFFER_PADDING : pbbr->capacity;
+}
+
+static size_t loadable_values(const partial_byte_buffer* pbbr, size_t count, uint8_t bits) {
+    size_t readable = readable_bytes(pbbr);
+    if (readable <= sizeof(uint64_t)) return 0;
+
+    // Values must start before this bit for their window to end inside the readable bytes
+    size_t limit_pos = (readable - sizeof(uint64_t)) << 3;
+    if (limit_pos <= pbbr->read_pos) return 0;
+
+    return MIN(count, (limit_pos - pbbr->read_pos + bits - 1) / bits);
+}
+
+static void copy_tail(const partial_byte_buffer* pbbr, size_t byte_pos, uint8_t tail[TAIL_COPY_SIZE]) {
+    memset(tail, 0, TAIL_COPY_SIZE);
+    memcpy(tail, pbbr->buffer + byte_pos, readable_bytes(pbbr) - byte_pos);
+}
+
+static size_t read_int32_array(partial_byte_buffer* pbbr, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    if (pbbr == NULL || values == NULL || bits <= 0 || bits > BITSIZEOF_INT32) return 0;
+
+    // A streaming reader decodes the values window by window
+    if (pbbr->source != NULL && count * bits > available_bits(pbbr)) {
+        size_t window_values = MAX((size_t)1, ((pbbr->capacity - 1) << 3) / bits);
+        size_t done = 0;
+        while (done < count) {
+            size_t chunk = MIN(count - done, window_values);
+            if (!ensure_readable(pbbr, chunk * bits)) chunk = available_bits(pbbr) / bits;
+            if (chunk == 0) break;
+            done += read_int32_array(pbbr, values + done, chunk, bits, sign_extend);
+        }
+        return done;
+    }
+
+    count = MIN(count, available_bits(pbbr) / bits);
+    if (count == 0) return 0;
+
+    if (pbbr->storage == PBB_STORAGE_SEGMENTED || pbbr->storage == PBB_STORAGE_RING) {
+        for (size_t i = 0; i < count;) {
+            size_t run = segment_run(pbbr, pbbr->read_pos, count - i, bits);
+            if (run == 0) {
+                uint64_t value = read_bits(pbbr, bits);
+                if (sign_extend) extend_sign(&value, bits);
+                values[i++] = (int32_t)value;
+                continue;
+            }
+            uint8_t* src;
+            size_t src_len = storage_span(pbbr, pbbr->read_pos >> 3, &src) + BUFFER_PADDING;
+            pbb_kernels->unpack_int32(src, src_len, pbbr->read_pos & 7, values + i, run, bits, sign_extend);
+            if (pbbr->storage == PBB_STORAGE_RING) {
+                clear_ring_bits(pbbr, pbbr->read_pos, run * bits);
+                pbbr->read_pos = wrap_ring_pos(pbbr, pbbr->read_pos, run * bits);
+                pbbr->ring_fill -= run * bits;
+            } else {
+                pbbr->read_pos += run * bits;
+            }
+            i += run;
+        }
+        return count;
+    }
+
+    size_t direct = loadable_values(pbbr, count, bits);
+    size_t byte_pos = pbbr->read_pos >> 3;
+    pbb_kernels->unpack_int32(
+        pbbr->buffer + byte_pos, readable_bytes(pbbr) - byte_pos, pbbr->read_pos & 7,
+        values, direct, bits, sign_extend
+    );
+    pbbr->read_pos += direct * bits;
+
+    // The last values of memory without padding are decoded from a padded copy
+    if (direct < count) {
+        uint8_t tail[TAIL_COPY_SIZE];
+        copy_tail(pbbr, pbbr->read_pos >> 3, tail);
+        pbb_kernels->unpack_int32(tail, TAIL_COPY_SIZE, pbbr->read_pos & 7, values + direct, count - direct, bits, sign_extend);
+        pbbr->read_pos += (count - direct) * bits;
+    }
+
+    return count;
+}
+
+static size_t read_int64_array(partial_byte_buffer* pbbr, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    if (pbbr == NULL || values == NULL || bits <= 0 || bits > BITSIZEOF_INT64) return 0;
+
+    // A streaming reader decodes the values window by window
+    if (pbbr->source != NULL && count * bits > available_bits(pbbr)) {
+        size_t window_values = MAX((size_t)1, ((pbbr->capacity - 1) << 3) / bits);
+        size_t done = 0;
+        while (done < count) {
+            size_t chunk = MIN(count - done, window_values);
+            if (!ensure_readable(pbbr, chunk * bits)) chunk = available_bits(pbbr) / bits;
+            if (chunk == 0) break;
+            done += read_int64_array(pbbr, values + done, chunk, bits, sign_extend);
+        }
+        return done;
+    }
+
+    count = MIN(count, available_bits(pbbr) / bits);
+    if (count == 0) return 0;
+
+    if (pbbr->storage == PBB_STORAGE_SEGMENTED || pbbr->storage == PBB_STORAGE_RING) {
+        for (size_t i = 0; i < count;) {
+            size_t run = segment_run(pbbr, pbbr->read_pos, count - i, bits);
+            if (run == 0) {
+                uint64_t value = read_bits(pbbr, bits);
+                if (sign_extend) extend_sign(&value, bits);
+                values[i++] = (int64_t)value;
+                continue;
+            }
+            uint8_t* src;
+            size_t src_len = storage_span(pbbr, pbbr->read_pos >> 3, &src) + BUFFER_PADDING;
+            pbb_kernels->unpack_int64(src, src_len, pbbr->read_pos & 7, values + i, run, bits, sign_extend);
+            if (pbbr->storage == PBB_STORAGE_RING) {
+                clear_ring_bits(pbbr, pbbr->read_pos, run * bits);
+                pbbr->read_pos = wrap_ring_pos(pbbr, pbbr->read_pos, run * bits);
+                pbbr->ring_fill -= run * bits;
+            } else {
+                pbbr->read_pos += run * bits;
+            }
+            i += run;
+        }
+        return count;
+    }
+
+    size_t direct = loadable_values(pbbr, count, bits);
+    size_t byte_pos = pbbr->read_pos >> 3;
+    pbb_kernels->unpack_int64(
+        pbbr->buffer + byte_pos, readable_bytes(pbbr) - byte_pos, pbbr->read_pos & 7,
+        values, direct, bits, sign_extend
+    );
+    pbbr->read_pos += direct * bits;
+
+    // The last values of memory without padding are decoded from a padded copy
+    if (direct < count) {
+        uint8_t tail[TAIL_COPY_SIZE];
+        copy_tail(pbbr, pbbr->read_pos >> 3, tail);
+        pbb_kernels->unpack_int64(tail, TAIL_COPY_SIZE, pbbr->read_pos & 7, values + direct, count - direct, bits, sign_extend);
+        pbbr->read_pos += (count - direct) * bits;
+    }
+
+    return count;
+}
+
+static void write_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits, flr_rounding rounding) {
+    flr_format format;
+    if (pbb == NULL || !flr_format_init_signs(&format, DOUBLE_EXP_BITS, DOUBLE_MANT_BITS, 1, exp_bits, mant_bits, sign_bits)) return;
+    flr_format_set_rounding(&format, rounding);
+
+    uint8_t bits = sign_bits + exp_bits + mant_bits;
+    if (bits == 0 || !ensure_capacity(pbb, bits)) return;
+    write_bits(pbb, flr_resize_double(&format, value), bits);
+}
+
+static double read_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits) {
+    flr_format format;
+    if (pbbr == NULL || !flr_format_init_signs(&format, exp_bits, mant_bits, sign_bits, DOUBLE_EXP_BITS, DOUBLE_MANT_BITS, 1)) return 0.0;
+
+    uint8_t bits = sign_bits + exp_bits + mant_bits;
+    if (bits == 0 || !ensure_readable(pbbr, bits)) return 0.0;
+
+    qword q;
+    q.uint64_val = flr_resize(&format, read_bits(pbbr, bits));
+    return q.double_val;
+}
+
+static size_t write_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits, flr_rounding rounding) {
+    flr_format format;
+    if (pbb == NULL || values == NULL) return 0;
+    if (!flr_format_init_signs(&format, DOUBLE_EXP_BITS, DOUBLE_MANT_BITS, 1, exp_bits, mant_bits, sign_bits)) return 0;
+    flr_format_set_rounding(&format, rounding);
+
+    uint8_t bits = sign_bits + exp_bits + mant_bits;
+    if (bits == 0) return 0;
+    int64_t block[RESIZE_BLOCK_SIZE];
+    size_t done = 0;
+
+    // Resized values have no bit above their sign, as the packing kernels require
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        flr_resize_array_double(&format, values + done, (uint64_t*)block, chunk);
+
+        size_t written = pbb_write_int64_array(pbb, block, chunk, bits);
+        done += written;
+        if (written < chunk) break;
+    }
+
+    return done;
+}
+
+static size_t read_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits, uint8_t sign_bits) {
+    flr_format format;
+    if (pbbr == NULL || values == NULL) return 0;
+    if (!flr_format_init_signs(&format, exp_bits, mant_bits, sign_bits, DOUBLE_EXP_BITS, DOUBLE_MANT_BITS, 1)) return 0;
+
+    uint8_t bits = sign_bits + exp_bits + mant_bits;
+    if (bits == 0) return 0;
+    int64_t block[RESIZE_BLOCK_SIZE];
+    size_t done = 0;
+
+    // The resize masks every part of the fields, so they are decoded without sign extension
+    while (done < count) {
+        size_t chunk = MIN(count - done, (size_t)RESIZE_BLOCK_SIZE);
+        size_t read = read_int64_array(pbbr, block, chunk, bits, 0);
+        flr_resize_array(&format, (const uint64_t*)block, (uint64_t*)block, read);
+        memcpy(values + done, block, read * sizeof(double));
+
+        done += read;
+        if (read < chunk) break;
+    }
+
+    return done;
+}
+
+static int select_format(const double* samples, size_t count, double precision, int allow_unsigned, flr_rounding rounding, flr_format_spec* spec) {
+    if ((samples == NULL && count > 0) || spec == NULL || !(precision > 0.0)) return 0;
+
+    float_scan scan = {DOUBLE_EXP_MASK, 0, 0};
+    pbb_kernels->scan_float(samples, count, &scan);
+
+    spec->exp_bits = 1;
+    spec->mant_bits = 0;
+    spec->sign_bits = allow_unsigned && !scan.negative ? 0 : 1;
+    if (scan.min_exponent > scan.max_exponent) return 1;
+
+    // A normal value of exponent e is stored with exponent e + bias, which must stay within 1 and 2 * bias
+    int min_exponent = (int)scan.min_exponent - DOUBLE_EXP_BIAS;
+    int max_exponent = (int)scan.max_exponent - DOUBLE_EXP_BIAS;
+    int bias = 0;
+    int nearest = rounding == FLR_ROUND_NEAREST_EVEN;
+
+    // Rounding may carry the largest values up to the next exponent
+    while (min_exponent < 1 - bias || max_exponent + nearest > bias) {
+        ++spec->exp_bits;
+        bias = (1 << (spec->exp_bits - 1)) - 1;
+    }
+
+    // Truncating to m mantissa bits loses less than 2^(e - m) from a value of exponent e, and rounding at most half of it
+    while (spec->mant_bits < DOUBLE_MANT_BITS
+        && (nearest ? ldexp(1.0, max_exponent - spec->mant_bits - 1) >= precision : ldexp(1.0, max_exponent - spec->mant_bits) > precision)) {
+        ++spec->mant_bits;
+    }
+
+    return 1;
+}
+
+static inline int64_t delta_residual(pbb_delta_coder* coder, int64_t value) {
+    if (coder->count++ == 0) {
+        coder->previous = value;
+        coder->previous_delta = 0;
+        return value;
+    }
+
+    // Differences are taken modulo 2^64, so that any two values have one
+    uint64_t delta = (uint64_t)value - (uint64_t)coder->previous;
+    uint64_t residual = coder->order == PBB_DELTA_OF_DELTA ? delta - (uint64_t)coder->previous_delta : delta;
+    coder->previous = value;
+    coder->previous_delta = (int64_t)delta;
+    return (int64_t)residual;
+}
+
+static inline int64_t delta_value(pbb_delta_coder* coder, int64_t residual) {
+    if (coder->count++ == 0) {
+        coder->previous = residual;
+        coder->previous_delta = 0;
+        return residual;
+    }
+
+    uint64_t delta = coder->order == PBB_DELTA_OF_DELTA
+        ? (uint64_t)residual + (uint64_t)coder->previous_delta
+        : (uint64_t)residual;
+    coder->previous = (int64_t)((uint64_t)coder->previous + delta);
+    coder->previous_delta = (int64_t)delta;
+    return coder->previous;
+}
+
+static inline uint8_t delta_code(int64_t residual, uint64_t* head, uint8_t* head_bits) {
+    uint8_t bucket = 0;
+    if (residual != 0) {
+        // The narrowest bucket whose width holds the residual as a signed field
+        for (bucket = 1; bucket < DELTA_BUCKET_COUNT - 1; ++bucket) {
+            int64_t limit = (int64_t)1 << (DELTA_RESIDUAL_BITS[bucket] - 1);
+            if (residual >= -limit && residual < limit) break;
+        }
+    }
+
+    if (bucket == DELTA_BUCKET_COUNT - 1) {
+        *head = (1 << bucket) - 1;
+        *head_bits = bucket;
+        return 64;
+    }
+
+    uint8_t bits = DELTA_RESIDUAL_BITS[bucket];
+    uint64_t prefix = (uint64_t)((1 << bucket) - 1) << 1;
+    uint64_t field = bits == 0 ? 0 : (uint64_t)residual & (((uint64_t)1 << bits) - 1);
+    *head = (prefix << bits) | field;
+    *head_bits = bucket + 1 + bits;
+    return 0;
+}
+
+static int read_delta_residual(partial_byte_buffer* pbbr, int first, int64_t* residual) {
+    if (first) {
+        if (!ensure_readable(pbbr, 64)) return 0;
+        *residual = (int64_t)read_bits(pbbr, 64);
+        return 1;
+    }
+
+    // The prefix is a run of one bits, ended by a zero bit unless it reaches the last bucket.
+    // It is peeked a bit at a time, so that nothing is consumed from a truncated code.
+    uint8_t bucket = 0;
+    while (bucket < DELTA_BUCKET_COUNT - 1) {
+        if (!ensure_readable(pbbr, bucket + 1)) return 0;
+        if ((peek_bits(pbbr, bucket + 1) & 1) == 0) break;
+        ++bucket;
+    }
+
+    uint8_t prefix_bits = bucket < DELTA_BUCKET_COUNT - 1 ? bucket + 1 : bucket;
+    uint8_t bits = DELTA_RESIDUAL_BITS[bucket];
+    if (!ensure_readable(pbbr, prefix_bits + bits)) return 0;
+    read_bits(pbbr, prefix_bits);
+
+    uint64_t value = 0;
+    if (bits > 0) {
+        value = read_bits(pbbr, bits);
+        extend_sign(&value, bits);
+    }
+
+    *residual = (int64_t)value;
+    return 1;
+}
+
+static size_t stage_delta_codes(pbb_delta_coder* coder, const int64_t* values, size_t count, uint64_t* staged) {
+    uint8_t* bytes = (uint8_t*)staged;
+    bit_packer packer;
+    packer_begin(&packer, bytes, 0);
+
+    for (size_t i = 0; i < count; ++i) {
+        int first = coder->count == 0;
+        int64_t residual = delta_residual(coder, values[i]);
+        uint64_t head = 0;
+        uint8_t head_bits = 0;
+        uint8_t tail_bits = first ? 64 : delta_code(residual, &head, &head_bits);
+
+        if (head_bits > 0) packer_put(&packer, head, head_bits);
+        if (tail_bits > 0) packer_put(&packer, (uint64_t)residual, tail_bits);
+    }
+
+    size_t bits = (size_t)(packer.dst - bytes) * 8 + packer.filled;
+    packer_end(&packer);
+
+    // The packer stores big-endian words, appended back as integers
+    size_t words = (bits + 63) >> 6;
+    for (size_t i = 0; i < words; ++i) {
+        staged[i] = load_be64(bytes + i * sizeof(uint64_t));
+    }
+
+    return bits;
+}
+
+static size_t decode_delta_direct(partial_byte_buffer* pbbr, pbb_delta_coder* coder, int64_t* values, size_t count) {
+    const uint8_t* src = pbbr->buffer;
+    size_t readable = readable_bytes(pbbr);
+    size_t pos = pbbr->read_pos;
+    size_t end = pos + available_bits(pbbr);
+    size_t done = 0;
+
+    while (done < count && (pos >> 3) + DELTA_WINDOW_BYTES <= readable) {
+        uint64_t prefix = get_bits(src + (pos >> 3), pos & 7, DELTA_BUCKET_COUNT - 1);
+        uint8_t bucket = 0;
+        while (bucket < DELTA_BUCKET_COUNT - 1 && ((prefix >> (DELTA_BUCKET_COUNT - 2 - bucket)) & 1)) ++bucket;
+
+        size_t next = pos + (bucket < DELTA_BUCKET_COUNT - 1 ? bucket + 1 : bucket);
+        uint8_t bits = DELTA_RESIDUAL_BITS[bucket];
+        uint64_t residual = 0;
+        if (bits > 0) {
+            residual = get_bits(src + (next >> 3), next & 7, bits);
+            extend_sign(&residual, bits);
+            next += bits;
+        }
+        if (next > end) break;
+
+        pos = next;
+        values[done++] = delta_value(coder, (int64_t)residual);
+    }
+
+    pbbr->read_pos = pos;
+    return done;
 }
@@ -3,6 +3,12 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Scatter-gather entry of <sys/uio.h>, only used through pointers here.
+ */
+struct iovec;
 
 /**
  * Union to interpret binary representation of different types.
@@ -15,6 +21,127 @@ typedef union qword {
     int32_t int32_val;
 } qword;
 
+/**
+ * Table of the double of every code of a small float format, so that decoding is a single lookup.
+ */
+typedef struct flr_decode_table flr_decode_table;
+
+/**
+ * Fixed-point format of a channel: a range split in steps, each value stored as the index of its nearest step.
+ */
+typedef struct fxp_format fxp_format;
+
+/**
+ * Implementations of the bulk array read/write kernels, one per instruction set.
+ */
+typedef enum pbb_kernel {
+    PBB_KERNEL_SCALAR = 0,
+    PBB_KERNEL_BMI2,
+    PBB_KERNEL_SSE41,
+    PBB_KERNEL_AVX2,
+    PBB_KERNEL_AVX512,
+    PBB_KERNEL_COUNT
+} pbb_kernel;
+
+/**
+ * Ownership of the memory behind a partial_byte_buffer.
+ */
+typedef enum pbb_storage {
+    /**
+     * Allocated by the buffer, with zeroed tail padding. Freed by pbb_destroy.
+     */
+    PBB_STORAGE_OWNED = 0,
+
+    /**
+     * Caller memory wrapped by pbb_wrap_array. Never written to nor freed by the buffer.
+     */
+    PBB_STORAGE_BORROWED,
+
+    /**
+     * Read-only file mapping created by pbb_open_mmap. Unmapped by pbb_destroy.
+     */
+    PBB_STORAGE_MAPPED,
+
+    /**
+     * List of fixed-size segments created by pbb_create_segmented. [buffer] is NULL.
+     * Growing adds segments, so written data is never moved.
+     */
+    PBB_STORAGE_SEGMENTED,
+
+    /**
+     * Fixed-size circular buffer created by pbb_create_ring. Both cursors wrap around [capacity]
+     * and the buffer never grows: writes that do not fit in the free bits are dropped.
+     */
+    PBB_STORAGE_RING
+} pbb_storage;
+
+/**
+ * Strategies to compute the capacity of a buffer that has to grow.
+ */
+typedef enum pbb_growth_mode {
+    /**
+     * Multiply the capacity by 2.
+     */
+    PBB_GROWTH_DOUBLE = 0,
+
+    /**
+     * Multiply the capacity by 1.5.
+     */
+    PBB_GROWTH_HALF,
+
+    /**
+     * Add a fixed number of bytes, as many times as needed.
+     */
+    PBB_GROWTH_FIXED,
+
+    /**
+     * Ask a user callback for the new capacity.
+     */
+    PBB_GROWTH_CALLBACK
+} pbb_growth_mode;
+
+/**
+ * Growth callback returning the new capacity in bytes of a buffer of [capacity] bytes
+ * which needs at least [required] bytes. A result below [required] makes the write fail.
+ */
+typedef size_t (*pbb_growth_fn)(size_t capacity, size_t required, void* context);
+
+/**
+ * Growth policy of a partial_byte_buffer, applied whenever a write exceeds its capacity.
+ */
+typedef struct pbb_growth_policy {
+    pbb_growth_mode mode;
+
+    /**
+     * Number of bytes added at once by PBB_GROWTH_FIXED.
+     */
+    size_t increment;
+
+    /**
+     * Maximum capacity in bytes, or 0 for no limit. Writes which would exceed it are dropped.
+     */
+    size_t max_capacity;
+
+    /**
+     * Callback of PBB_GROWTH_CALLBACK and its user data.
+     */
+    pbb_growth_fn callback;
+    void* context;
+} pbb_growth_policy;
+
+/**
+ * Sink receiving the bytes flushed by a streaming writer.
+ * Returns 1 once all [size] bytes of [data] are consumed, or 0 on error. A sink failing
+ * after consuming part of the bytes cannot tell how many, so the output is then unknown.
+ */
+typedef int (*pbb_sink_fn)(const uint8_t* data, size_t size, void* context);
+
+/**
+ * Source filling a streaming reader with up to [size] bytes at [dst].
+ * Returns the number of bytes provided, or 0 at the end of the stream or on error.
+ */
+typedef size_t (*pbb_source_fn)(uint8_t* dst, size_t size, void* context);
+
 typedef struct partial_byte_buffer {
     /**
      * Array of bytes storing the buffer data.
@@ -35,6 +162,59 @@ typedef struct partial_byte_buffer {
      * Bit position for the next read operation.
      */
     size_t read_pos;
+
+    /**
+     * Ownership of [buffer]. A buffer that is not owned is copied into an owned one on the first write.
+     */
+    pbb_storage storage;
+
+    /**
+     * Segments of a segmented buffer, each holding (1 << [segment_shift]) bytes. NULL for other storages.
+     */
+    uint8_t** segments;
+
+    /**
+     * Number of allocated segments; [capacity] is [segment_count] segments.
+     */
+    size_t segment_count;
+
+    /**
+     * Base-2 logarithm of the segment size.
+     */
+    uint8_t segment_shift;
+
+    /**
+     * How the capacity grows. Defaults to the CAPACITY_GROWTH_MODE the library was built with.
+     */
+    pbb_growth_policy growth;
+
+    /**
+     * Number of written bits not read yet in a ring buffer, telling a full buffer from an empty one
+     * when both cursors are equal.
+     */
+    size_t ring_fill;
+
+    /**
+     * Sink of a streaming writer and its user data, or NULL. Flushed bytes leave the buffer.
+     */
+    pbb_sink_fn sink;
+    void* sink_context;
+
+    /**
+     * Number of complete bytes from which a streaming writer flushes them before the next write.
+     */
+    size_t watermark;
+
+    /**
+     * Number of bytes handed to [sink] so far.
+     */
+    size_t flushed;
+
+    /**
+     * Source of a streaming reader and its user data, or NULL.
+     */
+    pbb_source_fn source;
+    void* source_context;
 } partial_byte_buffer;
 
 /**
@@ -51,6 +231,175 @@ partial_byte_buffer* pbb_create(int initial_capacity);
  */
 partial_byte_buffer* pbb_from_array(const uint8_t* array, size_t size);
 
+/**
+ * Create a partial_byte_buffer reading an existing byte array with fixed size, without copying it.
+ * The array is borrowed: it must outlive the buffer and is never modified nor freed by it.
+ * The first write copies the data into an owned buffer, leaving the array untouched.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_wrap_array(const uint8_t* array, size_t size);
+
+/**
+ * Create a partial_byte_buffer reading the whole file at [path] through a read-only memory mapping.
+ * Pages are loaded on demand, hinted for sequential access, and the file is never modified:
+ * the first write copies the data into an owned buffer.
+ * Returns NULL if the file cannot be opened or mapped, if it is empty, or on platforms without mmap.
+ */
+partial_byte_buffer* pbb_open_mmap(const char* path);
+
+/**
+ * Create a partial_byte_buffer storing its data in a list of segments of [segment_size] bytes.
+ * The segment size is rounded up to a power of 2 (16 bytes to 1 GiB). Growing the buffer allocates
+ * new segments without copying the data, and all read and write functions work across segments.
+ * [buffer] is NULL for such a buffer; use pbb_export or pbb_flatten to get contiguous bytes.
+ * Returns NULL for an invalid segment size or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_segmented(size_t segment_size);
+
+/**
+ * Create a bounded circular partial_byte_buffer of [capacity] bytes, allocated once.
+ * The write and read cursors wrap around the capacity, so reading frees room for more writes.
+ * Every read and write function works on it: writes exceeding the free bits are dropped,
+ * and pbb_ring_write/pbb_ring_read transfer as many bits as possible.
+ * Returns NULL for an invalid capacity or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_ring(size_t capacity);
+
+/**
+ * Return the number of bits that can still be written to a ring buffer.
+ */
+size_t pbb_ring_free_bits(const partial_byte_buffer* pbb);
+
+/**
+ * Return the number of written bits not read yet from a ring buffer.
+ */
+size_t pbb_ring_used_bits(const partial_byte_buffer* pbb);
+
+/**
+ * Return 1 if a ring buffer has no free bits left, 0 otherwise.
+ */
+int pbb_ring_is_full(const partial_byte_buffer* pbb);
+
+/**
+ * Return 1 if a ring buffer has no bits left to read, 0 otherwise.
+ */
+int pbb_ring_is_empty(const partial_byte_buffer* pbb);
+
+/**
+ * Write up to [bits] bits of [src], MSB-first, to a ring buffer, stopping when it is full.
+ * Returns the number of bits actually written.
+ */
+size_t pbb_ring_write(partial_byte_buffer* pbb, const uint8_t* src, size_t bits);
+
+/**
+ * Read up to [bits] bits from a ring buffer into [dst], MSB-first, stopping when it is empty.
+ * The bits of the last byte of [dst] past the ones read are zero.
+ * Returns the number of bits actually read.
+ */
+size_t pbb_ring_read(partial_byte_buffer* pbbr, uint8_t* dst, size_t bits);
+
+/**
+ * Create a streaming writer: a partial_byte_buffer handing its complete bytes to [sink]
+ * as soon as [watermark] bytes are pending, before the next write. The partial last byte
+ * is kept in the buffer, so memory stays around [watermark] bytes whatever the stream length.
+ * Flushed bytes leave the buffer: [write_pos] restarts from the bits of the partial byte.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_writer(size_t watermark, pbb_sink_fn sink, void* context);
+
+/**
+ * Create a streaming writer flushing to the file descriptor [fd], which is not closed by the buffer.
+ * Returns NULL for invalid parameters, if memory allocation fails, or on platforms without POSIX I/O.
+ */
+partial_byte_buffer* pbb_create_fd_writer(int fd, size_t watermark);
+
+/**
+ * Create a streaming writer flushing to [file], which is neither flushed nor closed by the buffer.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_file_writer(FILE* file, size_t watermark);
+
+/**
+ * Hand all the complete bytes of a streaming writer to its sink, keeping the partial last byte.
+ * Returns 1 on success, or 0 if the sink fails, in which case the bytes stay in the buffer.
+ * The sink may have consumed part of them: flushing again can repeat bytes in the output.
+ */
+int pbb_flush(partial_byte_buffer* pbb);
+
+/**
+ * End the stream of a streaming writer: pad the partial last byte with zero bits and flush everything.
+ * Returns 1 on success, or 0 if the sink fails, in which case the bytes stay in the buffer
+ * and the output is unknown past the bytes flushed before, as with pbb_flush.
+ */
+int pbb_finish(partial_byte_buffer* pbb);
+
+/**
+ * Create a streaming reader: a partial_byte_buffer pulling bytes from [source] into a window
+ * of [window] bytes (at least 16) whenever a read needs more bits than the window holds.
+ * Bytes fully read are dropped from the window, so memory stays constant whatever the stream length.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_reader(size_t window, pbb_source_fn source, void* context);
+
+/**
+ * Create a streaming reader pulling from the file descriptor [fd], which is not closed by the buffer.
+ * The kernel is told that the file is read sequentially, so that its read-ahead overlaps decoding.
+ * Returns NULL for invalid parameters, if memory allocation fails, or on platforms without POSIX I/O.
+ */
+partial_byte_buffer* pbb_create_fd_reader(int fd, size_t window);
+
+/**
+ * Create a streaming reader pulling from [file], which is not closed by the buffer.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+partial_byte_buffer* pbb_create_file_reader(FILE* file, size_t window);
+
+/**
+ * Copy up to [size] bytes of the written data (see pbb_get_length) into [dst], whatever the storage.
+ * Returns the number of bytes copied.
+ */
+size_t pbb_export(const partial_byte_buffer* pbb, uint8_t* dst, size_t size);
+
+/**
+ * Move the data of a segmented buffer into one contiguous owned array, available as [buffer].
+ * Does nothing for other storages. Returns 1 on success, or 0 if memory allocation fails.
+ */
+int pbb_flatten(partial_byte_buffer* pbb);
+
+/**
+ * Describe the written data (see pbb_get_length) as a list of contiguous memory ranges, without copying:
+ * one for a contiguous buffer, one per segment for a segmented buffer, and up to two for a ring.
+ * The unused bits of a partial last byte are zero. Only the first [iov_count] entries are filled,
+ * and [iov] may be NULL to only count them. The entries stay valid until the buffer is written to.
+ * Returns the number of entries needed for all the data, or 0 on platforms without <sys/uio.h>.
+ */
+size_t pbb_to_iovec(const partial_byte_buffer* pbb, struct iovec* iov, size_t iov_count);
+
+/**
+ * Write the written data (see pbb_get_length) to the file descriptor [fd] with writev,
+ * straight from the storage of the buffer, resuming after short writes.
+ * Returns 1 on success, or 0 if a write fails or on platforms without writev.
+ */
+int pbb_writev(const partial_byte_buffer* pbb, int fd);
+
+/**
+ * Replace the growth policy of a buffer.
+ * Returns 1 on success, or 0 for an invalid policy: a fixed increment of 0 or a callback mode without callback.
+ */
+int pbb_set_growth_policy(partial_byte_buffer* pbb, const pbb_growth_policy* policy);
+
+/**
+ * Grow the buffer to hold exactly [bits] more bits after the write cursor, ignoring the growth mode
+ * but not the maximum capacity, so that the following writes of up to [bits] bits never reallocate:
+ *  - owned buffers are reallocated only if their capacity is too small;
+ *  - segmented buffers get the missing segments;
+ *  - borrowed and mapped memory is copied into an owned buffer right away, of its current size or larger,
+ *    as the first write would otherwise do;
+ *  - rings never grow: the result only tells whether [bits] bits are free.
+ * Returns 1 on success, or 0 if the maximum capacity would be exceeded or memory allocation fails.
+ */
+int pbb_reserve(partial_byte_buffer* pbb, size_t bits);
+
 /**
  * Destroy a partial_byte_buffer and free its resources.
  * Sets the pointer to NULL after destruction.
@@ -59,6 +408,7 @@ void pbb_destroy(partial_byte_buffer** pbb);
 
 /**
  * Get the number of bytes that have been written to a partial_byte_buffer.
+ * For a ring buffer, this is the number of bytes holding the bits not read yet.
  */
 size_t pbb_get_length(const partial_byte_buffer* pbb);
 
@@ -92,6 +442,16 @@ void pbb_write_int32(partial_byte_buffer* pbb, int32_t value, uint8_t bits);
  */
 int32_t pbb_read_int32(partial_byte_buffer* pbbr, uint8_t bits);
 
+/**
+ * Write an unsigned 32-bit integer having a length of [bits] (1-32) to the buffer.
+ */
+void pbb_write_uint32(partial_byte_buffer* pbb, uint32_t value, uint8_t bits);
+
+/**
+ * Read an unsigned 32-bit integer having a length of [bits] (1-32) from the buffer, without sign extension.
+ */
+uint32_t pbb_read_uint32(partial_byte_buffer* pbbr, uint8_t bits);
+
 /**
  * Write a single-precision float (32 bits) to the buffer.
  */
@@ -102,6 +462,107 @@ void pbb_write_float(partial_byte_buffer* pbb, float value);
  */
 float pbb_read_float(partial_byte_buffer* pbbr);
 
+/**
+ * Write a double resized to a float of [exp_bits] exponent bits and [mant_bits] mantissa bits,
+ * taking 1 + [exp_bits] + [mant_bits] bits (at most 64) of the buffer. The result is identical to
+ * flr_resize_float_double followed by pbb_write_int64, in a single pass.
+ */
+void pbb_write_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Read a float of [exp_bits] exponent bits and [mant_bits] mantissa bits written by pbb_write_double_as,
+ * expanded back to a double. Returns 0.0 if the buffer runs out of bits.
+ */
+double pbb_read_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Write [count] doubles from [values], each resized as by pbb_write_double_as.
+ * Values are resized by the float kernels and packed by the bit-packing kernels, a block at a time.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Read up to [count] floats of [exp_bits] exponent bits and [mant_bits] mantissa bits into [values],
+ * each expanded back to a double. Returns the number of values read.
+ */
+size_t pbb_read_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Same as pbb_write_double_as, but the mantissa is rounded to nearest even instead of truncated
+ * (see flr_resize_float_double_nearest). The value is read back with pbb_read_double_as.
+ */
+void pbb_write_double_nearest_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Write [count] doubles from [values], each resized as by pbb_write_double_nearest_as.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_double_array_nearest_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Write a non-negative double resized to an unsigned float of [exp_bits] exponent bits and [mant_bits] mantissa bits,
+ * taking [exp_bits] + [mant_bits] bits (at most 63) of the buffer: one bit less than pbb_write_double_as.
+ * Negative values lose their sign and are read back as their magnitude.
+ */
+void pbb_write_unsigned_double_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Read an unsigned float of [exp_bits] exponent bits and [mant_bits] mantissa bits written by
+ * pbb_write_unsigned_double_as, expanded back to a double. Returns 0.0 if the buffer runs out of bits.
+ */
+double pbb_read_unsigned_double_as(partial_byte_buffer* pbbr, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Write [count] doubles from [values], each resized as by pbb_write_unsigned_double_as.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_unsigned_double_array_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Read up to [count] unsigned floats of [exp_bits] exponent bits and [mant_bits] mantissa bits into [values],
+ * each expanded back to a double. Returns the number of values read.
+ */
+size_t pbb_read_unsigned_double_array_as(partial_byte_buffer* pbbr, double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Same as pbb_write_unsigned_double_as and pbb_write_unsigned_double_array_as, but the mantissa is rounded
+ * to nearest even instead of truncated. The values are read back with pbb_read_unsigned_double_as.
+ */
+void pbb_write_unsigned_double_nearest_as(partial_byte_buffer* pbb, double value, uint8_t exp_bits, uint8_t mant_bits);
+size_t pbb_write_unsigned_double_array_nearest_as(partial_byte_buffer* pbb, const double* values, size_t count, uint8_t exp_bits, uint8_t mant_bits);
+
+/**
+ * Read up to [count] floats of the format of [table] (see flr_decode_table_create) into [values].
+ * The codes are unpacked by the bit-packing kernels and expanded by table lookups, with the same results
+ * as pbb_read_double_array_as. Returns the number of values read.
+ */
+size_t pbb_read_double_array_table(partial_byte_buffer* pbbr, const flr_decode_table* table, double* values, size_t count);
+
+/**
+ * Write a double quantized to a code of [format] (see fxp_quantize), taking format->bits bits of the buffer.
+ */
+void pbb_write_double_fixed(partial_byte_buffer* pbb, const fxp_format* format, double value);
+
+/**
+ * Read a code of [format] written by pbb_write_double_fixed, dequantized back to a double.
+ * Returns 0.0 if the buffer runs out of bits.
+ */
+double pbb_read_double_fixed(partial_byte_buffer* pbbr, const fxp_format* format);
+
+/**
+ * Write [count] doubles from [values], each quantized as by pbb_write_double_fixed.
+ * Values are quantized by the vector kernels and packed by the bit-packing kernels, a block at a time.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_double_array_fixed(partial_byte_buffer* pbb, const fxp_format* format, const double* values, size_t count);
+
+/**
+ * Read up to [count] codes of [format] into [values], each dequantized back to a double.
+ * Returns the number of values read.
+ */
+size_t pbb_read_double_array_fixed(partial_byte_buffer* pbbr, const fxp_format* format, double* values, size_t count);
+
 /**
  * Write a 64-bit integer having a length of [bits] (1-64) to the buffer.
  */
@@ -112,6 +573,338 @@ void pbb_write_int64(partial_byte_buffer* pbb, int64_t value, uint8_t bits);
  */
 int64_t pbb_read_int64(partial_byte_buffer* pbbr, uint8_t bits);
 
+/**
+ * Write an unsigned 64-bit integer having a length of [bits] (1-64) to the buffer.
+ */
+void pbb_write_uint64(partial_byte_buffer* pbb, uint64_t value, uint8_t bits);
+
+/**
+ * Read an unsigned 64-bit integer having a length of [bits] (1-64) from the buffer, without sign extension.
+ */
+uint64_t pbb_read_uint64(partial_byte_buffer* pbbr, uint8_t bits);
+
+/**
+ * Write [count] 32-bit integers from [values], each having a length of [bits] (1-32), to the buffer.
+ * Capacity is ensured once for the whole array. The result is identical to calling pbb_write_int32 per value.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_int32_array(partial_byte_buffer* pbb, const int32_t* values, size_t count, uint8_t bits);
+
+/**
+ * Write [count] 64-bit integers from [values], each having a length of [bits] (1-64), to the buffer.
+ * Capacity is ensured once for the whole array. The result is identical to calling pbb_write_int64 per value.
+ * Returns the number of values written: [count], fewer when a ring buffer fills up, or 0 on failure.
+ */
+size_t pbb_write_int64_array(partial_byte_buffer* pbb, const int64_t* values, size_t count, uint8_t bits);
+
+/**
+ * Write [count] unsigned integers from [values], as pbb_write_int32_array and pbb_write_int64_array do.
+ */
+size_t pbb_write_uint32_array(partial_byte_buffer* pbb, const uint32_t* values, size_t count, uint8_t bits);
+size_t pbb_write_uint64_array(partial_byte_buffer* pbb, const uint64_t* values, size_t count, uint8_t bits);
+
+/**
+ * Read up to [count] signed 32-bit integers, each having a length of [bits] (1-32), from the buffer into [values].
+ * Values are decoded with the vector kernels of the running CPU when available.
+ * Returns the number of values read, which is less than [count] when the buffer runs out of whole values.
+ */
+size_t pbb_read_int32_array(partial_byte_buffer* pbbr, int32_t* values, size_t count, uint8_t bits);
+
+/**
+ * Read up to [count] signed 64-bit integers, each having a length of [bits] (1-64), from the buffer into [values].
+ * Values are decoded with the vector kernels of the running CPU when available.
+ * Returns the number of values read, which is less than [count] when the buffer runs out of whole values.
+ */
+size_t pbb_read_int64_array(partial_byte_buffer* pbbr, int64_t* values, size_t count, uint8_t bits);
+
+/**
+ * Read up to [count] unsigned integers, as pbb_read_int32_array and pbb_read_int64_array do
+ * but without sign extension: the kernels shift the fields down logically.
+ * Returns the number of values read.
+ */
+size_t pbb_read_uint32_array(partial_byte_buffer* pbbr, uint32_t* values, size_t count, uint8_t bits);
+size_t pbb_read_uint64_array(partial_byte_buffer* pbbr, uint64_t* values, size_t count, uint8_t bits);
+
+/**
+ * What a delta coder writes for each value after the first one.
+ */
+typedef enum pbb_delta_order {
+    /**
+     * The difference from the previous value, for counters and monotone channels such as distance.
+     */
+    PBB_DELTA = 1,
+    /**
+     * The change of that difference, which is zero for values at a regular interval such as 1 Hz timestamps.
+     */
+    PBB_DELTA_OF_DELTA = 2
+} pbb_delta_order;
+
+/**
+ * State of a delta or delta-of-delta coder of a 64-bit integer channel, built with pbb_delta_coder_init.
+ * The writer and the reader of a channel each keep their own coder, which follows the values coded so far.
+ */
+typedef struct pbb_delta_coder {
+    pbb_delta_order order;
+
+    /**
+     * Number of values coded so far. The first one is written in full, in 64 bits.
+     */
+    uint64_t count;
+
+    /**
+     * Last value and last difference, from which the next value is predicted.
+     */
+    int64_t previous;
+    int64_t previous_delta;
+} pbb_delta_coder;
+
+/**
+ * Start a coder of [order] at the beginning of a channel.
+ */
+void pbb_delta_coder_init(pbb_delta_coder* coder, pbb_delta_order order);
+
+/**
+ * Write [value] with a delta coder, as a code whose width depends on its difference from the prediction
+ * (the residual), in the buckets of the Gorilla time-series encoding:
+ *  '0' for a zero residual, then '10', '110', '1110' and '11110' followed by the residual in 7, 9, 12 and 32 bits
+ *  (two's complement), and '11111' followed by the full 64-bit residual.
+ * Differences wrap around 64 bits, so every value round-trips.
+ * Returns 1, or 0 if the buffer cannot take the code, in which case neither the buffer nor [coder] change.
+ */
+int pbb_write_delta(partial_byte_buffer* pbb, pbb_delta_coder* coder, int64_t value);
+
+/**
+ * Read a value written by pbb_write_delta with a coder of the same order.
+ * Returns 0 if the buffer runs out of bits, in which case neither the buffer nor [coder] change.
+ * The codes carry no count: trailing zero bits of the last byte read as zero residuals,
+ * so the number of values has to be known, e.g. written before them.
+ */
+int64_t pbb_read_delta(partial_byte_buffer* pbbr, pbb_delta_coder* coder);
+
+/**
+ * Write [count] values from [values] with a delta coder, with the same codes as pbb_write_delta.
+ * Residuals are computed a block at a time and their codes are packed before being appended
+ * with the bit-packing kernels. Returns the number of values written: [count], or fewer
+ * when the buffer fills up, in which case [coder] follows the values written.
+ */
+size_t pbb_write_delta_array(partial_byte_buffer* pbb, pbb_delta_coder* coder, const int64_t* values, size_t count);
+
+/**
+ * Read up to [count] values written by pbb_write_delta or pbb_write_delta_array into [values].
+ * Buffers in contiguous memory are decoded with word loads, without checking the buffer per code.
+ * Returns the number of values read.
+ */
+size_t pbb_read_delta_array(partial_byte_buffer* pbbr, pbb_delta_coder* coder, int64_t* values, size_t count);
+
+/**
+ * Get the kernel used by the bulk array functions.
+ * The fastest kernel supported by the CPU is selected when the library is loaded.
+ */
+pbb_kernel pbb_get_kernel(void);
+
+/**
+ * Get the name of the kernel used by the bulk array functions, e.g. "avx2".
+ */
+const char* pbb_get_kernel_name(void);
+
+/**
+ * Select the kernel used by the bulk array functions, e.g. to compare implementations.
+ * Not thread-safe: call it while no other thread uses the library.
+ * Returns 1 on success, or 0 if the CPU does not support [kernel] and the selection is unchanged.
+ */
+int pbb_set_kernel(pbb_kernel kernel);
+
+/**
+ * Functions defined in this header: constexpr in C++14 and later, so that formats known at compile time
+ * are folded into constants, and static inline otherwise.
+ */
+#if defined(__cplusplus) && __cplusplus >= 201402L
+#define FLR_INLINE static constexpr
+#else
+#define FLR_INLINE static inline
+#endif
+
+/**
+ * How a resize narrowing the mantissa handles the dropped bits.
+ */
+typedef enum flr_rounding {
+    /**
+     * Drop them, rounding toward zero: the error stays below one unit in the last place.
+     */
+    FLR_ROUND_TRUNCATE = 0,
+    /**
+     * Round to the nearest value, ties to even, carrying into the exponent when the mantissa overflows:
+     * the error is at most half a unit in the last place, which saves one mantissa bit for the same precision.
+     */
+    FLR_ROUND_NEAREST_EVEN = 1
+} flr_rounding;
+
+/**
+ * Precomputed constants of a float resize from a source format to a destination format,
+ * each defined by its number of exponent bits and mantissa bits. Built once with flr_format_init,
+ * it turns every conversion into a few shifts and masks.
+ */
+typedef struct flr_format {
+    /**
+     * Shifts bringing the source exponent and sign down to bit 0, and the destination ones up from it.
+     */
+    uint8_t src_mant_bits;
+    uint8_t src_sign_shift;
+    uint8_t dst_mant_bits;
+    uint8_t dst_sign_shift;
+
+    /**
+     * Shifts widening or narrowing the mantissa; at most one is not zero.
+     */
+    uint8_t mant_shift_left;
+    uint8_t mant_shift_right;
+
+    uint64_t src_exp_mask;
+    uint64_t src_mant_mask;
+    uint64_t dst_exp_mask;
+    uint64_t dst_mant_mask;
+
+    /**
+     * Rebias added to a source exponent (destination bias minus source bias, modulo 2^64).
+     */
+    uint64_t exp_offset;
+
+    /**
+     * Destination exponent of a zero source exponent: zero, or the exponent of 1.0
+     * when the source has no exponent bits.
+     */
+    uint64_t zero_exponent;
+
+    /**
+     * 1 when the sign bit is carried over, or 0 when either format has no sign bit.
+     */
+    uint64_t sign_mask;
+
+    /**
+     * Constants of the round to nearest even (see flr_format_set_rounding), all zero when truncating:
+     * the mask of the dropped mantissa bits, half their range minus one, and 1 to add the last kept bit for ties.
+     */
+    uint64_t round_mask;
+    uint64_t round_half;
+    uint64_t round_bit;
+} flr_format;
+
+/**
+ * Build the descriptor of a resize between two formats, each of them signed or unsigned.
+ * An unsigned format has no sign bit: its values take [exp_bits] + [mant_bits] bits, and resizing a value
+ * to it drops the sign, so that negative values come back as their magnitude.
+ * Each format needs at most 63 exponent and mantissa bits together.
+ * Returns 1 on success, or 0 for an invalid format, in which case [format] must not be used.
+ */
+FLR_INLINE int flr_format_init_signs(
+    flr_format* format,
+    int src_exp_bits, int src_mant_bits, int src_signed,
+    int dst_exp_bits, int dst_mant_bits, int dst_signed
+) {
+    int valid = src_exp_bits >= 0 && src_mant_bits >= 0 && src_exp_bits + src_mant_bits <= 63
+        && dst_exp_bits >= 0 && dst_mant_bits >= 0 && dst_exp_bits + dst_mant_bits <= 63;
+    // Invalid formats are built as empty ones, keeping every shift defined
+    if (!valid) src_exp_bits = src_mant_bits = dst_exp_bits = dst_mant_bits = 0;
+
+    uint64_t src_exp_mask = ((uint64_t)1 << src_exp_bits) - 1;
+    uint64_t dst_exp_mask = ((uint64_t)1 << dst_exp_bits) - 1;
+    uint64_t dst_bias = dst_exp_mask >> 1;
+    int mant_bits_diff = dst_mant_bits - src_mant_bits;
+
+    format->src_mant_bits = (uint8_t)src_mant_bits;
+    format->src_sign_shift = (uint8_t)(src_exp_bits + src_mant_bits);
+    format->dst_mant_bits = (uint8_t)dst_mant_bits;
+    format->dst_sign_shift = (uint8_t)(dst_exp_bits + dst_mant_bits);
+    format->mant_shift_left = (uint8_t)(mant_bits_diff > 0 ? mant_bits_diff : 0);
+    format->mant_shift_right = (uint8_t)(mant_bits_diff < 0 ? -mant_bits_diff : 0);
+    format->src_exp_mask = src_exp_mask;
+    format->src_mant_mask = ((uint64_t)1 << src_mant_bits) - 1;
+    format->dst_exp_mask = dst_exp_mask;
+    format->dst_mant_mask = ((uint64_t)1 << dst_mant_bits) - 1;
+    format->exp_offset = dst_bias - (src_exp_mask >> 1);
+
+    // Without source exponent bits every value is taken as a mantissa of 1.x
+    format->zero_exponent = src_exp_bits == 0 ? (1 + dst_bias) & dst_exp_mask : 0;
+    format->sign_mask = src_signed && dst_signed ? 1 : 0;
+    format->round_mask = 0;
+    format->round_half = 0;
+    format->round_bit = 0;
+
+    return valid;
+}
+
+/**
+ * Build the descriptor of a resize between two signed formats. Each format needs at most 63 exponent
+ * and mantissa bits together, so that the sign bit fits in 64 bits.
+ * Returns 1 on success, or 0 for an invalid format, in which case [format] must not be used.
+ */
+FLR_INLINE int flr_format_init(
+    flr_format* format,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+) {
+    return flr_format_init_signs(format, src_exp_bits, src_mant_bits, 1, dst_exp_bits, dst_mant_bits, 1);
+}
+
+/**
+ * Set how a descriptor built by flr_format_init narrows the mantissa: truncated, as by default,
+ * or rounded to nearest even. Rounding has no effect when the destination mantissa is not narrower.
+ * Infinities, NaNs, zeros and subnormals are never rounded, so that a subnormal never carries into a normal exponent,
+ * and a value is never rounded past the largest code of the destination
+ * exponent and mantissa bits, so that a carry can turn the largest finite values into infinity but never wraps.
+ */
+FLR_INLINE void flr_format_set_rounding(flr_format* format, flr_rounding rounding) {
+    int nearest = rounding == FLR_ROUND_NEAREST_EVEN && format->mant_shift_right > 0;
+    format->round_mask = nearest ? ((uint64_t)1 << format->mant_shift_right) - 1 : 0;
+    format->round_half = nearest ? ((uint64_t)1 << (format->mant_shift_right - 1)) - 1 : 0;
+    format->round_bit = nearest ? 1 : 0;
+}
+
+/**
+ * Resize a floating point number in its binary representation with a descriptor built by flr_format_init.
+ * Same result as flr_resize_float_long with the formats of the descriptor, or flr_resize_float_long_nearest
+ * when it rounds to nearest even.
+ */
+FLR_INLINE uint64_t flr_resize(const flr_format* format, uint64_t src) {
+    uint64_t src_exponent = (src >> format->src_mant_bits) & format->src_exp_mask;
+    uint64_t dst_exponent = src_exponent == 0 ? format->zero_exponent
+        : src_exponent == format->src_exp_mask ? format->dst_exp_mask
+        : (src_exponent + format->exp_offset) & format->dst_exp_mask;
+
+    uint64_t dst_mant = ((src & format->src_mant_mask) << format->mant_shift_left >> format->mant_shift_right)
+        & format->dst_mant_mask;
+    uint64_t dst_sign = (src >> format->src_sign_shift) & format->sign_mask;
+    uint64_t dst_body = (dst_exponent << format->dst_mant_bits) | dst_mant;
+
+    if (format->round_bit) {
+        // Dropped bits above half, or exactly half with an odd last bit, carry into the mantissa and on into the exponent
+        uint64_t carry = ((src & format->round_mask) + format->round_half + ((src >> format->mant_shift_right) & 1))
+            >> format->mant_shift_right;
+        uint64_t body_mask = (format->dst_exp_mask << format->dst_mant_bits) | format->dst_mant_mask;
+        // Without source exponent bits, a zero exponent stands for the normal 1.x values and is rounded as well
+        int special = format->src_exp_mask != 0 && (src_exponent == 0 || src_exponent == format->src_exp_mask);
+        if (!special && dst_body != body_mask) dst_body += carry;
+    }
+
+    return (dst_sign << format->dst_sign_shift) | dst_body;
+}
+
+/**
+ * A convenience wrapper of flr_resize that accepts double instead of uint64_t.
+ */
+uint64_t flr_resize_double(const flr_format* format, double src);
+
+/**
+ * Resize [count] floating point numbers in their binary representation with a descriptor,
+ * as flr_resize_long_array does. [src] and [dst] may be the same array.
+ */
+void flr_resize_array(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count);
+
+/**
+ * A convenience wrapper of flr_resize_array that accepts an array of double instead of uint64_t.
+ */
+void flr_resize_array_double(const flr_format* format, const double* src, uint64_t* dst, size_t count);
+
 /**
  * Resize a floating point number from source format to destination format.
  * The formats are defined by the number of exponent bits and mantissa bits. 
@@ -134,4 +927,272 @@ uint64_t flr_resize_float_double(
     int dst_exp_bits, int dst_mant_bits
 );
 
+/**
+ * Same as flr_resize_float_long, but the mantissa is rounded to nearest even instead of truncated
+ * (see flr_format_set_rounding), halving the worst-case error.
+ */
+uint64_t flr_resize_float_long_nearest(
+    uint64_t src,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * A convenience wrapper of flr_resize_float_long_nearest that accepts double instead of uint64_t.
+ */
+uint64_t flr_resize_float_double_nearest(
+    double src,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * Resize [count] floating point numbers in their binary representation from the source format
+ * to the destination format, as flr_resize_float_long does for each of them.
+ * The format constants are computed once, and the values are converted by the kernel in use
+ * (see pbb_set_kernel), several at a time with AVX2 or AVX-512. [src] and [dst] may be the same array.
+ */
+void flr_resize_long_array(
+    const uint64_t* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * A convenience wrapper of flr_resize_long_array that accepts an array of double instead of uint64_t.
+ */
+void flr_resize_double_array(
+    const double* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * Resize [count] floating point numbers as flr_resize_long_array does, rounding each mantissa
+ * to nearest even as flr_resize_float_long_nearest does.
+ */
+void flr_resize_long_array_nearest(
+    const uint64_t* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * A convenience wrapper of flr_resize_long_array_nearest that accepts an array of double instead of uint64_t.
+ */
+void flr_resize_double_array_nearest(
+    const double* src, uint64_t* dst, size_t count,
+    int src_exp_bits, int src_mant_bits,
+    int dst_exp_bits, int dst_mant_bits
+);
+
+/**
+ * Narrowest float format holding a column of values within a precision, chosen by flr_select_format.
+ */
+typedef struct flr_format_spec {
+    uint8_t exp_bits;
+    uint8_t mant_bits;
+
+    /**
+     * 1, or 0 when the sign bit may be dropped: unsigned formats were allowed and no value is below zero.
+     */
+    uint8_t sign_bits;
+} flr_format_spec;
+
+/**
+ * Choose the narrowest format into which every value of [samples] resizes (see flr_resize_float_double)
+ * and expands back within [precision] of itself. The exponent bits cover the range of all the normal values,
+ * and the mantissa bits are the fewest for which the truncation error stays below [precision],
+ * up to the 52 bits of a double. With [allow_unsigned], the sign bit is dropped for columns without negative values,
+ * to be written with pbb_write_unsigned_double_as.
+ * The samples are scanned with the vector kernels. Returns 1 on success, or 0 for an invalid precision.
+ */
+int flr_select_format(const double* samples, size_t count, double precision, int allow_unsigned, flr_format_spec* spec);
+
+/**
+ * Same as flr_select_format for values kept to [decimals] decimal places, i.e. within half a unit of the last one.
+ */
+int flr_select_format_decimals(const double* samples, size_t count, int decimals, int allow_unsigned, flr_format_spec* spec);
+
+/**
+ * Same as flr_select_format for values resized with rounding to nearest even (see flr_resize_float_double_nearest),
+ * to be written with pbb_write_double_nearest_as. The error is at most half a unit in the last place,
+ * so the format usually takes one mantissa bit less. The exponent range keeps room for the largest values
+ * rounding up to the next power of two. Unsigned formats are written with pbb_write_unsigned_double_nearest_as.
+ */
+int flr_select_format_nearest(const double* samples, size_t count, double precision, int allow_unsigned, flr_format_spec* spec);
+
+/**
+ * Same as flr_select_format_nearest for values kept to [decimals] decimal places.
+ */
+int flr_select_format_decimals_nearest(const double* samples, size_t count, int decimals, int allow_unsigned, flr_format_spec* spec);
+
+/**
+ * Convert a float to IEEE binary16 (5 exponent bits, 10 mantissa bits), rounding to nearest even.
+ * Unlike flr_resize_float_long, values out of range become infinity or subnormals, as with F16C.
+ */
+uint16_t flr_float_to_half(float src);
+
+/**
+ * Convert IEEE binary16 to the float of the same value.
+ */
+float flr_half_to_float(uint16_t src);
+
+/**
+ * Convert a float to bfloat16 (8 exponent bits, 7 mantissa bits), rounding to nearest even.
+ * Subnormal floats become zero, as with AVX-512 BF16.
+ */
+uint16_t flr_float_to_bfloat16(float src);
+
+/**
+ * Convert bfloat16 to the float of the same value.
+ */
+float flr_bfloat16_to_float(uint16_t src);
+
+/**
+ * Convert [count] floats to IEEE binary16 with the F16C instructions when available,
+ * with the same results as flr_float_to_half.
+ */
+void flr_float_to_half_array(const float* src, uint16_t* dst, size_t count);
+
+/**
+ * Convert [count] IEEE binary16 values to floats with the F16C instructions when available.
+ */
+void flr_half_to_float_array(const uint16_t* src, float* dst, size_t count);
+
+/**
+ * Convert [count] floats to bfloat16 with the AVX-512 BF16 instructions when available,
+ * with the same results as flr_float_to_bfloat16.
+ */
+void flr_float_to_bfloat16_array(const float* src, uint16_t* dst, size_t count);
+
+/**
+ * Convert [count] bfloat16 values to floats.
+ */
+void flr_bfloat16_to_float_array(const uint16_t* src, float* dst, size_t count);
+
+/**
+ * Largest float, sign included, that a decode table can expand: 2^16 doubles take 512 KiB.
+ */
+#define FLR_DECODE_TABLE_MAX_BITS 16
+
+/**
+ * Build the decode table of floats of [exp_bits] exponent bits and [mant_bits] mantissa bits,
+ * each entry being the result of flr_resize_float_long to a double. Build it once per format and share it:
+ * the table is only read afterwards.
+ * Returns NULL if the format takes more than FLR_DECODE_TABLE_MAX_BITS bits or if memory allocation fails.
+ */
+flr_decode_table* flr_decode_table_create(int exp_bits, int mant_bits);
+
+/**
+ * Expand a float of the table format to a double. Bits above the format are ignored.
+ */
+double flr_decode(const flr_decode_table* table, uint64_t src);
+
+/**
+ * Expand [count] floats of the table format to doubles, one lookup each.
+ */
+void flr_decode_array(const flr_decode_table* table, const uint64_t* src, double* dst, size_t count);
+
+/**
+ * Destroy a decode table. Sets the pointer to NULL after destruction.
+ */
+void flr_decode_table_destroy(flr_decode_table** table);
+
+/**
+ * Maximum number of bits of a fixed-point code, so that every code is exact as a double.
+ */
+#define FXP_MAX_BITS 52
+
+/**
+ * Constants of a fixed-point format, built once with fxp_format_init.
+ */
+struct fxp_format {
+    /**
+     * Value of code 0, and distance between two consecutive codes.
+     */
+    double min;
+    double step;
+
+    /**
+     * Reciprocal of the step, by which values are scaled to codes.
+     */
+    double scale;
+
+    /**
+     * Largest code, the one of the top of the range, also as a double to clamp scaled values.
+     */
+    uint64_t max_code;
+    double code_limit;
+
+    /**
+     * Number of bits of a code (1 to FXP_MAX_BITS), and the mask of them.
+     */
+    uint8_t bits;
+    uint64_t code_mask;
+};
+
+/**
+ * Build the fixed-point format of values from [min] to [max] kept to multiples of [step] above [min],
+ * such as longitudes from -180 to 180 with a step of 0.00001: codes count the steps from [min],
+ * and take just enough bits for the code of [max]. With a uniform precision this is often narrower than
+ * a float format (see flr_select_format), and quantizing is a multiplication and a rounding.
+ * Returns 1 on success, or 0 when a bound is not finite, [max] is below [min], [step] is not positive,
+ * or the codes need more than FXP_MAX_BITS bits, in which case [format] must not be used.
+ */
+int fxp_format_init(fxp_format* format, double min, double max, double step);
+
+/**
+ * Quantize [value] to the code of the nearest step of [format], ties to even. Values out of the range
+ * are clamped to its bounds, and NaN becomes code 0. The value is scaled by the reciprocal of the step,
+ * so a value exactly halfway between two steps may go either way.
+ */
+uint64_t fxp_quantize(const fxp_format* format, double value);
+
+/**
+ * Dequantize a code of [format] back to [min] + code * [step]. Bits above the code bits are ignored.
+ */
+double fxp_dequantize(const fxp_format* format, uint64_t code);
+
+/**
+ * Quantize [count] values of [src] into [dst] as fxp_quantize does, several at a time with AVX2 or AVX-512.
+ */
+void fxp_quantize_array(const fxp_format* format, const double* src, uint64_t* dst, size_t count);
+
+/**
+ * Dequantize [count] codes of [src] into [dst] as fxp_dequantize does, several at a time with AVX2 or AVX-512.
+ */
+void fxp_dequantize_array(const fxp_format* format, const uint64_t* src, double* dst, size_t count);
+
+#if defined(__cplusplus) && __cplusplus >= 201402L
+/**
+ * Descriptor of a resize whose formats are template parameters: the constants are built at compile time,
+ * so flr_static_format<11, 52, 6, 25>::resize(bits) compiles to a handful of branch-free instructions.
+ * flr_static_format<11, 52, 6, 24, FLR_ROUND_NEAREST_EVEN> rounds the mantissa instead of truncating it.
+ */
+template <int SrcExpBits, int SrcMantBits, int DstExpBits, int DstMantBits, flr_rounding Rounding = FLR_ROUND_TRUNCATE>
+struct flr_static_format {
+    static_assert(SrcExpBits >= 0 && SrcMantBits >= 0 && SrcExpBits + SrcMantBits <= 63, "invalid source format");
+    static_assert(DstExpBits >= 0 && DstMantBits >= 0 && DstExpBits + DstMantBits <= 63, "invalid destination format");
+
+    static constexpr flr_format make() {
+        flr_format format = {};
+        flr_format_init(&format, SrcExpBits, SrcMantBits, DstExpBits, DstMantBits);
+        flr_format_set_rounding(&format, Rounding);
+        return format;
+    }
+
+    static constexpr flr_format format = make();
+
+    static constexpr uint64_t resize(uint64_t src) {
+        return flr_resize(&format, src);
+    }
+};
+
+#if __cplusplus < 201703L
+template <int SrcExpBits, int SrcMantBits, int DstExpBits, int DstMantBits, flr_rounding Rounding>
+constexpr flr_format flr_static_format<SrcExpBits, SrcMantBits, DstExpBits, DstMantBits, Rounding>::format;
+#endif
+#endif
+
 #endif // PARTIAL_BYTE_BUFFER_H
@@ -0,0 +1,1159 @@
+#include "pbb_kernels.h"
+
+#if PBB_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+/**
+ * Portable loops. They are inlined into the scalar kernels, and into the BMI2 kernels for the fields
+ * those do not gather, where the compiler turns every variable shift into a flag-free shlx/shrx/sarx.
+ */
+static ALWAYS_INLINE void pack_int32_loop(uint8_t* dst, uint8_t bit_offset, const int32_t* values, size_t count, uint8_t bits) {
+    uint64_t mask = ((uint64_t)1 << bits) - 1;
+    bit_packer packer;
+    packer_begin(&packer, dst, bit_offset);
+    for (size_t i = 0; i < count; ++i) {
+        packer_put(&packer, (uint32_t)values[i] & mask, bits);
+    }
+    packer_end(&packer);
+}
+
+static ALWAYS_INLINE void pack_int64_loop(uint8_t* dst, uint8_t bit_offset, const int64_t* values, size_t count, uint8_t bits) {
+    uint64_t mask = (uint64_t)-1 >> (64 - bits);
+    bit_packer packer;
+    packer_begin(&packer, dst, bit_offset);
+    for (size_t i = 0; i < count; ++i) {
+        packer_put(&packer, (uint64_t)values[i] & mask, bits);
+    }
+    packer_end(&packer);
+}
+
+static ALWAYS_INLINE void unpack_int32_loop(const uint8_t* src, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t pos = bit_offset;
+    for (size_t i = 0; i < count; ++i, pos += bits) {
+        // A field of at most 32 bits always fits the window after dropping up to 7 leading bits
+        uint64_t window = load_be64(src + (pos >> 3)) << (pos & 7);
+        values[i] = sign_extend ? (int32_t)((int64_t)window >> (64 - bits)) : (int32_t)(window >> (64 - bits));
+    }
+}
+
+static ALWAYS_INLINE void unpack_int64_loop(const uint8_t* src, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t pos = bit_offset;
+    for (size_t i = 0; i < count; ++i, pos += bits) {
+        const uint8_t* word = src + (pos >> 3);
+        uint8_t bit_pos = pos & 7;
+        uint64_t window = load_be64(word) << bit_pos;
+        if (bit_pos + bits > 64) {
+            window |= word[8] >> (8 - bit_pos);
+        }
+        values[i] = sign_extend ? (int64_t)window >> (64 - bits) : (int64_t)(window >> (64 - bits));
+    }
+}
+
+static void pack_int32_scalar(uint8_t* dst, uint8_t bit_offset, const int32_t* values, size_t count, uint8_t bits) {
+    pack_int32_loop(dst, bit_offset, values, count, bits);
+}
+
+static void pack_int64_scalar(uint8_t* dst, uint8_t bit_offset, const int64_t* values, size_t count, uint8_t bits) {
+    pack_int64_loop(dst, bit_offset, values, count, bits);
+}
+
+static void unpack_int32_scalar(const uint8_t* src, size_t src_len, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    (void)src_len;
+    if (sign_extend) {
+        unpack_int32_loop(src, bit_offset, values, count, bits, 1);
+    } else {
+        unpack_int32_loop(src, bit_offset, values, count, bits, 0);
+    }
+}
+
+static void unpack_int64_scalar(const uint8_t* src, size_t src_len, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    (void)src_len;
+    if (sign_extend) {
+        unpack_int64_loop(src, bit_offset, values, count, bits, 1);
+    } else {
+        unpack_int64_loop(src, bit_offset, values, count, bits, 0);
+    }
+}
+
+static ALWAYS_INLINE void resize_float_loop(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint64_t value;
+        memcpy(&value, src + i, sizeof(value));
+        dst[i] = flr_resize(format, value);
+    }
+}
+
+static void resize_float_scalar(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count) {
+    resize_float_loop(format, src, dst, count, 0);
+}
+
+static ALWAYS_INLINE void float_to_half_loop(const float* src, uint16_t* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint32_t bits;
+        memcpy(&bits, src + i, sizeof(bits));
+        dst[i] = float_bits_to_half(bits);
+    }
+}
+
+static ALWAYS_INLINE void half_to_float_loop(const uint16_t* src, float* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint32_t bits = half_to_float_bits(src[i]);
+        memcpy(dst + i, &bits, sizeof(bits));
+    }
+}
+
+static ALWAYS_INLINE void float_to_bfloat16_loop(const float* src, uint16_t* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint32_t bits;
+        memcpy(&bits, src + i, sizeof(bits));
+        dst[i] = float_bits_to_bfloat16(bits);
+    }
+}
+
+static ALWAYS_INLINE void bfloat16_to_float_loop(const uint16_t* src, float* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint32_t bits = bfloat16_to_float_bits(src[i]);
+        memcpy(dst + i, &bits, sizeof(bits));
+    }
+}
+
+static void float_to_half_scalar(const float* src, uint16_t* dst, size_t count) {
+    float_to_half_loop(src, dst, count, 0);
+}
+
+static void half_to_float_scalar(const uint16_t* src, float* dst, size_t count) {
+    half_to_float_loop(src, dst, count, 0);
+}
+
+static void float_to_bfloat16_scalar(const float* src, uint16_t* dst, size_t count) {
+    float_to_bfloat16_loop(src, dst, count, 0);
+}
+
+static void bfloat16_to_float_scalar(const uint16_t* src, float* dst, size_t count) {
+    bfloat16_to_float_loop(src, dst, count, 0);
+}
+
+static ALWAYS_INLINE void scan_float_loop(const double* src, size_t count, float_scan* scan, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        uint64_t bits;
+        memcpy(&bits, src + i, sizeof(bits));
+        uint64_t exponent = (bits >> 52) & 0x7FF;
+        if (exponent != 0 && exponent != 0x7FF) {
+            scan->min_exponent = exponent < scan->min_exponent ? exponent : scan->min_exponent;
+            scan->max_exponent = exponent > scan->max_exponent ? exponent : scan->max_exponent;
+        }
+        scan->negative |= src[i] < 0.0;
+    }
+}
+
+static void scan_float_scalar(const double* src, size_t count, float_scan* scan) {
+    scan_float_loop(src, count, scan, 0);
+}
+
+static ALWAYS_INLINE void quantize_loop(const fxp_format* format, const double* src, uint64_t* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        dst[i] = quantize_value(format, src[i]);
+    }
+}
+
+static ALWAYS_INLINE void dequantize_loop(const fxp_format* format, const uint64_t* src, double* dst, size_t count, size_t done) {
+    for (size_t i = done; i < count; ++i) {
+        dst[i] = dequantize_value(format, src[i]);
+    }
+}
+
+static void quantize_scalar(const fxp_format* format, const double* src, uint64_t* dst, size_t count) {
+    quantize_loop(format, src, dst, count, 0);
+}
+
+static void dequantize_scalar(const fxp_format* format, const uint64_t* src, double* dst, size_t count) {
+    dequantize_loop(format, src, dst, count, 0);
+}
+
+static const pbb_kernel_table SCALAR_KERNELS = {
+    PBB_KERNEL_SCALAR, "scalar",
+    pack_int32_scalar, pack_int64_scalar,
+    unpack_int32_scalar, unpack_int64_scalar,
+    resize_float_scalar,
+    float_to_half_scalar, half_to_float_scalar,
+    float_to_bfloat16_scalar, bfloat16_to_float_scalar,
+    scan_float_scalar,
+    quantize_scalar, dequantize_scalar
+};
+
+const pbb_kernel_table* pbb_kernels = &SCALAR_KERNELS;
+
+#if PBB_X86_KERNELS
+
+/**
+ * BMI2 kernels: fields of up to 32 bits move two at a time between a run of 2 x [bits] packed bits
+ * and the two 32-bit lanes of a register, with one pext or pdep. The first field of a run takes the high lane,
+ * so a rotation by 32 puts two consecutive int32 values in their memory order. Wider int64 fields use the loops.
+ */
+static inline uint64_t pair_mask(uint8_t bits) {
+    uint64_t lane = ((uint64_t)1 << bits) - 1;
+    return lane << 32 | lane;
+}
+
+static inline uint64_t swap_lanes(uint64_t lanes) {
+    return lanes << 32 | lanes >> 32;
+}
+
+/**
+ * Extend the sign of the [bits]-bit field (1-32) at the bottom of each 32-bit lane to the whole lane.
+ * Each lane with its sign bit set gets the bits from [bits] to its top, as the difference of two powers of 2;
+ * the high lane's upper power of 2 is past bit 63, so its difference wraps to the same bits.
+ */
+static inline uint64_t pair_sign_extend(uint64_t lanes, uint8_t bits) {
+    uint64_t signs = lanes & ((uint64_t)1 << (bits - 1)) * (((uint64_t)1 << 32) | 1);
+    return lanes | (((signs >> (bits - 1)) << 32) - (signs << 1));
+}
+
+/**
+ * Load the run of 2 x [bits] bits (1-32) starting at bit [pos] of [src], aligned to the least significant end.
+ */
+static inline uint64_t load_pair_run(const uint8_t* src, size_t pos, uint8_t bits) {
+    const uint8_t* word = src + (pos >> 3);
+    uint8_t bit_pos = pos & 7;
+    uint8_t run_bits = 2 * bits;
+    uint64_t window = load_be64(word) << bit_pos;
+    if (bit_pos + run_bits > 64) {
+        window |= word[8] >> (8 - bit_pos);
+    }
+    return window >> (64 - run_bits);
+}
+
+__attribute__((target("bmi2")))
+static ALWAYS_INLINE void unpack_int32_pairs(const uint8_t* src, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    uint64_t mask = pair_mask(bits);
+    size_t pos = bit_offset;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, pos += 2 * bits) {
+        uint64_t lanes = _pdep_u64(load_pair_run(src, pos, bits), mask);
+        if (sign_extend) lanes = pair_sign_extend(lanes, bits);
+        lanes = swap_lanes(lanes);
+        memcpy(values + i, &lanes, sizeof(lanes));
+    }
+
+    unpack_int32_loop(src + (pos >> 3), pos & 7, values + i, count - i, bits, sign_extend);
+}
+
+__attribute__((target("bmi2")))
+static ALWAYS_INLINE void unpack_int64_pairs(const uint8_t* src, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    uint64_t mask = pair_mask(bits);
+    size_t pos = bit_offset;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, pos += 2 * bits) {
+        uint64_t lanes = _pdep_u64(load_pair_run(src, pos, bits), mask);
+        if (sign_extend) {
+            lanes = pair_sign_extend(lanes, bits);
+            values[i] = (int32_t)(lanes >> 32);
+            values[i + 1] = (int32_t)lanes;
+        } else {
+            values[i] = (int64_t)(lanes >> 32);
+            values[i + 1] = (int64_t)(uint32_t)lanes;
+        }
+    }
+
+    unpack_int64_loop(src + (pos >> 3), pos & 7, values + i, count - i, bits, sign_extend);
+}
+
+__attribute__((target("bmi2")))
+static void pack_int32_bmi2(uint8_t* dst, uint8_t bit_offset, const int32_t* values, size_t count, uint8_t bits) {
+    uint64_t mask = pair_mask(bits);
+    bit_packer packer;
+    packer_begin(&packer, dst, bit_offset);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64_t pair;
+        memcpy(&pair, values + i, sizeof(pair));
+        packer_put(&packer, _pext_u64(swap_lanes(pair), mask), 2 * bits);
+    }
+    if (i < count) {
+        packer_put(&packer, (uint32_t)values[i] & (uint32_t)mask, bits);
+    }
+
+    packer_end(&packer);
+}
+
+__attribute__((target("bmi2")))
+static void pack_int64_bmi2(uint8_t* dst, uint8_t bit_offset, const int64_t* values, size_t count, uint8_t bits) {
+    if (bits > 32) {
+        pack_int64_loop(dst, bit_offset, values, count, bits);
+        return;
+    }
+
+    uint64_t mask = pair_mask(bits);
+    bit_packer packer;
+    packer_begin(&packer, dst, bit_offset);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64_t pair = (uint64_t)(uint32_t)values[i] << 32 | (uint32_t)values[i + 1];
+        packer_put(&packer, _pext_u64(pair, mask), 2 * bits);
+    }
+    if (i < count) {
+        packer_put(&packer, (uint32_t)values[i] & (uint32_t)mask, bits);
+    }
+
+    packer_end(&packer);
+}
+
+__attribute__((target("bmi2")))
+static void unpack_int32_bmi2(const uint8_t* src, size_t src_len, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    (void)src_len;
+    if (sign_extend) {
+        unpack_int32_pairs(src, bit_offset, values, count, bits, 1);
+    } else {
+        unpack_int32_pairs(src, bit_offset, values, count, bits, 0);
+    }
+}
+
+__attribute__((target("bmi2")))
+static void unpack_int64_bmi2(const uint8_t* src, size_t src_len, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    (void)src_len;
+    if (bits > 32) {
+        if (sign_extend) {
+            unpack_int64_loop(src, bit_offset, values, count, bits, 1);
+        } else {
+            unpack_int64_loop(src, bit_offset, values, count, bits, 0);
+        }
+    } else if (sign_extend) {
+        unpack_int64_pairs(src, bit_offset, values, count, bits, 1);
+    } else {
+        unpack_int64_pairs(src, bit_offset, values, count, bits, 0);
+    }
+}
+
+/**
+ * Widest fields the vector unpack kernels decode: a field starting at bit 7 of its first byte
+ * must still end inside a lane loaded from that byte.
+ */
+static const uint8_t VECTOR_MAX_BITS_INT32 = 32 - 7;
+static const uint8_t VECTOR_MAX_BITS_INT64 = 64 - 7;
+
+/**
+ * Fields of a group of 8 values always take exactly [bits] bytes, so the byte and bit layout
+ * of a group is the same for every group of a call. It is described by 16-byte chunks,
+ * each chunk holding the lanes of one 128-bit vector.
+ */
+typedef struct unpack_layout {
+    /**
+     * Byte offset of every chunk from the first byte of the group.
+     */
+    size_t chunk_byte[4];
+
+    /**
+     * Byte shuffle moving the bytes of each lane into a big-endian lane, per chunk.
+     */
+    uint8_t shuffle[4][16];
+
+    /**
+     * Left shift placing the first bit of each field at the top of its lane, per chunk.
+     */
+    uint8_t shift[4][4];
+
+    /**
+     * Offset from the first byte of the group past the last byte any chunk loads.
+     */
+    size_t load_end;
+} unpack_layout;
+
+/**
+ * Describe the chunks of a group whose first field starts [bit_offset] (0-7) bits into its first byte.
+ * @param lane_bytes Width of a lane, 4 for int32 or 8 for int64.
+ */
+static void build_layout(unpack_layout* layout, uint8_t bit_offset, uint8_t bits, uint8_t lane_bytes) {
+    uint8_t lanes = 16 / lane_bytes;
+    uint8_t chunks = 8 / lanes;
+
+    for (uint8_t c = 0; c < chunks; ++c) {
+        size_t chunk_pos = bit_offset + (size_t)c * lanes * bits;
+        layout->chunk_byte[c] = chunk_pos >> 3;
+
+        for (uint8_t lane = 0; lane < lanes; ++lane) {
+            size_t field_pos = (chunk_pos & 7) + (size_t)lane * bits;
+            uint8_t first_byte = (uint8_t)(field_pos >> 3);
+            layout->shift[c][lane] = field_pos & 7;
+
+            // Reverse the lane's bytes: the lowest lane byte takes the last source byte
+            for (uint8_t b = 0; b < lane_bytes; ++b) {
+                layout->shuffle[c][lane * lane_bytes + b] = first_byte + lane_bytes - 1 - b;
+            }
+        }
+    }
+    layout->load_end = layout->chunk_byte[chunks - 1] + 16;
+}
+
+/**
+ * Decode the values left over by a vector kernel, starting with value [done].
+ */
+static void unpack_int32_tail(const uint8_t* src, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend, size_t done) {
+    size_t pos = bit_offset + done * bits;
+    unpack_int32_loop(src + (pos >> 3), pos & 7, values + done, count - done, bits, sign_extend);
+}
+
+static void unpack_int64_tail(const uint8_t* src, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend, size_t done) {
+    size_t pos = bit_offset + done * bits;
+    unpack_int64_loop(src + (pos >> 3), pos & 7, values + done, count - done, bits, sign_extend);
+}
+
+__attribute__((target("sse4.1")))
+static void unpack_int32_sse41(const uint8_t* src, size_t src_len, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT32) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 4);
+
+        __m128i shuffle[2], multiplier[2];
+        for (int c = 0; c < 2; ++c) {
+            shuffle[c] = _mm_loadu_si128((const __m128i*)layout.shuffle[c]);
+            // SSE4.1 has no per-lane shift; multiplying by 2^shift does the same
+            multiplier[c] = _mm_setr_epi32(
+                1 << layout.shift[c][0], 1 << layout.shift[c][1],
+                1 << layout.shift[c][2], 1 << layout.shift[c][3]
+            );
+        }
+        __m128i field_shift = _mm_cvtsi32_si128(32 - bits);
+
+        for (size_t p = 0; i + 8 <= count && p + layout.load_end <= src_len; i += 8, p += bits) {
+            for (int c = 0; c < 2; ++c) {
+                __m128i lanes = _mm_loadu_si128((const __m128i*)(src + p + layout.chunk_byte[c]));
+                lanes = _mm_shuffle_epi8(lanes, shuffle[c]);
+                lanes = _mm_mullo_epi32(lanes, multiplier[c]);
+                lanes = sign_extend ? _mm_sra_epi32(lanes, field_shift) : _mm_srl_epi32(lanes, field_shift);
+                _mm_storeu_si128((__m128i*)(values + i + 4 * c), lanes);
+            }
+        }
+    }
+
+    unpack_int32_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+__attribute__((target("sse4.1")))
+static void unpack_int64_sse41(const uint8_t* src, size_t src_len, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT64) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 8);
+
+        __m128i shuffle[4], shift_lo[4], shift_hi[4];
+        for (int c = 0; c < 4; ++c) {
+            shuffle[c] = _mm_loadu_si128((const __m128i*)layout.shuffle[c]);
+            shift_lo[c] = _mm_cvtsi32_si128(layout.shift[c][0]);
+            shift_hi[c] = _mm_cvtsi32_si128(layout.shift[c][1]);
+        }
+        __m128i field_shift = _mm_cvtsi32_si128(64 - bits);
+        // Sign extension of a right-aligned field: (x ^ m) - m, m being the field's sign bit
+        __m128i sign_bit = _mm_set1_epi64x((int64_t)1 << (bits - 1));
+
+        for (size_t p = 0; i + 8 <= count && p + layout.load_end <= src_len; i += 8, p += bits) {
+            for (int c = 0; c < 4; ++c) {
+                __m128i lanes = _mm_loadu_si128((const __m128i*)(src + p + layout.chunk_byte[c]));
+                lanes = _mm_shuffle_epi8(lanes, shuffle[c]);
+                lanes = _mm_blend_epi16(_mm_sll_epi64(lanes, shift_lo[c]), _mm_sll_epi64(lanes, shift_hi[c]), 0xF0);
+                lanes = _mm_srl_epi64(lanes, field_shift);
+                if (sign_extend) lanes = _mm_sub_epi64(_mm_xor_si128(lanes, sign_bit), sign_bit);
+                _mm_storeu_si128((__m128i*)(values + i + 2 * c), lanes);
+            }
+        }
+    }
+
+    unpack_int64_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+/**
+ * Merge pairs of masked int32 fields into fields of 2 * [bits] bits with AVX2,
+ * so that the packer runs half as many (4x for narrow fields) iterations.
+ */
+__attribute__((target("avx2")))
+static void pack_int32_avx2(uint8_t* dst, uint8_t bit_offset, const int32_t* values, size_t count, uint8_t bits) {
+    uint32_t mask = (uint32_t)(((uint64_t)1 << bits) - 1);
+    __m256i field_mask = _mm256_set1_epi32((int32_t)mask);
+    __m256i low_half = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m128i pair_shift = _mm_cvtsi32_si128(bits);
+    uint64_t pairs[4];
+    uint8_t pair_bits = 2 * bits;
+
+    bit_packer packer;
+    packer_begin(&packer, dst, bit_offset);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i fields = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(values + i)), field_mask);
+        // Each 64-bit lane holds values[2k + 1] << 32 | values[2k]; reorder to values[2k] << bits | values[2k + 1]
+        __m256i merged = _mm256_or_si256(
+            _mm256_sll_epi64(_mm256_and_si256(fields, low_half), pair_shift),
+            _mm256_srli_epi64(fields, 32)
+        );
+        _mm256_storeu_si256((__m256i*)pairs, merged);
+
+        if (pair_bits <= 32) {
+            packer_put(&packer, pairs[0] << pair_bits | pairs[1], 2 * pair_bits);
+            packer_put(&packer, pairs[2] << pair_bits | pairs[3], 2 * pair_bits);
+        } else {
+            for (int k = 0; k < 4; ++k) {
+                packer_put(&packer, pairs[k], pair_bits);
+            }
+        }
+    }
+    for (; i < count; ++i) {
+        packer_put(&packer, (uint32_t)values[i] & mask, bits);
+    }
+
+    packer_end(&packer);
+}
+
+__attribute__((target("avx2")))
+static void unpack_int32_avx2(const uint8_t* src, size_t src_len, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT32) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 4);
+
+        __m256i shuffle = _mm256_loadu2_m128i((const __m128i*)layout.shuffle[1], (const __m128i*)layout.shuffle[0]);
+        __m256i shift = _mm256_setr_epi32(
+            layout.shift[0][0], layout.shift[0][1], layout.shift[0][2], layout.shift[0][3],
+            layout.shift[1][0], layout.shift[1][1], layout.shift[1][2], layout.shift[1][3]
+        );
+        __m128i field_shift = _mm_cvtsi32_si128(32 - bits);
+        size_t hi_byte = layout.chunk_byte[1];
+
+        for (size_t p = 0; i + 8 <= count && p + layout.load_end <= src_len; i += 8, p += bits) {
+            __m256i lanes = _mm256_loadu2_m128i((const __m128i*)(src + p + hi_byte), (const __m128i*)(src + p));
+            lanes = _mm256_shuffle_epi8(lanes, shuffle);
+            lanes = _mm256_sllv_epi32(lanes, shift);
+            lanes = sign_extend ? _mm256_sra_epi32(lanes, field_shift) : _mm256_srl_epi32(lanes, field_shift);
+            _mm256_storeu_si256((__m256i*)(values + i), lanes);
+        }
+    }
+
+    unpack_int32_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+__attribute__((target("avx2")))
+static void unpack_int64_avx2(const uint8_t* src, size_t src_len, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT64) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 8);
+
+        __m256i shuffle[2], shift[2];
+        for (int h = 0; h < 2; ++h) {
+            shuffle[h] = _mm256_loadu2_m128i((const __m128i*)layout.shuffle[2 * h + 1], (const __m128i*)layout.shuffle[2 * h]);
+            shift[h] = _mm256_setr_epi64x(
+                layout.shift[2 * h][0], layout.shift[2 * h][1],
+                layout.shift[2 * h + 1][0], layout.shift[2 * h + 1][1]
+            );
+        }
+        __m128i field_shift = _mm_cvtsi32_si128(64 - bits);
+        // AVX2 has no 64-bit arithmetic shift: sign-extend with (x ^ m) - m instead
+        __m256i sign_bit = _mm256_set1_epi64x((int64_t)1 << (bits - 1));
+
+        for (size_t p = 0; i + 8 <= count && p + layout.load_end <= src_len; i += 8, p += bits) {
+            for (int h = 0; h < 2; ++h) {
+                __m256i lanes = _mm256_loadu2_m128i(
+                    (const __m128i*)(src + p + layout.chunk_byte[2 * h + 1]),
+                    (const __m128i*)(src + p + layout.chunk_byte[2 * h])
+                );
+                lanes = _mm256_shuffle_epi8(lanes, shuffle[h]);
+                lanes = _mm256_srl_epi64(_mm256_sllv_epi64(lanes, shift[h]), field_shift);
+                if (sign_extend) lanes = _mm256_sub_epi64(_mm256_xor_si256(lanes, sign_bit), sign_bit);
+                _mm256_storeu_si256((__m256i*)(values + i + 4 * h), lanes);
+            }
+        }
+    }
+
+    unpack_int64_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+/**
+ * Gather four 16-byte chunks into one 512-bit vector, chunk 0 in the lowest lanes.
+ */
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i load_chunks_512(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, const uint8_t* c3) {
+    __m512i lanes = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)c0));
+    lanes = _mm512_inserti32x4(lanes, _mm_loadu_si128((const __m128i*)c1), 1);
+    lanes = _mm512_inserti32x4(lanes, _mm_loadu_si128((const __m128i*)c2), 2);
+    return _mm512_inserti32x4(lanes, _mm_loadu_si128((const __m128i*)c3), 3);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void unpack_int32_avx512(const uint8_t* src, size_t src_len, uint8_t bit_offset, int32_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT32) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 4);
+
+        // 16 values are two groups with the same layout, the second one [bits] bytes later
+        uint8_t shuffle_bytes[64];
+        int32_t shift_lanes[16];
+        for (int c = 0; c < 4; ++c) {
+            memcpy(shuffle_bytes + 16 * c, layout.shuffle[c & 1], 16);
+            for (int lane = 0; lane < 4; ++lane) shift_lanes[4 * c + lane] = layout.shift[c & 1][lane];
+        }
+        __m512i shuffle = _mm512_loadu_si512(shuffle_bytes);
+        __m512i shift = _mm512_loadu_si512(shift_lanes);
+        __m128i field_shift = _mm_cvtsi32_si128(32 - bits);
+        size_t hi_byte = layout.chunk_byte[1];
+
+        for (size_t p = 0; i + 16 <= count && p + bits + layout.load_end <= src_len; i += 16, p += 2 * (size_t)bits) {
+            const uint8_t* group = src + p;
+            __m512i lanes = load_chunks_512(group, group + hi_byte, group + bits, group + bits + hi_byte);
+            lanes = _mm512_shuffle_epi8(lanes, shuffle);
+            lanes = _mm512_sllv_epi32(lanes, shift);
+            lanes = sign_extend ? _mm512_sra_epi32(lanes, field_shift) : _mm512_srl_epi32(lanes, field_shift);
+            _mm512_storeu_si512(values + i, lanes);
+        }
+    }
+
+    unpack_int32_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void unpack_int64_avx512(const uint8_t* src, size_t src_len, uint8_t bit_offset, int64_t* values, size_t count, uint8_t bits, int sign_extend) {
+    size_t i = 0;
+
+    if (bits <= VECTOR_MAX_BITS_INT64) {
+        unpack_layout layout;
+        build_layout(&layout, bit_offset, bits, 8);
+
+        uint8_t shuffle_bytes[64];
+        int64_t shift_lanes[8];
+        for (int c = 0; c < 4; ++c) {
+            memcpy(shuffle_bytes + 16 * c, layout.shuffle[c], 16);
+            shift_lanes[2 * c] = layout.shift[c][0];
+            shift_lanes[2 * c + 1] = layout.shift[c][1];
+        }
+        __m512i shuffle = _mm512_loadu_si512(shuffle_bytes);
+        __m512i shift = _mm512_loadu_si512(shift_lanes);
+        __m128i field_shift = _mm_cvtsi32_si128(64 - bits);
+
+        for (size_t p = 0; i + 8 <= count && p + layout.load_end <= src_len; i += 8, p += bits) {
+            const uint8_t* group = src + p;
+            __m512i lanes = load_chunks_512(
+                group + layout.chunk_byte[0], group + layout.chunk_byte[1],
+                group + layout.chunk_byte[2], group + layout.chunk_byte[3]
+            );
+            lanes = _mm512_shuffle_epi8(lanes, shuffle);
+            lanes = _mm512_sllv_epi64(lanes, shift);
+            lanes = sign_extend ? _mm512_sra_epi64(lanes, field_shift) : _mm512_srl_epi64(lanes, field_shift);
+            _mm512_storeu_si512(values + i, lanes);
+        }
+    }
+
+    unpack_int64_tail(src, bit_offset, values, count, bits, sign_extend, i);
+}
+
+/**
+ * Float resizers: every lane rebiases its exponent and shifts its mantissa with the same constants,
+ * and the zero and all-ones exponents are blended in from compare masks, so there is no branch per value.
+ * Shifts by 64 or more give zero for vectors, which matches the masks of empty fields.
+ * When rounding to nearest even, the carry of each lane is added to its exponent and mantissa,
+ * masked off for infinities, NaNs and codes that would wrap, as flr_resize does.
+ */
+__attribute__((target("avx2")))
+static void resize_float_avx2(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count) {
+    const __m128i src_mant_bits = _mm_cvtsi32_si128(format->src_mant_bits);
+    const __m128i src_sign_shift = _mm_cvtsi32_si128(format->src_sign_shift);
+    const __m128i dst_mant_bits = _mm_cvtsi32_si128(format->dst_mant_bits);
+    const __m128i dst_sign_shift = _mm_cvtsi32_si128(format->dst_sign_shift);
+    const __m128i mant_shift_left = _mm_cvtsi32_si128(format->mant_shift_left);
+    const __m128i mant_shift_right = _mm_cvtsi32_si128(format->mant_shift_right);
+    const __m256i src_exp_mask = _mm256_set1_epi64x((long long)format->src_exp_mask);
+    const __m256i src_mant_mask = _mm256_set1_epi64x((long long)format->src_mant_mask);
+    const __m256i dst_exp_mask = _mm256_set1_epi64x((long long)format->dst_exp_mask);
+    const __m256i dst_mant_mask = _mm256_set1_epi64x((long long)format->dst_mant_mask);
+    const __m256i exp_offset = _mm256_set1_epi64x((long long)format->exp_offset);
+    const __m256i zero_exponent = _mm256_set1_epi64x((long long)format->zero_exponent);
+    const __m256i sign_mask = _mm256_set1_epi64x((long long)format->sign_mask);
+    const __m256i round_mask = _mm256_set1_epi64x((long long)format->round_mask);
+    const __m256i round_half = _mm256_set1_epi64x((long long)format->round_half);
+    const __m256i body_mask = _mm256_set1_epi64x((long long)((format->dst_exp_mask << format->dst_mant_bits) | format->dst_mant_mask));
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const int rounding = format->round_bit != 0;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(src + i));
+
+        __m256i src_exponent = _mm256_and_si256(_mm256_srl_epi64(value, src_mant_bits), src_exp_mask);
+        __m256i exponent = _mm256_and_si256(_mm256_add_epi64(src_exponent, exp_offset), dst_exp_mask);
+        exponent = _mm256_blendv_epi8(exponent, dst_exp_mask, _mm256_cmpeq_epi64(src_exponent, src_exp_mask));
+        exponent = _mm256_blendv_epi8(exponent, zero_exponent, _mm256_cmpeq_epi64(src_exponent, zero));
+
+        __m256i mant = _mm256_and_si256(value, src_mant_mask);
+        mant = _mm256_and_si256(_mm256_srl_epi64(_mm256_sll_epi64(mant, mant_shift_left), mant_shift_right), dst_mant_mask);
+        __m256i sign = _mm256_sll_epi64(_mm256_and_si256(_mm256_srl_epi64(value, src_sign_shift), sign_mask), dst_sign_shift);
+
+        __m256i body = _mm256_or_si256(_mm256_sll_epi64(exponent, dst_mant_bits), mant);
+        if (rounding) {
+            __m256i last = _mm256_and_si256(_mm256_srl_epi64(value, mant_shift_right), one);
+            __m256i carry = _mm256_add_epi64(_mm256_add_epi64(_mm256_and_si256(value, round_mask), round_half), last);
+            carry = _mm256_srl_epi64(carry, mant_shift_right);
+            __m256i special = _mm256_andnot_si256(
+                _mm256_cmpeq_epi64(src_exp_mask, zero),
+                _mm256_or_si256(_mm256_cmpeq_epi64(src_exponent, zero), _mm256_cmpeq_epi64(src_exponent, src_exp_mask))
+            );
+            __m256i keep = _mm256_or_si256(special, _mm256_cmpeq_epi64(body, body_mask));
+            body = _mm256_add_epi64(body, _mm256_andnot_si256(keep, carry));
+        }
+
+        __m256i result = _mm256_or_si256(sign, body);
+        _mm256_storeu_si256((__m256i*)(dst + i), result);
+    }
+
+    resize_float_loop(format, src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void resize_float_avx512(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count) {
+    const __m128i src_mant_bits = _mm_cvtsi32_si128(format->src_mant_bits);
+    const __m128i src_sign_shift = _mm_cvtsi32_si128(format->src_sign_shift);
+    const __m128i dst_mant_bits = _mm_cvtsi32_si128(format->dst_mant_bits);
+    const __m128i dst_sign_shift = _mm_cvtsi32_si128(format->dst_sign_shift);
+    const __m128i mant_shift_left = _mm_cvtsi32_si128(format->mant_shift_left);
+    const __m128i mant_shift_right = _mm_cvtsi32_si128(format->mant_shift_right);
+    const __m512i src_exp_mask = _mm512_set1_epi64((long long)format->src_exp_mask);
+    const __m512i src_mant_mask = _mm512_set1_epi64((long long)format->src_mant_mask);
+    const __m512i dst_exp_mask = _mm512_set1_epi64((long long)format->dst_exp_mask);
+    const __m512i dst_mant_mask = _mm512_set1_epi64((long long)format->dst_mant_mask);
+    const __m512i exp_offset = _mm512_set1_epi64((long long)format->exp_offset);
+    const __m512i zero_exponent = _mm512_set1_epi64((long long)format->zero_exponent);
+    const __m512i sign_mask = _mm512_set1_epi64((long long)format->sign_mask);
+    const __m512i round_mask = _mm512_set1_epi64((long long)format->round_mask);
+    const __m512i round_half = _mm512_set1_epi64((long long)format->round_half);
+    const __m512i body_mask = _mm512_set1_epi64((long long)((format->dst_exp_mask << format->dst_mant_bits) | format->dst_mant_mask));
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const int rounding = format->round_bit != 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i value = _mm512_loadu_si512((const void*)(src + i));
+
+        __m512i src_exponent = _mm512_and_si512(_mm512_srl_epi64(value, src_mant_bits), src_exp_mask);
+        __m512i exponent = _mm512_and_si512(_mm512_add_epi64(src_exponent, exp_offset), dst_exp_mask);
+        exponent = _mm512_mask_mov_epi64(exponent, _mm512_cmpeq_epi64_mask(src_exponent, src_exp_mask), dst_exp_mask);
+        exponent = _mm512_mask_mov_epi64(exponent, _mm512_cmpeq_epi64_mask(src_exponent, zero), zero_exponent);
+
+        __m512i mant = _mm512_and_si512(value, src_mant_mask);
+        mant = _mm512_and_si512(_mm512_srl_epi64(_mm512_sll_epi64(mant, mant_shift_left), mant_shift_right), dst_mant_mask);
+        __m512i sign = _mm512_sll_epi64(_mm512_and_si512(_mm512_srl_epi64(value, src_sign_shift), sign_mask), dst_sign_shift);
+
+        __m512i body = _mm512_or_si512(_mm512_sll_epi64(exponent, dst_mant_bits), mant);
+        if (rounding) {
+            __m512i last = _mm512_and_si512(_mm512_srl_epi64(value, mant_shift_right), one);
+            __m512i carry = _mm512_add_epi64(_mm512_add_epi64(_mm512_and_si512(value, round_mask), round_half), last);
+            carry = _mm512_srl_epi64(carry, mant_shift_right);
+            __mmask8 special = format->src_exp_mask == 0 ? 0
+                : _mm512_cmpeq_epi64_mask(src_exponent, zero) | _mm512_cmpeq_epi64_mask(src_exponent, src_exp_mask);
+            __mmask8 round = (__mmask8)~(special | _mm512_cmpeq_epi64_mask(body, body_mask));
+            body = _mm512_mask_add_epi64(body, round, body, carry);
+        }
+
+        __m512i result = _mm512_or_si512(sign, body);
+        _mm512_storeu_si512((void*)(dst + i), result);
+    }
+
+    resize_float_loop(format, src, dst, count, i);
+}
+
+/**
+ * Half-precision converters: binary16 goes through the F16C instructions, or their AVX-512 forms,
+ * rounding to nearest even as the software conversions do. F16C is not implied by AVX2,
+ * so AVX2 CPUs without it get a table using the software loops instead.
+ * bfloat16 uses the AVX-512 BF16 instruction when present, and otherwise the same rounding in integer lanes.
+ * Both extensions are checked once, when pbb_kernel_table_of picks the table.
+ */
+__attribute__((target("avx2,f16c")))
+static void float_to_half_f16c(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(dst + i), half);
+    }
+
+    float_to_half_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx2,f16c")))
+static void half_to_float_f16c(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+    }
+
+    half_to_float_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_bfloat16_avx2(const float* src, uint16_t* dst, size_t count) {
+    const __m256i abs_mask = _mm256_set1_epi32(0x7FFFFFFF);
+    const __m256i exp_mask = _mm256_set1_epi32(0x7F800000);
+    const __m256i sign_mask = _mm256_set1_epi32((int)0x80000000);
+    const __m256i quiet_bit = _mm256_set1_epi32(0x40);
+    const __m256i rounding = _mm256_set1_epi32(0x7FFF);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(value, abs_mask), exp_mask);
+        __m256i subnormal = _mm256_cmpeq_epi32(_mm256_and_si256(value, exp_mask), zero);
+        value = _mm256_blendv_epi8(value, _mm256_and_si256(value, sign_mask), subnormal);
+
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(value, 16), one);
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(value, rounding), lsb), 16);
+        __m256i quiet = _mm256_or_si256(_mm256_srli_epi32(value, 16), quiet_bit);
+        rounded = _mm256_blendv_epi8(rounded, quiet, nan);
+
+        // Every lane holds 16 bits: pack the two halves of each 128-bit lane, then join the lanes
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0x08);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(packed));
+    }
+
+    float_to_bfloat16_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx2")))
+static void bfloat16_to_float_avx2(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_slli_epi32(value, 16));
+    }
+
+    bfloat16_to_float_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_half_avx512(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i half = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_storeu_si256((__m256i*)(dst + i), half);
+    }
+
+    float_to_half_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void half_to_float_avx512(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(src + i))));
+    }
+
+    half_to_float_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx512f,avx512bf16")))
+static void float_to_bfloat16_bf16(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256bh bfloat = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), (__m256i)bfloat);
+    }
+
+    float_to_bfloat16_loop(src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void bfloat16_to_float_avx512(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i value = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm512_storeu_si512((void*)(dst + i), _mm512_slli_epi32(value, 16));
+    }
+
+    bfloat16_to_float_loop(src, dst, count, i);
+}
+
+/**
+ * Float scanners: every lane keeps its own minimum and maximum exponent, with the excluded exponents
+ * replaced by the neutral value of each, and the lanes are reduced once at the end.
+ * Exponents fit in the low 32 bits of their lane, so the unsigned 32-bit min/max of AVX2 are exact.
+ */
+__attribute__((target("avx2")))
+static void scan_float_avx2(const double* src, size_t count, float_scan* scan) {
+    const __m256i exp_mask = _mm256_set1_epi64x(0x7FF);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i min_exponent = _mm256_set1_epi64x((long long)scan->min_exponent);
+    __m256i max_exponent = _mm256_set1_epi64x((long long)scan->max_exponent);
+    __m256d negative = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d value = _mm256_loadu_pd(src + i);
+        __m256i exponent = _mm256_and_si256(_mm256_srli_epi64(_mm256_castpd_si256(value), 52), exp_mask);
+        __m256i skipped = _mm256_or_si256(_mm256_cmpeq_epi64(exponent, zero), _mm256_cmpeq_epi64(exponent, exp_mask));
+
+        min_exponent = _mm256_min_epu32(min_exponent, _mm256_or_si256(exponent, _mm256_and_si256(skipped, exp_mask)));
+        max_exponent = _mm256_max_epu32(max_exponent, _mm256_andnot_si256(skipped, exponent));
+        negative = _mm256_or_pd(negative, _mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_LT_OQ));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, min_exponent);
+    for (int lane = 0; lane < 4; ++lane) {
+        scan->min_exponent = lanes[lane] < scan->min_exponent ? lanes[lane] : scan->min_exponent;
+    }
+    _mm256_storeu_si256((__m256i*)lanes, max_exponent);
+    for (int lane = 0; lane < 4; ++lane) {
+        scan->max_exponent = lanes[lane] > scan->max_exponent ? lanes[lane] : scan->max_exponent;
+    }
+    scan->negative |= _mm256_movemask_pd(negative) != 0;
+
+    scan_float_loop(src, count, scan, i);
+}
+
+__attribute__((target("avx512f")))
+static void scan_float_avx512(const double* src, size_t count, float_scan* scan) {
+    const __m512i exp_mask = _mm512_set1_epi64(0x7FF);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i min_exponent = _mm512_set1_epi64((long long)scan->min_exponent);
+    __m512i max_exponent = _mm512_set1_epi64((long long)scan->max_exponent);
+    __mmask8 negative = 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d value = _mm512_loadu_pd(src + i);
+        __m512i exponent = _mm512_and_si512(_mm512_srli_epi64(_mm512_castpd_si512(value), 52), exp_mask);
+        __mmask8 kept = _mm512_cmpneq_epi64_mask(exponent, zero) & _mm512_cmpneq_epi64_mask(exponent, exp_mask);
+
+        min_exponent = _mm512_mask_min_epu64(min_exponent, kept, min_exponent, exponent);
+        max_exponent = _mm512_mask_max_epu64(max_exponent, kept, max_exponent, exponent);
+        negative |= _mm512_cmp_pd_mask(value, _mm512_setzero_pd(), _CMP_LT_OQ);
+    }
+
+    scan->min_exponent = _mm512_reduce_min_epu64(min_exponent);
+    scan->max_exponent = _mm512_reduce_max_epu64(max_exponent);
+    scan->negative |= negative != 0;
+
+    scan_float_loop(src, count, scan, i);
+}
+
+/**
+ * Fixed-point quantizers: max_pd returns its second operand when the first one is NaN, so clamping with
+ * the value first sends NaN to code 0 as quantize_value does. Codes are rounded and converted back
+ * by adding 2^52, which needs neither AVX-512 DQ nor a rounding-mode change.
+ */
+__attribute__((target("avx2")))
+static void quantize_avx2(const fxp_format* format, const double* src, uint64_t* dst, size_t count) {
+    const __m256d min = _mm256_set1_pd(format->min);
+    const __m256d scale = _mm256_set1_pd(format->scale);
+    const __m256d code_limit = _mm256_set1_pd(format->code_limit);
+    const __m256d magic = _mm256_set1_pd(FXP_MAGIC);
+    const __m256i magic_bits = _mm256_set1_epi64x((long long)FXP_MAGIC_BITS);
+    const __m256d zero = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d scaled = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(src + i), min), scale);
+        scaled = _mm256_min_pd(_mm256_max_pd(scaled, zero), code_limit);
+        __m256i code = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(scaled, magic)), magic_bits);
+        _mm256_storeu_si256((__m256i*)(dst + i), code);
+    }
+
+    quantize_loop(format, src, dst, count, i);
+}
+
+__attribute__((target("avx2")))
+static void dequantize_avx2(const fxp_format* format, const uint64_t* src, double* dst, size_t count) {
+    const __m256d min = _mm256_set1_pd(format->min);
+    const __m256d step = _mm256_set1_pd(format->step);
+    const __m256i code_mask = _mm256_set1_epi64x((long long)format->code_mask);
+    const __m256d magic = _mm256_set1_pd(FXP_MAGIC);
+    const __m256i magic_bits = _mm256_set1_epi64x((long long)FXP_MAGIC_BITS);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i code = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(src + i)), code_mask);
+        __m256d steps = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(code, magic_bits)), magic);
+        _mm256_storeu_pd(dst + i, _mm256_add_pd(min, _mm256_mul_pd(steps, step)));
+    }
+
+    dequantize_loop(format, src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void quantize_avx512(const fxp_format* format, const double* src, uint64_t* dst, size_t count) {
+    const __m512d min = _mm512_set1_pd(format->min);
+    const __m512d scale = _mm512_set1_pd(format->scale);
+    const __m512d code_limit = _mm512_set1_pd(format->code_limit);
+    const __m512d magic = _mm512_set1_pd(FXP_MAGIC);
+    const __m512i magic_bits = _mm512_set1_epi64((long long)FXP_MAGIC_BITS);
+    const __m512d zero = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d scaled = _mm512_mul_pd(_mm512_sub_pd(_mm512_loadu_pd(src + i), min), scale);
+        scaled = _mm512_min_pd(_mm512_max_pd(scaled, zero), code_limit);
+        __m512i code = _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(scaled, magic)), magic_bits);
+        _mm512_storeu_si512((void*)(dst + i), code);
+    }
+
+    quantize_loop(format, src, dst, count, i);
+}
+
+__attribute__((target("avx512f")))
+static void dequantize_avx512(const fxp_format* format, const uint64_t* src, double* dst, size_t count) {
+    const __m512d min = _mm512_set1_pd(format->min);
+    const __m512d step = _mm512_set1_pd(format->step);
+    const __m512i code_mask = _mm512_set1_epi64((long long)format->code_mask);
+    const __m512d magic = _mm512_set1_pd(FXP_MAGIC);
+    const __m512i magic_bits = _mm512_set1_epi64((long long)FXP_MAGIC_BITS);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i code = _mm512_and_si512(_mm512_loadu_si512((const void*)(src + i)), code_mask);
+        __m512d steps = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(code, magic_bits)), magic);
+        _mm512_storeu_pd(dst + i, _mm512_add_pd(min, _mm512_mul_pd(steps, step)));
+    }
+
+    dequantize_loop(format, src, dst, count, i);
+}
+
+static const pbb_kernel_table BMI2_KERNELS = {
+    PBB_KERNEL_BMI2, "bmi2",
+    pack_int32_bmi2, pack_int64_bmi2,
+    unpack_int32_bmi2, unpack_int64_bmi2,
+    resize_float_scalar,
+    float_to_half_scalar, half_to_float_scalar,
+    float_to_bfloat16_scalar, bfloat16_to_float_scalar,
+    scan_float_scalar,
+    quantize_scalar, dequantize_scalar
+};
+
+static const pbb_kernel_table SSE41_KERNELS = {
+    PBB_KERNEL_SSE41, "sse4.1",
+    pack_int32_scalar, pack_int64_scalar,
+    unpack_int32_sse41, unpack_int64_sse41,
+    resize_float_scalar,
+    float_to_half_scalar, half_to_float_scalar,
+    float_to_bfloat16_scalar, bfloat16_to_float_scalar,
+    scan_float_scalar,
+    quantize_scalar, dequantize_scalar
+};
+
+static const pbb_kernel_table AVX2_KERNELS = {
+    PBB_KERNEL_AVX2, "avx2",
+    pack_int32_avx2, pack_int64_scalar,
+    unpack_int32_avx2, unpack_int64_avx2,
+    resize_float_avx2,
+    float_to_half_f16c, half_to_float_f16c,
+    float_to_bfloat16_avx2, bfloat16_to_float_avx2,
+    scan_float_avx2,
+    quantize_avx2, dequantize_avx2
+};
+
+/**
+ * The AVX2 kernels for CPUs without F16C.
+ */
+static const pbb_kernel_table AVX2_NO_F16C_KERNELS = {
+    PBB_KERNEL_AVX2, "avx2",
+    pack_int32_avx2, pack_int64_scalar,
+    unpack_int32_avx2, unpack_int64_avx2,
+    resize_float_avx2,
+    float_to_half_scalar, half_to_float_scalar,
+    float_to_bfloat16_avx2, bfloat16_to_float_avx2,
+    scan_float_avx2,
+    quantize_avx2, dequantize_avx2
+};
+
+static const pbb_kernel_table AVX512_KERNELS = {
+    PBB_KERNEL_AVX512, "avx512",
+    pack_int32_avx2, pack_int64_scalar,
+    unpack_int32_avx512, unpack_int64_avx512,
+    resize_float_avx512,
+    float_to_half_avx512, half_to_float_avx512,
+    float_to_bfloat16_bf16, bfloat16_to_float_avx512,
+    scan_float_avx512,
+    quantize_avx512, dequantize_avx512
+};
+
+/**
+ * The AVX-512 kernels for CPUs without AVX-512 BF16, rounding bfloat16 in AVX2 integer lanes.
+ */
+static const pbb_kernel_table AVX512_NO_BF16_KERNELS = {
+    PBB_KERNEL_AVX512, "avx512",
+    pack_int32_avx2, pack_int64_scalar,
+    unpack_int32_avx512, unpack_int64_avx512,
+    resize_float_avx512,
+    float_to_half_avx512, half_to_float_avx512,
+    float_to_bfloat16_avx2, bfloat16_to_float_avx512,
+    scan_float_avx512,
+    quantize_avx512, dequantize_avx512
+};
+
+#endif // PBB_X86_KERNELS
+
+const pbb_kernel_table* pbb_kernel_table_of(pbb_kernel kernel) {
+    switch (kernel) {
+    case PBB_KERNEL_SCALAR:
+        return &SCALAR_KERNELS;
+#if PBB_X86_KERNELS
+    case PBB_KERNEL_BMI2:
+        return __builtin_cpu_supports("bmi2") ? &BMI2_KERNELS : NULL;
+    case PBB_KERNEL_SSE41:
+        return __builtin_cpu_supports("sse4.1") ? &SSE41_KERNELS : NULL;
+    case PBB_KERNEL_AVX2:
+        if (!__builtin_cpu_supports("avx2")) return NULL;
+        return __builtin_cpu_supports("f16c") ? &AVX2_KERNELS : &AVX2_NO_F16C_KERNELS;
+    case PBB_KERNEL_AVX512:
+        if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw") || !__builtin_cpu_supports("avx2")) return NULL;
+        return __builtin_cpu_supports("avx512bf16") ? &AVX512_KERNELS : &AVX512_NO_BF16_KERNELS;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+#if PBB_X86_KERNELS
+/**
+ * Pick the kernels of the widest instruction set the CPU supports, once at load time.
+ */
+__attribute__((constructor))
+static void resolve_kernels(void) {
+    __builtin_cpu_init();
+    for (int kernel = PBB_KERNEL_COUNT - 1; kernel > PBB_KERNEL_SCALAR; --kernel) {
+        const pbb_kernel_table* table = pbb_kernel_table_of((pbb_kernel)kernel);
+        if (table != NULL) {
+            pbb_kernels = table;
+            return;
+        }
+    }
+}
+#endif
+
+pbb_kernel pbb_get_kernel(void) {
+    return pbb_kernels->kernel;
+}
+
+const char* pbb_get_kernel_name(void) {
+    return pbb_kernels->name;
+}
+
+int pbb_set_kernel(pbb_kernel kernel) {
+    const pbb_kernel_table* table = pbb_kernel_table_of(kernel);
+    if (table == NULL) return 0;
+
+    pbb_kernels = table;
+    return 1;
+}
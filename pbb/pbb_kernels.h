@@ -0,0 +1,306 @@
+#ifndef PBB_KERNELS_H
+#define PBB_KERNELS_H
+
+/**
+ * Internal bit-packing kernels shared by the partial_byte_buffer implementation.
+ * Not part of the public API.
+ */
+
+#include "partial_byte_buffer.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PBB_X86_KERNELS 1
+#else
+#define PBB_X86_KERNELS 0
+#endif
+
+/**
+ * Load 8 bytes starting at [src] (no alignment required) as a big-endian 64-bit word.
+ */
+static inline uint64_t load_be64(const uint8_t* src) {
+    uint64_t word;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&word, src, sizeof(word));
+    word = __builtin_bswap64(word);
+#elif defined(__BYTE_ORDER__)
+    memcpy(&word, src, sizeof(word));
+#else
+    word = 0;
+    for (int i = 0; i < 8; ++i) word = (word << 8) | src[i];
+#endif
+    return word;
+}
+
+/**
+ * Store [word] as 8 big-endian bytes starting at [dst] (no alignment required).
+ */
+static inline void store_be64(uint8_t* dst, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+    memcpy(dst, &word, sizeof(word));
+#elif defined(__BYTE_ORDER__)
+    memcpy(dst, &word, sizeof(word));
+#else
+    for (int i = 7; i >= 0; --i, word >>= 8) dst[i] = (uint8_t)word;
+#endif
+}
+
+/**
+ * Convert the bits of a float to IEEE binary16, rounding to nearest even. Overflows give infinity,
+ * NaN keeps its sign and upper payload bits and becomes quiet: the same bits as F16C vcvtps2ph.
+ */
+static inline uint16_t float_bits_to_half(uint32_t x) {
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    x &= 0x7FFFFFFF;
+
+    if (x > 0x7F800000) return sign | 0x7E00 | (uint16_t)((x >> 13) & 0x3FF);
+    // From 65520, halfway between the largest half and the next power of 2, the value rounds to infinity
+    if (x >= 0x477FF000) return sign | 0x7C00;
+    if (x >= 0x38800000) {
+        // Rebias the exponent from 127 to 15, and let the rounding carry run into it
+        uint32_t rounded = x - 0x38000000 + 0xFFF + ((x >> 13) & 1);
+        return sign | (uint16_t)(rounded >> 13);
+    }
+    // Up to 2^-25, half of the smallest subnormal, the value rounds to zero
+    if (x <= 0x33000000) return sign;
+
+    // Subnormal result: the mantissa with its implicit bit, in units of 2^-24
+    uint32_t mant = (x & 0x7FFFFF) | 0x800000;
+    uint32_t shift = 126 - (x >> 23);
+    uint32_t quotient = mant >> shift;
+    uint32_t remainder = mant & (((uint32_t)1 << shift) - 1);
+    uint32_t halfway = (uint32_t)1 << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (quotient & 1))) ++quotient;
+    return sign | (uint16_t)quotient;
+}
+
+/**
+ * Convert IEEE binary16 to the bits of the float of the same value. NaN becomes quiet, as with F16C vcvtph2ps.
+ */
+static inline uint32_t half_to_float_bits(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+
+    if (exponent == 0x1F) return sign | 0x7F800000 | (mant << 13) | (mant != 0 ? 0x400000 : 0);
+    if (exponent != 0) return sign | ((exponent + 112) << 23) | (mant << 13);
+    if (mant == 0) return sign;
+
+    // Subnormal half: normalize the mantissa into a normal float
+    exponent = 113;
+    while ((mant & 0x400) == 0) {
+        mant <<= 1;
+        --exponent;
+    }
+    return sign | (exponent << 23) | ((mant & 0x3FF) << 13);
+}
+
+/**
+ * Convert the bits of a float to bfloat16, rounding to nearest even. Subnormal inputs count as zero
+ * and NaN becomes quiet: the same bits as AVX-512 BF16 vcvtneps2bf16.
+ */
+static inline uint16_t float_bits_to_bfloat16(uint32_t x) {
+    if ((x & 0x7FFFFFFF) > 0x7F800000) return (uint16_t)((x >> 16) | 0x40);
+    if ((x & 0x7F800000) == 0) x &= 0x80000000;
+    return (uint16_t)((x + 0x7FFF + ((x >> 16) & 1)) >> 16);
+}
+
+/**
+ * Convert bfloat16 to the bits of the float of the same value.
+ */
+static inline uint32_t bfloat16_to_float_bits(uint16_t b) {
+    return (uint32_t)b << 16;
+}
+
+/**
+ * State of a bulk bit packer: bits are collected MSB-first in [acc] and stored one 64-bit word at a time.
+ */
+typedef struct bit_packer {
+    /**
+     * Address where [acc] will be stored; always the byte holding the first bit of [acc].
+     */
+    uint8_t* dst;
+
+    /**
+     * Pending bits, aligned to the most significant end.
+     */
+    uint64_t acc;
+
+    /**
+     * Number of pending bits in [acc] (0-63).
+     */
+    uint8_t filled;
+} bit_packer;
+
+/**
+ * Start packing [bit_offset] (0-7) bits into [dst]. The bits already written to that byte are kept.
+ */
+static inline void packer_begin(bit_packer* packer, uint8_t* dst, uint8_t bit_offset) {
+    packer->dst = dst;
+    packer->filled = bit_offset;
+    packer->acc = bit_offset == 0 ? 0 : (uint64_t)(*dst) << 56;
+}
+
+/**
+ * Append the lowest [bits] bits (1-64) of [value] to the packer. Bits above [bits] must be zero.
+ */
+static inline void packer_put(bit_packer* packer, uint64_t value, uint8_t bits) {
+    uint8_t total = packer->filled + bits;
+    if (total < 64) {
+        packer->acc |= value << (64 - total);
+        packer->filled = total;
+        return;
+    }
+
+    /**
+     * The register is full: store it and keep the bits that did not fit.
+     * [overflow] < 64 since [filled] < 64 and [bits] <= 64.
+     */
+    uint8_t overflow = total - 64;
+    store_be64(packer->dst, packer->acc | (value >> overflow));
+    packer->dst += sizeof(uint64_t);
+    packer->acc = overflow == 0 ? 0 : value << (64 - overflow);
+    packer->filled = overflow;
+}
+
+/**
+ * Store the pending bits of the packer.
+ * Bytes past the pending bits are zero, both in [acc] and in the buffer, so the whole word
+ * can be stored; it stays inside the tail padding.
+ */
+static inline void packer_end(bit_packer* packer) {
+    if (packer->filled > 0) {
+        store_be64(packer->dst, packer->acc);
+    }
+}
+
+/**
+ * Encode the lowest [bits] bits of [count] values, MSB-first, starting [bit_offset] (0-7) bits into [dst].
+ * Bits past the start position must be zero, and 8 bytes past the byte receiving the last bit must be writable.
+ */
+typedef void (*pbb_pack_int32_fn)(uint8_t* dst, uint8_t bit_offset, const int32_t* values, size_t count, uint8_t bits);
+typedef void (*pbb_pack_int64_fn)(uint8_t* dst, uint8_t bit_offset, const int64_t* values, size_t count, uint8_t bits);
+
+/**
+ * Decode [count] consecutive fields of [bits] bits into [values], sign-extended unless [sign_extend] is 0.
+ * The first field starts [bit_offset] (0-7) bits into [src].
+ * [src_len] is the number of bytes that may be loaded from [src], tail padding included;
+ * it must cover at least 8 bytes past the byte holding the last field bit.
+ */
+typedef void (*pbb_unpack_int32_fn)(
+    const uint8_t* src, size_t src_len, uint8_t bit_offset,
+    int32_t* values, size_t count, uint8_t bits, int sign_extend
+);
+typedef void (*pbb_unpack_int64_fn)(
+    const uint8_t* src, size_t src_len, uint8_t bit_offset,
+    int64_t* values, size_t count, uint8_t bits, int sign_extend
+);
+
+/**
+ * Resize [count] values of [src] into [dst] with [format]. [src] and [dst] may be the same array,
+ * and [src] may hold doubles: it is only loaded bytewise or through vector loads.
+ */
+typedef void (*pbb_resize_float_fn)(const flr_format* format, const uint64_t* src, uint64_t* dst, size_t count);
+
+/**
+ * Convert [count] floats of [src] to IEEE binary16 or bfloat16, with the same bits as the software
+ * conversions above, and back.
+ */
+typedef void (*pbb_narrow_float_fn)(const float* src, uint16_t* dst, size_t count);
+typedef void (*pbb_widen_float_fn)(const uint16_t* src, float* dst, size_t count);
+
+/**
+ * Exponent range and sign of a column of doubles, accumulated by a scan kernel.
+ */
+typedef struct float_scan {
+    /**
+     * Smallest and largest biased exponents of the normal values: 0x7FF and 0 before the first one.
+     * Zeros, subnormals, infinities and NaN are skipped.
+     */
+    uint64_t min_exponent;
+    uint64_t max_exponent;
+
+    /**
+     * Whether a value is below zero. -0.0 and NaN are not.
+     */
+    int negative;
+} float_scan;
+
+/**
+ * Merge the exponent range and the sign of [count] doubles of [src] into [scan].
+ */
+typedef void (*pbb_scan_float_fn)(const double* src, size_t count, float_scan* scan);
+
+/**
+ * Doubles of [2^52, 2^53) have a unit step, so adding 2^52 to a value of [0, 2^52) rounds it to an integer
+ * held in the low mantissa bits, and setting the exponent of 2^52 over an integer below 2^52 converts it back.
+ */
+#define FXP_MAGIC 4503599627370496.0
+#define FXP_MAGIC_BITS 0x4330000000000000ULL
+
+/**
+ * Code of [value] in [format]: scaled, clamped to the codes with NaN taken as 0, and rounded to nearest even,
+ * with the same operations as the vector quantizers.
+ */
+static inline uint64_t quantize_value(const fxp_format* format, double value) {
+    double scaled = (value - format->min) * format->scale;
+    scaled = scaled > 0.0 ? scaled : 0.0;
+    scaled = scaled < format->code_limit ? scaled : format->code_limit;
+
+    double rounded = scaled + FXP_MAGIC;
+    uint64_t bits;
+    memcpy(&bits, &rounded, sizeof(bits));
+    return bits - FXP_MAGIC_BITS;
+}
+
+/**
+ * Value of the lowest code bits of [code] in [format].
+ */
+static inline double dequantize_value(const fxp_format* format, uint64_t code) {
+    uint64_t bits = (code & format->code_mask) | FXP_MAGIC_BITS;
+    double steps;
+    memcpy(&steps, &bits, sizeof(steps));
+    steps -= FXP_MAGIC;
+    return format->min + steps * format->step;
+}
+
+/**
+ * Quantize [count] doubles of [src] with [format] into [dst], and dequantize them back.
+ */
+typedef void (*pbb_quantize_fn)(const fxp_format* format, const double* src, uint64_t* dst, size_t count);
+typedef void (*pbb_dequantize_fn)(const fxp_format* format, const uint64_t* src, double* dst, size_t count);
+
+/**
+ * The bit-packing kernels built for one instruction set.
+ */
+typedef struct pbb_kernel_table {
+    pbb_kernel kernel;
+    const char* name;
+    pbb_pack_int32_fn pack_int32;
+    pbb_pack_int64_fn pack_int64;
+    pbb_unpack_int32_fn unpack_int32;
+    pbb_unpack_int64_fn unpack_int64;
+    pbb_resize_float_fn resize_float;
+    pbb_narrow_float_fn float_to_half;
+    pbb_widen_float_fn half_to_float;
+    pbb_narrow_float_fn float_to_bfloat16;
+    pbb_widen_float_fn bfloat16_to_float;
+    pbb_scan_float_fn scan_float;
+    pbb_quantize_fn quantize;
+    pbb_dequantize_fn dequantize;
+} pbb_kernel_table;
+
+/**
+ * Kernels in use. Resolved once when the library is loaded, see pbb_set_kernel.
+ */
+extern const pbb_kernel_table* pbb_kernels;
+
+/**
+ * Return the kernels built for [kernel], or NULL if the running CPU does not support them.
+ */
+const pbb_kernel_table* pbb_kernel_table_of(pbb_kernel kernel);
+
+#endif // PBB_KERNELS_H
@@ -0,0 +1,811 @@
+#include "pbb_pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PBB_HAVE_THREADS 1
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#define PBB_HAVE_THREADS 0
+#endif
+
+/**
+ * io_uring is used through its system calls, so only the kernel headers are needed.
+ * Writes at the current file position (IORING_FEAT_RW_CUR_POS) came with Linux 5.6.
+ */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_RW_CUR_POS
+#define PBB_HAVE_IO_URING 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+#endif
+#ifndef PBB_HAVE_IO_URING
+#define PBB_HAVE_IO_URING 0
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+/**
+ * Bytes allocated past [buffer_capacity] in every buffer, so that the write crossing
+ * the submission threshold does not make the buffer grow.
+ */
+static const size_t WRITE_HEADROOM = 2 * sizeof(uint64_t);
+
+#if PBB_HAVE_IO_URING
+/**
+ * Largest number of entries asked for the submission ring, which bounds the writes in flight.
+ */
+static const size_t MAX_URING_ENTRIES = 4096;
+
+/**
+ * Largest write submitted at once, as the length of a submission is 32 bits.
+ */
+static const size_t MAX_URING_WRITE = (size_t)1 << 30;
+
+/**
+ * Submission and completion rings shared with the kernel.
+ */
+typedef struct pbb_uring {
+    int fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    /**
+     * Whether every buffer is written at its own offset from [base_offset], the file position
+     * when the pipeline was created. Otherwise the file has no offset or is in append mode,
+     * and a single write at a time at the current position keeps the bytes in order.
+     */
+    int positional;
+    uint64_t base_offset;
+
+    /**
+     * Offset of the next buffer queued, and offset the file position was last moved to, from [base_offset].
+     */
+    uint64_t next_offset;
+    uint64_t synced_offset;
+
+    /**
+     * Number of writes submitted and not completed yet, and how many are allowed at once.
+     */
+    unsigned in_flight;
+    unsigned max_in_flight;
+
+    /**
+     * For every buffer: its offset from [base_offset], the number of its bytes already written,
+     * and whether a write of it is in flight.
+     */
+    uint64_t* offsets;
+    size_t* progress;
+    uint8_t* writing;
+} pbb_uring;
+#endif
+
+struct pbb_pipeline {
+    pbb_pipeline_backend backend;
+
+    /**
+     * Buffers filled in turn: the one being filled is buffers[submitted % buffer_count].
+     */
+    partial_byte_buffer** buffers;
+    size_t buffer_count;
+    size_t buffer_capacity;
+
+    /**
+     * Number of complete bytes of every submitted buffer.
+     */
+    size_t* lengths;
+
+    pbb_sink_fn sink;
+    void* context;
+    int fd;
+
+    /**
+     * Set once an output fails. The buffers queued after it are dropped.
+     */
+    int failed;
+
+    /**
+     * Counters, with [submitted] written by the encoder and [completed] by the output.
+     * Both are guarded by [lock] with the thread backend.
+     */
+    pbb_pipeline_stats stats;
+
+#if PBB_HAVE_THREADS
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;
+    pthread_cond_t written;
+    int closing;
+#endif
+
+#if PBB_HAVE_IO_URING
+    pbb_uring ring;
+#endif
+};
+
+/**
+ * Allocate a pipeline and its buffers, without any backend.
+ */
+static pbb_pipeline* create_pipeline(size_t buffer_count, size_t buffer_capacity);
+
+/**
+ * Free a pipeline and its buffers once no backend uses them anymore.
+ */
+static void free_pipeline(pbb_pipeline* pipeline);
+
+/**
+ * Queue the current buffer, with [lengths] of it set, for output.
+ * Returns 0 if an output failed.
+ */
+static int enqueue(pbb_pipeline* pipeline);
+
+/**
+ * Wait until the buffer after the current one is written out.
+ * Returns 0 if an output failed.
+ */
+static int wait_for_next(pbb_pipeline* pipeline);
+
+/**
+ * Wait until all the submitted buffers are written out.
+ */
+static void drain(pbb_pipeline* pipeline);
+
+#if PBB_HAVE_THREADS
+static uint64_t now_nanoseconds(void);
+static int start_worker(pbb_pipeline* pipeline);
+static void* run_worker(void* arg);
+static void stop_worker(pbb_pipeline* pipeline);
+static int write_to_fd(const uint8_t* data, size_t size, void* context);
+#endif
+
+#if PBB_HAVE_IO_URING
+static int setup_uring(pbb_pipeline* pipeline);
+static void teardown_uring(pbb_uring* ring);
+
+/**
+ * Submit the writes of the queued buffers not written out nor in flight, as many as the ring allows,
+ * or only of the oldest one when writes go to the current position.
+ */
+static void start_writes(pbb_pipeline* pipeline);
+
+/**
+ * Account for the completion of a write of the buffer [index] returning [result].
+ */
+static void complete_write(pbb_pipeline* pipeline, size_t index, int result);
+
+/**
+ * Handle the completions available, returning their number.
+ */
+static unsigned take_completions(pbb_pipeline* pipeline);
+
+/**
+ * Block until at least one completion is available.
+ * Returns 0 if io_uring_enter fails.
+ */
+static int wait_completion(pbb_uring* ring);
+
+/**
+ * Handle the completed writes and start the next ones. With [wait], block until
+ * one more buffer is written out, or until an output fails.
+ */
+static void pump_uring(pbb_pipeline* pipeline, int wait);
+
+/**
+ * Wait for all the writes in flight to complete, without starting new ones, so that the kernel
+ * no longer reads the buffers. Gives up only if io_uring_enter fails, with [in_flight] left above 0.
+ */
+static void reap_uring(pbb_pipeline* pipeline);
+
+/**
+ * Move the file position past the bytes written out in order.
+ */
+static void sync_position(pbb_pipeline* pipeline);
+#endif
+
+pbb_pipeline* pbb_pipeline_create(size_t buffer_count, size_t buffer_capacity, pbb_sink_fn sink, void* context) {
+    if (sink == NULL) return NULL;
+
+    pbb_pipeline* pipeline = create_pipeline(buffer_count, buffer_capacity);
+    if (pipeline == NULL) return NULL;
+
+    pipeline->sink = sink;
+    pipeline->context = context;
+
+#if PBB_HAVE_THREADS
+    if (buffer_count > 1 && start_worker(pipeline)) pipeline->backend = PBB_PIPELINE_THREAD;
+#endif
+
+    return pipeline;
+}
+
+pbb_pipeline* pbb_pipeline_create_fd(int fd, size_t buffer_count, size_t buffer_capacity) {
+#if PBB_HAVE_THREADS
+    if (fd < 0) return NULL;
+
+    pbb_pipeline* pipeline = create_pipeline(buffer_count, buffer_capacity);
+    if (pipeline == NULL) return NULL;
+
+    pipeline->sink = write_to_fd;
+    pipeline->context = (void*)(intptr_t)fd;
+    pipeline->fd = fd;
+
+    if (buffer_count > 1) {
+#if PBB_HAVE_IO_URING
+        if (setup_uring(pipeline)) {
+            pipeline->backend = PBB_PIPELINE_IO_URING;
+            return pipeline;
+        }
+#endif
+        if (start_worker(pipeline)) pipeline->backend = PBB_PIPELINE_THREAD;
+    }
+
+    return pipeline;
+#else
+    (void)fd;
+    (void)buffer_count;
+    (void)buffer_capacity;
+    return NULL;
+#endif
+}
+
+partial_byte_buffer* pbb_pipeline_buffer(pbb_pipeline* pipeline) {
+    if (pipeline == NULL) return NULL;
+
+    partial_byte_buffer* current = pipeline->buffers[pipeline->stats.submitted % pipeline->buffer_count];
+    if ((current->write_pos >> 3) < pipeline->buffer_capacity) return current;
+
+    return pbb_pipeline_submit(pipeline);
+}
+
+partial_byte_buffer* pbb_pipeline_submit(pbb_pipeline* pipeline) {
+    if (pipeline == NULL) return NULL;
+
+    // The encoder is the only one changing [submitted], so it reads it without locking
+    size_t index = pipeline->stats.submitted % pipeline->buffer_count;
+    partial_byte_buffer* current = pipeline->buffers[index];
+    size_t complete = current->write_pos >> 3;
+    if (complete == 0) return current;
+
+    uint8_t partial = current->buffer[complete];
+    uint8_t partial_bits = current->write_pos & 7;
+    pipeline->lengths[index] = complete;
+
+    if (!enqueue(pipeline) || !wait_for_next(pipeline)) return NULL;
+
+    // The bytes past the last one written are zero already
+    partial_byte_buffer* next = pipeline->buffers[pipeline->stats.submitted % pipeline->buffer_count];
+    memset(next->buffer, 0, (next->write_pos + 7) >> 3);
+    next->buffer[0] = partial;
+    next->write_pos = partial_bits;
+    next->read_pos = 0;
+
+    return next;
+}
+
+int pbb_pipeline_finish(pbb_pipeline* pipeline) {
+    if (pipeline == NULL) return 0;
+
+    // The padding bits are already zero
+    partial_byte_buffer* current = pipeline->buffers[pipeline->stats.submitted % pipeline->buffer_count];
+    current->write_pos = (current->write_pos + 7) & ~(size_t)7;
+    if (pbb_pipeline_submit(pipeline) == NULL) return 0;
+
+    drain(pipeline);
+
+#if PBB_HAVE_THREADS
+    pthread_mutex_lock(&pipeline->lock);
+#endif
+    int failed = pipeline->failed;
+#if PBB_HAVE_THREADS
+    pthread_mutex_unlock(&pipeline->lock);
+#endif
+
+    return !failed;
+}
+
+pbb_pipeline_backend pbb_pipeline_get_backend(const pbb_pipeline* pipeline) {
+    return pipeline == NULL ? PBB_PIPELINE_BLOCKING : pipeline->backend;
+}
+
+void pbb_pipeline_get_stats(pbb_pipeline* pipeline, pbb_pipeline_stats* stats) {
+    if (pipeline == NULL || stats == NULL) return;
+
+#if PBB_HAVE_THREADS
+    pthread_mutex_lock(&pipeline->lock);
+#endif
+    *stats = pipeline->stats;
+#if PBB_HAVE_THREADS
+    pthread_mutex_unlock(&pipeline->lock);
+#endif
+
+    stats->queue_depth = stats->submitted - stats->completed;
+}
+
+void pbb_pipeline_destroy(pbb_pipeline** pipeline) {
+    if (*pipeline != NULL) {
+        drain(*pipeline);
+
+#if PBB_HAVE_THREADS
+        if ((*pipeline)->backend == PBB_PIPELINE_THREAD) stop_worker(*pipeline);
+#endif
+#if PBB_HAVE_IO_URING
+        if ((*pipeline)->backend == PBB_PIPELINE_IO_URING) {
+            // The kernel may still read the buffers of writes that could not be reaped: they are leaked, not freed
+            if ((*pipeline)->ring.in_flight > 0) {
+                *pipeline = NULL;
+                return;
+            }
+            teardown_uring(&(*pipeline)->ring);
+        }
+#endif
+
+        free_pipeline(*pipeline);
+    }
+
+    *pipeline = NULL;
+}
+
+static pbb_pipeline* create_pipeline(size_t buffer_count, size_t buffer_capacity) {
+    if (buffer_count == 0 || buffer_capacity == 0 || buffer_capacity > INT32_MAX - WRITE_HEADROOM) return NULL;
+
+    pbb_pipeline* pipeline = (pbb_pipeline*)calloc(1, sizeof(pbb_pipeline));
+    if (pipeline == NULL) return NULL;
+
+    pipeline->backend = PBB_PIPELINE_BLOCKING;
+    pipeline->buffer_count = buffer_count;
+    pipeline->buffer_capacity = buffer_capacity;
+    pipeline->fd = -1;
+
+#if PBB_HAVE_THREADS
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->queued, NULL);
+    pthread_cond_init(&pipeline->written, NULL);
+#endif
+
+    pipeline->buffers = (partial_byte_buffer**)calloc(buffer_count, sizeof(partial_byte_buffer*));
+    pipeline->lengths = (size_t*)calloc(buffer_count, sizeof(size_t));
+    if (pipeline->buffers == NULL || pipeline->lengths == NULL) {
+        free_pipeline(pipeline);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < buffer_count; ++i) {
+        pipeline->buffers[i] = pbb_create((int)(buffer_capacity + WRITE_HEADROOM));
+        if (pipeline->buffers[i] == NULL) {
+            free_pipeline(pipeline);
+            return NULL;
+        }
+    }
+
+    return pipeline;
+}
+
+static void free_pipeline(pbb_pipeline* pipeline) {
+    if (pipeline->buffers != NULL) {
+        for (size_t i = 0; i < pipeline->buffer_count; ++i) {
+            pbb_destroy(&pipeline->buffers[i]);
+        }
+    }
+
+#if PBB_HAVE_THREADS
+    pthread_mutex_destroy(&pipeline->lock);
+    pthread_cond_destroy(&pipeline->queued);
+    pthread_cond_destroy(&pipeline->written);
+#endif
+
+    free(pipeline->buffers);
+    free(pipeline->lengths);
+    free(pipeline);
+}
+
+static int enqueue(pbb_pipeline* pipeline) {
+    pbb_pipeline_stats* stats = &pipeline->stats;
+    size_t index = stats->submitted % pipeline->buffer_count;
+
+    switch (pipeline->backend) {
+#if PBB_HAVE_THREADS
+        case PBB_PIPELINE_THREAD: {
+            pthread_mutex_lock(&pipeline->lock);
+            int failed = pipeline->failed;
+            if (!failed) {
+                ++stats->submitted;
+                if (stats->submitted - stats->completed > stats->max_queue_depth) {
+                    stats->max_queue_depth = stats->submitted - stats->completed;
+                }
+                pthread_cond_signal(&pipeline->queued);
+            }
+            pthread_mutex_unlock(&pipeline->lock);
+            return !failed;
+        }
+#endif
+#if PBB_HAVE_IO_URING
+        case PBB_PIPELINE_IO_URING:
+            if (pipeline->failed) return 0;
+            pipeline->ring.offsets[index] = pipeline->ring.next_offset;
+            pipeline->ring.next_offset += pipeline->lengths[index];
+            ++stats->submitted;
+            if (stats->submitted - stats->completed > stats->max_queue_depth) {
+                stats->max_queue_depth = stats->submitted - stats->completed;
+            }
+            pump_uring(pipeline, 0);
+            return !pipeline->failed;
+#endif
+        default:
+            if (pipeline->failed) return 0;
+            if (!pipeline->sink(pipeline->buffers[index]->buffer, pipeline->lengths[index], pipeline->context)) {
+                pipeline->failed = 1;
+                return 0;
+            }
+            ++stats->submitted;
+            ++stats->completed;
+            stats->bytes_written += pipeline->lengths[index];
+            return 1;
+    }
+}
+
+static int wait_for_next(pbb_pipeline* pipeline) {
+    pbb_pipeline_stats* stats = &pipeline->stats;
+
+    switch (pipeline->backend) {
+#if PBB_HAVE_THREADS
+        case PBB_PIPELINE_THREAD: {
+            pthread_mutex_lock(&pipeline->lock);
+            if (stats->submitted - stats->completed >= pipeline->buffer_count && !pipeline->failed) {
+                uint64_t start = now_nanoseconds();
+                while (stats->submitted - stats->completed >= pipeline->buffer_count && !pipeline->failed) {
+                    pthread_cond_wait(&pipeline->written, &pipeline->lock);
+                }
+                ++stats->stalls;
+                stats->stall_nanoseconds += now_nanoseconds() - start;
+            }
+            int failed = pipeline->failed;
+            pthread_mutex_unlock(&pipeline->lock);
+            return !failed;
+        }
+#endif
+#if PBB_HAVE_IO_URING
+        case PBB_PIPELINE_IO_URING:
+            if (stats->submitted - stats->completed >= pipeline->buffer_count && !pipeline->failed) {
+                uint64_t start = now_nanoseconds();
+                while (stats->submitted - stats->completed >= pipeline->buffer_count && !pipeline->failed) {
+                    pump_uring(pipeline, 1);
+                }
+                ++stats->stalls;
+                stats->stall_nanoseconds += now_nanoseconds() - start;
+            }
+            return !pipeline->failed;
+#endif
+        default:
+            return !pipeline->failed;
+    }
+}
+
+static void drain(pbb_pipeline* pipeline) {
+    pbb_pipeline_stats* stats = &pipeline->stats;
+
+    switch (pipeline->backend) {
+#if PBB_HAVE_THREADS
+        case PBB_PIPELINE_THREAD:
+            // The worker goes through the queue even after a failure, dropping the buffers
+            pthread_mutex_lock(&pipeline->lock);
+            while (stats->completed != stats->submitted) {
+                pthread_cond_wait(&pipeline->written, &pipeline->lock);
+            }
+            pthread_mutex_unlock(&pipeline->lock);
+            break;
+#endif
+#if PBB_HAVE_IO_URING
+        case PBB_PIPELINE_IO_URING:
+            while (stats->completed != stats->submitted && !pipeline->failed) {
+                pump_uring(pipeline, 1);
+            }
+            reap_uring(pipeline);
+            sync_position(pipeline);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+#if PBB_HAVE_THREADS
+static uint64_t now_nanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static int start_worker(pbb_pipeline* pipeline) {
+    return pthread_create(&pipeline->worker, NULL, run_worker, pipeline) == 0;
+}
+
+static void* run_worker(void* arg) {
+    pbb_pipeline* pipeline = (pbb_pipeline*)arg;
+    pbb_pipeline_stats* stats = &pipeline->stats;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (stats->completed == stats->submitted && !pipeline->closing) {
+            pthread_cond_wait(&pipeline->queued, &pipeline->lock);
+        }
+        if (stats->completed == stats->submitted) break;
+
+        size_t index = stats->completed % pipeline->buffer_count;
+        const uint8_t* data = pipeline->buffers[index]->buffer;
+        size_t size = pipeline->lengths[index];
+        int skip = pipeline->failed;
+
+        // The encoder leaves the buffer alone until [completed] moves past it
+        pthread_mutex_unlock(&pipeline->lock);
+        int written = !skip && pipeline->sink(data, size, pipeline->context);
+        pthread_mutex_lock(&pipeline->lock);
+
+        // A failed sink may have consumed part of the buffer, so nothing after it is written out
+        if (written) {
+            stats->bytes_written += size;
+        } else {
+            pipeline->failed = 1;
+        }
+        ++stats->completed;
+        pthread_cond_signal(&pipeline->written);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return NULL;
+}
+
+static void stop_worker(pbb_pipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->closing = 1;
+    pthread_cond_signal(&pipeline->queued);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    pthread_join(pipeline->worker, NULL);
+}
+
+static int write_to_fd(const uint8_t* data, size_t size, void* context) {
+    int fd = (int)(intptr_t)context;
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+
+    return 1;
+}
+#endif
+
+#if PBB_HAVE_IO_URING
+/**
+ * Map one of the regions of an io_uring instance, returning NULL on failure.
+ */
+static void* map_uring(int fd, size_t size, off_t offset) {
+    void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return region == MAP_FAILED ? NULL : region;
+}
+
+static int setup_uring(pbb_pipeline* pipeline) {
+    pbb_uring* ring = &pipeline->ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    // The encoder fills one buffer while the others may all be in flight
+    unsigned entries = (unsigned)MIN(pipeline->buffer_count - 1, MAX_URING_ENTRIES);
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) return 0;
+
+    // Pipes and sockets have no offset: writes must go to the current position
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        teardown_uring(ring);
+        return 0;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sq_ring = map_uring(ring->fd, ring->sq_ring_size, IORING_OFF_SQ_RING);
+    ring->cq_ring = map_uring(ring->fd, ring->cq_ring_size, IORING_OFF_CQ_RING);
+    ring->sqes = (struct io_uring_sqe*)map_uring(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+    ring->offsets = (uint64_t*)calloc(pipeline->buffer_count, sizeof(uint64_t));
+    ring->progress = (size_t*)calloc(pipeline->buffer_count, sizeof(size_t));
+    ring->writing = (uint8_t*)calloc(pipeline->buffer_count, sizeof(uint8_t));
+    if (ring->sq_ring == NULL || ring->cq_ring == NULL || ring->sqes == NULL
+            || ring->offsets == NULL || ring->progress == NULL || ring->writing == NULL) {
+        teardown_uring(ring);
+        return 0;
+    }
+
+    uint8_t* sq = (uint8_t*)ring->sq_ring;
+    uint8_t* cq = (uint8_t*)ring->cq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    /**
+     * Writes at explicit offsets may complete in any order, so they can all be in flight at once.
+     * Without an offset, or in append mode, the kernel may reorder concurrent writes.
+     */
+    off_t position = lseek(pipeline->fd, 0, SEEK_CUR);
+    int flags = fcntl(pipeline->fd, F_GETFL);
+    ring->positional = position >= 0 && flags >= 0 && !(flags & O_APPEND);
+    ring->base_offset = ring->positional ? (uint64_t)position : 0;
+    ring->max_in_flight = ring->positional ? MIN(entries, params.sq_entries) : 1;
+
+    return 1;
+}
+
+static void teardown_uring(pbb_uring* ring) {
+    if (ring->sqes != NULL) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != NULL) munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring != NULL) munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    free(ring->offsets);
+    free(ring->progress);
+    free(ring->writing);
+    memset(ring, 0, sizeof(pbb_uring));
+}
+
+static void start_writes(pbb_pipeline* pipeline) {
+    pbb_uring* ring = &pipeline->ring;
+    pbb_pipeline_stats* stats = &pipeline->stats;
+    if (pipeline->failed) return;
+
+    size_t end = ring->positional ? stats->submitted : MIN(stats->submitted, stats->completed + 1);
+    unsigned tail = *ring->sq_tail;
+    unsigned queued = 0;
+    for (size_t i = stats->completed; i != end && ring->in_flight + queued < ring->max_in_flight; ++i) {
+        size_t index = i % pipeline->buffer_count;
+        if (ring->writing[index] || ring->progress[index] == pipeline->lengths[index]) continue;
+
+        // Short writes are resumed where they stopped
+        unsigned slot = (tail + queued) & *ring->sq_mask;
+        struct io_uring_sqe* sqe = &ring->sqes[slot];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = pipeline->fd;
+        sqe->addr = (uint64_t)(uintptr_t)(pipeline->buffers[index]->buffer + ring->progress[index]);
+        sqe->len = (uint32_t)MIN(pipeline->lengths[index] - ring->progress[index], MAX_URING_WRITE);
+        sqe->off = ring->positional ? ring->base_offset + ring->offsets[index] + ring->progress[index] : (uint64_t)-1;
+        sqe->user_data = index;
+        ring->sq_array[slot] = slot;
+        ring->writing[index] = 1;
+        ++queued;
+    }
+    if (queued == 0) return;
+
+    STORE_RELEASE(ring->sq_tail, tail + queued);
+    long result;
+    do {
+        result = syscall(__NR_io_uring_enter, ring->fd, queued, 0, 0, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+
+    // Every entry consumed by the kernel completes, even when its write fails
+    unsigned consumed = LOAD_ACQUIRE(ring->sq_head) - tail;
+    ring->in_flight += consumed;
+    if (consumed < queued) {
+        // The other entries are withdrawn, so that the next submission does not carry them along
+        for (unsigned i = consumed; i < queued; ++i) {
+            ring->writing[ring->sqes[(tail + i) & *ring->sq_mask].user_data] = 0;
+        }
+        STORE_RELEASE(ring->sq_tail, tail + consumed);
+        if (result < 0) pipeline->failed = 1;
+    }
+}
+
+static void complete_write(pbb_pipeline* pipeline, size_t index, int result) {
+    pbb_uring* ring = &pipeline->ring;
+    pbb_pipeline_stats* stats = &pipeline->stats;
+
+    ring->writing[index] = 0;
+    --ring->in_flight;
+
+    // Nothing written, or an interrupted write, is a short write submitted again
+    if (result > 0) {
+        ring->progress[index] += (size_t)result;
+        stats->bytes_written += (size_t)result;
+    } else if (result != 0 && result != -EINTR && result != -EAGAIN) {
+        pipeline->failed = 1;
+    }
+
+    // Buffers may complete out of order, but [completed] only moves past the oldest ones
+    while (stats->completed != stats->submitted) {
+        size_t oldest = stats->completed % pipeline->buffer_count;
+        if (ring->writing[oldest] || ring->progress[oldest] != pipeline->lengths[oldest]) break;
+        ring->progress[oldest] = 0;
+        ++stats->completed;
+    }
+}
+
+static unsigned take_completions(pbb_pipeline* pipeline) {
+    pbb_uring* ring = &pipeline->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = LOAD_ACQUIRE(ring->cq_tail);
+
+    for (unsigned i = head; i != tail; ++i) {
+        struct io_uring_cqe* cqe = &ring->cqes[i & *ring->cq_mask];
+        complete_write(pipeline, (size_t)cqe->user_data, cqe->res);
+    }
+    STORE_RELEASE(ring->cq_head, tail);
+
+    return tail - head;
+}
+
+static int wait_completion(pbb_uring* ring) {
+    return syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) >= 0 || errno == EINTR;
+}
+
+static void pump_uring(pbb_pipeline* pipeline, int wait) {
+    pbb_uring* ring = &pipeline->ring;
+    size_t completed = pipeline->stats.completed;
+
+    start_writes(pipeline);
+    while (ring->in_flight > 0) {
+        if (take_completions(pipeline) > 0) {
+            start_writes(pipeline);
+            continue;
+        }
+        if (!wait || pipeline->stats.completed != completed) return;
+        if (!wait_completion(ring)) {
+            pipeline->failed = 1;
+            reap_uring(pipeline);
+            return;
+        }
+    }
+}
+
+static void reap_uring(pbb_pipeline* pipeline) {
+    pbb_uring* ring = &pipeline->ring;
+    while (ring->in_flight > 0) {
+        if (take_completions(pipeline) == 0 && !wait_completion(ring)) return;
+    }
+}
+
+static void sync_position(pbb_pipeline* pipeline) {
+    pbb_uring* ring = &pipeline->ring;
+    pbb_pipeline_stats* stats = &pipeline->stats;
+    if (!ring->positional) return;
+
+    // After a failure, the bytes past the first one missing are left as the writes put them
+    uint64_t offset = ring->next_offset;
+    if (stats->completed != stats->submitted) {
+        size_t oldest = stats->completed % pipeline->buffer_count;
+        offset = ring->offsets[oldest] + ring->progress[oldest];
+    }
+    if (offset != ring->synced_offset && lseek(pipeline->fd, (off_t)(ring->base_offset + offset), SEEK_SET) >= 0) {
+        ring->synced_offset = offset;
+    }
+}
+#endif
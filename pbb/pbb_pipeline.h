@@ -0,0 +1,123 @@
+#ifndef PBB_PIPELINE_H
+#define PBB_PIPELINE_H
+
+#include "partial_byte_buffer.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * How the buffers of a pipeline are written out.
+ */
+typedef enum pbb_pipeline_backend {
+    /**
+     * Submitted buffers are handed to the sink before pbb_pipeline_submit returns.
+     * Used with a single buffer, or when no other backend is available.
+     */
+    PBB_PIPELINE_BLOCKING = 0,
+
+    /**
+     * A worker thread hands the submitted buffers to the sink while the encoder fills the next one.
+     */
+    PBB_PIPELINE_THREAD,
+
+    /**
+     * The submitted buffers are written to a file descriptor through io_uring, from the encoder thread.
+     */
+    PBB_PIPELINE_IO_URING
+} pbb_pipeline_backend;
+
+/**
+ * Counters of a pipeline, taken at once by pbb_pipeline_get_stats.
+ */
+typedef struct pbb_pipeline_stats {
+    /**
+     * Number of buffers submitted, and written out completely.
+     */
+    size_t submitted;
+    size_t completed;
+
+    /**
+     * Number of bytes written out so far. With a sink, only the buffers it fully accepted are counted.
+     */
+    uint64_t bytes_written;
+
+    /**
+     * Number of buffers submitted but not written out yet, now and at most.
+     */
+    size_t queue_depth;
+    size_t max_queue_depth;
+
+    /**
+     * Back-pressure: number of times the encoder had to wait for a buffer to be written out
+     * before filling it again, and the total time waited.
+     */
+    size_t stalls;
+    uint64_t stall_nanoseconds;
+} pbb_pipeline_stats;
+
+/**
+ * Writer encoding into one buffer while the buffers filled before are written out.
+ * The buffers are filled and written in turn: the encoder blocks only when all of them wait for output.
+ */
+typedef struct pbb_pipeline pbb_pipeline;
+
+/**
+ * Create a pipeline of [buffer_count] buffers of [buffer_capacity] bytes, handed to [sink] by a worker thread.
+ * [sink] is called with [context] from that thread, one buffer at a time and in order.
+ * A sink failing may have consumed part of its buffer: the output is then unknown past the buffers
+ * written before, and the stream cannot be resumed, as the pipeline drops every buffer after it.
+ * A single buffer, or a platform without threads, gives the blocking backend.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+pbb_pipeline* pbb_pipeline_create(size_t buffer_count, size_t buffer_capacity, pbb_sink_fn sink, void* context);
+
+/**
+ * Create a pipeline of [buffer_count] buffers of [buffer_capacity] bytes written to the file descriptor [fd],
+ * which is not closed by the pipeline. Writes go through io_uring when the kernel supports it,
+ * and through a worker thread or blocking writes otherwise.
+ * With io_uring, a file with an offset gets up to [buffer_count] - 1 writes in flight, each at the offset
+ * of its buffer from the position of [fd] at creation, and the position moves past the bytes written
+ * when the pipeline is finished or destroyed. Pipes, sockets and files in append mode get one write at a time.
+ * Returns NULL for invalid parameters or if memory allocation fails.
+ */
+pbb_pipeline* pbb_pipeline_create_fd(int fd, size_t buffer_count, size_t buffer_capacity);
+
+/**
+ * Return the buffer to encode into. When the current one holds at least [buffer_capacity] bytes,
+ * it is submitted first, as with pbb_pipeline_submit.
+ * Returns NULL after an output error.
+ */
+partial_byte_buffer* pbb_pipeline_buffer(pbb_pipeline* pipeline);
+
+/**
+ * Queue the complete bytes of the current buffer for output and return the next buffer,
+ * waiting for it to be written out if needed. The partial last byte moves to the next buffer.
+ * The buffers returned before must not be used anymore.
+ * Returns NULL after an output error.
+ */
+partial_byte_buffer* pbb_pipeline_submit(pbb_pipeline* pipeline);
+
+/**
+ * End the stream: pad the partial last byte with zero bits, submit it and wait for all buffers to be written out.
+ * Returns 1 on success, or 0 if an output failed, in which case what reached the output is unknown
+ * and the stream has to be written again from its start.
+ */
+int pbb_pipeline_finish(pbb_pipeline* pipeline);
+
+/**
+ * Return the backend chosen for a pipeline.
+ */
+pbb_pipeline_backend pbb_pipeline_get_backend(const pbb_pipeline* pipeline);
+
+/**
+ * Copy the current counters of a pipeline to [stats].
+ */
+void pbb_pipeline_get_stats(pbb_pipeline* pipeline, pbb_pipeline_stats* stats);
+
+/**
+ * Destroy a pipeline after waiting for the buffers already submitted to be written out.
+ * Bits not submitted are dropped. Sets the pointer to NULL after destruction.
+ */
+void pbb_pipeline_destroy(pbb_pipeline** pipeline);
+
+#endif // PBB_PIPELINE_H
@@ -0,0 +1,216 @@
+#include "pbb_spsc.h"
+#include "pbb_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static const size_t MIN_SPSC_CAPACITY = 16;
+
+/**
+ * Fields up to this length are appended to the pending bits of the producer in one 64-bit shift.
+ */
+static const uint8_t MAX_PUSH_BITS = 56;
+
+/**
+ * Shorthands for the atomic accesses to the cursors shared between the two threads.
+ * GCC builtins are used since the library is compiled both as C and as C++.
+ */
+#define LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+/**
+ * Producer: check that the bytes reached by writing [bits] more bits fit in the ring,
+ * refreshing the cached consumer cursor only when the cached one is not enough.
+ */
+static int has_room(pbb_spsc* spsc, size_t bits);
+
+/**
+ * Producer: append the lowest [bits] bits (1-56) of [value] and store every completed byte in the ring.
+ */
+static void push_bits(pbb_spsc* spsc, uint64_t value, uint8_t bits);
+
+/**
+ * Producer: make the completed bytes visible to the consumer.
+ */
+static void publish(pbb_spsc* spsc);
+
+/**
+ * Consumer: return the [bits] bits (1-64) at the read cursor as an unsigned value.
+ * Only the bytes holding the field are loaded, since the following ones may be under write.
+ */
+static uint64_t load_bits(const pbb_spsc* spsc, uint8_t bits);
+
+/**
+ * Consumer: hand the bytes fully read back to the producer.
+ */
+static void release(pbb_spsc* spsc);
+
+pbb_spsc* pbb_spsc_create(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 4)) return NULL;
+
+    size_t ring_capacity = MIN_SPSC_CAPACITY;
+    while (ring_capacity < capacity) ring_capacity <<= 1;
+
+    // The cursors are cache-line aligned, which malloc does not guarantee
+    pbb_spsc* spsc = (pbb_spsc*)aligned_alloc(PBB_CACHE_LINE_SIZE, sizeof(pbb_spsc));
+    if (spsc == NULL) return NULL;
+
+    spsc->buffer = (uint8_t*)calloc(ring_capacity, 1);
+    if (spsc->buffer == NULL) {
+        free(spsc);
+        return NULL;
+    }
+
+    spsc->capacity = ring_capacity;
+    memset(&spsc->producer, 0, sizeof(spsc->producer));
+    memset(&spsc->consumer, 0, sizeof(spsc->consumer));
+
+    return spsc;
+}
+
+void pbb_spsc_destroy(pbb_spsc** spsc) {
+    if (*spsc != NULL) {
+        free((*spsc)->buffer);
+        free(*spsc);
+    }
+
+    *spsc = NULL;
+}
+
+int pbb_spsc_write(pbb_spsc* spsc, int64_t value, uint8_t bits) {
+    if (spsc == NULL || bits <= 0 || bits > 64) return 0;
+    if (!has_room(spsc, bits)) return 0;
+
+    uint64_t data = (uint64_t)value;
+    if (bits < 64) data &= ((uint64_t)1 << bits) - 1;
+
+    if (bits > MAX_PUSH_BITS) {
+        push_bits(spsc, data >> 32, bits - 32);
+        push_bits(spsc, data & 0xFFFFFFFF, 32);
+    } else {
+        push_bits(spsc, data, bits);
+    }
+    publish(spsc);
+
+    return 1;
+}
+
+int pbb_spsc_flush(pbb_spsc* spsc) {
+    if (spsc == NULL) return 0;
+
+    uint8_t used = spsc->producer.write_pos & 7;
+    if (used == 0) return 1;
+    if (!has_room(spsc, 8 - used)) return 0;
+
+    push_bits(spsc, 0, 8 - used);
+    publish(spsc);
+
+    return 1;
+}
+
+size_t pbb_spsc_writable_bits(pbb_spsc* spsc) {
+    if (spsc == NULL) return 0;
+
+    spsc->producer.released_cache = LOAD_ACQUIRE(&spsc->consumer.released);
+    return ((spsc->producer.released_cache + spsc->capacity) << 3) - spsc->producer.write_pos;
+}
+
+int pbb_spsc_read(pbb_spsc* spsc, int64_t* value, uint8_t bits) {
+    if (spsc == NULL || value == NULL || bits <= 0 || bits > 64) return 0;
+
+    size_t end = spsc->consumer.read_pos + bits;
+    if (end > spsc->consumer.published_cache << 3) {
+        spsc->consumer.published_cache = LOAD_ACQUIRE(&spsc->producer.published);
+        if (end > spsc->consumer.published_cache << 3) return 0;
+    }
+
+    uint64_t result = load_bits(spsc, bits);
+    spsc->consumer.read_pos = end;
+    release(spsc);
+
+    // Sign extension for negative values
+    if (bits < 64) {
+        result = (uint64_t)((int64_t)(result << (64 - bits)) >> (64 - bits));
+    }
+    *value = (int64_t)result;
+
+    return 1;
+}
+
+void pbb_spsc_align_read(pbb_spsc* spsc) {
+    if (spsc == NULL) return;
+
+    spsc->consumer.read_pos = (spsc->consumer.read_pos + 7) & ~(size_t)7;
+    release(spsc);
+}
+
+size_t pbb_spsc_readable_bits(pbb_spsc* spsc) {
+    if (spsc == NULL) return 0;
+
+    spsc->consumer.published_cache = LOAD_ACQUIRE(&spsc->producer.published);
+    return (spsc->consumer.published_cache << 3) - spsc->consumer.read_pos;
+}
+
+static int has_room(pbb_spsc* spsc, size_t bits) {
+    // The partial byte holding the last bits counts as used, though it is only stored once completed
+    size_t end_byte = (spsc->producer.write_pos + bits + 7) >> 3;
+    if (end_byte <= spsc->producer.released_cache + spsc->capacity) return 1;
+
+    spsc->producer.released_cache = LOAD_ACQUIRE(&spsc->consumer.released);
+    return end_byte <= spsc->producer.released_cache + spsc->capacity;
+}
+
+static void push_bits(pbb_spsc* spsc, uint64_t value, uint8_t bits) {
+    size_t mask = spsc->capacity - 1;
+    size_t byte_pos = spsc->producer.write_pos >> 3;
+    uint8_t filled = (spsc->producer.write_pos & 7) + bits;
+    uint64_t pending = (spsc->producer.pending << bits) | value;
+
+    /**
+     * Completed bytes are stored whole: the ring is never read-modify-written,
+     * so the bytes handed back by the consumer need no clearing.
+     */
+    while (filled >= 8) {
+        filled -= 8;
+        spsc->buffer[byte_pos++ & mask] = (uint8_t)(pending >> filled);
+    }
+
+    spsc->producer.pending = pending & (((uint64_t)1 << filled) - 1);
+    spsc->producer.write_pos += bits;
+}
+
+static void publish(pbb_spsc* spsc) {
+    size_t published = spsc->producer.write_pos >> 3;
+    if (published != spsc->producer.published) {
+        STORE_RELEASE(&spsc->producer.published, published);
+    }
+}
+
+static uint64_t load_bits(const pbb_spsc* spsc, uint8_t bits) {
+    size_t mask = spsc->capacity - 1;
+    size_t byte_pos = spsc->consumer.read_pos >> 3;
+    uint8_t bit_pos = spsc->consumer.read_pos & 7;
+    uint8_t field_bytes = (bit_pos + bits + 7) >> 3;
+
+    // Copy the field into a zeroed window, unwrapping the ring
+    uint8_t window[2 * sizeof(uint64_t)] = {0};
+    size_t offset = byte_pos & mask;
+    size_t contiguous = MIN((size_t)field_bytes, spsc->capacity - offset);
+    memcpy(window, spsc->buffer + offset, contiguous);
+    memcpy(window + contiguous, spsc->buffer, field_bytes - contiguous);
+
+    uint64_t word = load_be64(window) << bit_pos;
+    if (bit_pos + bits > 64) {
+        word |= window[8] >> (8 - bit_pos);
+    }
+
+    return word >> (64 - bits);
+}
+
+static void release(pbb_spsc* spsc) {
+    size_t released = spsc->consumer.read_pos >> 3;
+    if (released != spsc->consumer.released) {
+        STORE_RELEASE(&spsc->consumer.released, released);
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef PBB_SPSC_H
+#define PBB_SPSC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Size of the cache lines the producer and consumer cursors are kept apart on.
+ */
+#define PBB_CACHE_LINE_SIZE 64
+
+/**
+ * Cursor state owned by the producer thread.
+ */
+typedef struct __attribute__((aligned(PBB_CACHE_LINE_SIZE))) pbb_spsc_producer {
+    /**
+     * Bit position for the next write operation, counted from the creation of the stream.
+     */
+    size_t write_pos;
+
+    /**
+     * Bits of the byte under [write_pos] not stored yet, in the lowest (write_pos & 7) bits.
+     */
+    uint64_t pending;
+
+    /**
+     * Number of whole bytes made visible to the consumer. Stored with release semantics.
+     */
+    size_t published;
+
+    /**
+     * Last value of the consumer's [released] seen by the producer.
+     */
+    size_t released_cache;
+} pbb_spsc_producer;
+
+/**
+ * Cursor state owned by the consumer thread.
+ */
+typedef struct __attribute__((aligned(PBB_CACHE_LINE_SIZE))) pbb_spsc_consumer {
+    /**
+     * Bit position for the next read operation, counted from the creation of the stream.
+     */
+    size_t read_pos;
+
+    /**
+     * Number of whole bytes handed back to the producer. Stored with release semantics.
+     */
+    size_t released;
+
+    /**
+     * Last value of the producer's [published] seen by the consumer.
+     */
+    size_t published_cache;
+} pbb_spsc_consumer;
+
+/**
+ * Lock-free bit stream between exactly one producer thread and one consumer thread.
+ * Data flows through a ring of bytes: the producer publishes every completed byte, and the consumer
+ * hands bytes back once all their bits are read. Both sides are wait-free: a write that does not fit
+ * or a read of bits not published yet fails immediately instead of blocking.
+ */
+typedef struct pbb_spsc {
+    /**
+     * Ring of [capacity] bytes shared by both threads.
+     */
+    uint8_t* buffer;
+
+    /**
+     * Number of bytes of the ring, a power of 2.
+     */
+    size_t capacity;
+
+    pbb_spsc_producer producer;
+    pbb_spsc_consumer consumer;
+} pbb_spsc;
+
+/**
+ * Create an SPSC bit stream with a ring of [capacity] bytes, rounded up to a power of 2 (at least 16).
+ * Returns NULL for an invalid capacity or if memory allocation fails.
+ */
+pbb_spsc* pbb_spsc_create(size_t capacity);
+
+/**
+ * Destroy an SPSC bit stream once neither thread uses it anymore.
+ * Sets the pointer to NULL after destruction.
+ */
+void pbb_spsc_destroy(pbb_spsc** spsc);
+
+/**
+ * Producer: write a signed 64-bit integer having a length of [bits] (1-64) to the stream.
+ * Every byte it completes becomes visible to the consumer.
+ * Returns 1 on success, or 0 if the ring has no room for it, in which case nothing is written.
+ */
+int pbb_spsc_write(pbb_spsc* spsc, int64_t value, uint8_t bits);
+
+/**
+ * Producer: pad the last partial byte with zero bits and publish it, so the consumer can read
+ * all the bits written so far. Returns 1 on success, or 0 if the ring has no room for the byte.
+ */
+int pbb_spsc_flush(pbb_spsc* spsc);
+
+/**
+ * Producer: return the number of bits that can be written without failing.
+ */
+size_t pbb_spsc_writable_bits(pbb_spsc* spsc);
+
+/**
+ * Consumer: read a signed 64-bit integer having a length of [bits] (1-64) from the stream into [value].
+ * Returns 1 on success, or 0 if fewer bits are published, in which case nothing is read.
+ */
+int pbb_spsc_read(pbb_spsc* spsc, int64_t* value, uint8_t bits);
+
+/**
+ * Consumer: skip the bits up to the next byte boundary, such as the padding of pbb_spsc_flush.
+ */
+void pbb_spsc_align_read(pbb_spsc* spsc);
+
+/**
+ * Consumer: return the number of published bits that can be read without failing.
+ */
+size_t pbb_spsc_readable_bits(pbb_spsc* spsc);
+
+#endif // PBB_SPSC_H
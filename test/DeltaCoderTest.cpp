@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class DeltaCoderTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+
+        /**
+         * Epoch milliseconds of track points at 1 Hz, with a few late or missing points.
+         */
+        static std::vector<int64_t> timestamps(size_t count) {
+            std::vector<int64_t> values;
+            int64_t time = 1760700000000;
+            srand(25);
+            while (values.size() < count) {
+                values.push_back(time);
+                time += rand() % 50 == 0 ? 1000 + rand() % 3000 : 1000;
+            }
+            return values;
+        }
+
+        /**
+         * Cumulative distances in centimeters of a run, 2 to 4 meters per second.
+         */
+        static std::vector<int64_t> distances(size_t count) {
+            std::vector<int64_t> values;
+            int64_t distance = 0;
+            srand(52);
+            while (values.size() < count) {
+                values.push_back(distance);
+                distance += 200 + rand() % 200;
+            }
+            return values;
+        }
+
+        /**
+         * Values whose residuals sit on both sides of every bucket boundary, and wrap around 64 bits.
+         */
+        static std::vector<int64_t> boundaries(pbb_delta_order order) {
+            const int64_t residuals[] = {
+                0, 1, -1, 63, -64, 64, -65, 255, -256, 256, -257, 2047, -2048, 2048, -2049,
+                INT32_MAX, INT32_MIN, (int64_t)INT32_MAX + 1, (int64_t)INT32_MIN - 1,
+                INT64_MAX, INT64_MIN, 0
+            };
+            std::vector<int64_t> values = {INT64_MIN};
+            uint64_t delta = 0;
+            for (int64_t residual : residuals) {
+                delta = order == PBB_DELTA_OF_DELTA ? delta + (uint64_t)residual : (uint64_t)residual;
+                values.push_back((int64_t)((uint64_t)values.back() + delta));
+            }
+            return values;
+        }
+};
+
+TEST_F(DeltaCoderTest, WriteDelta_RegularTimestamps_OneBitPerPoint) {
+    pbb = pbb_create(8);
+    pbb_delta_coder coder;
+    pbb_delta_coder_init(&coder, PBB_DELTA_OF_DELTA);
+
+    for (int64_t i = 0; i < 1800; ++i) {
+        ASSERT_EQ(pbb_write_delta(pbb, &coder, 1760700000000 + i * 1000), 1);
+    }
+    // 64 bits for the first point, 4 + 12 bits for the first interval, then 1 bit per point
+    ASSERT_EQ(pbb->write_pos, 64 + 16 + 1798);
+    ASSERT_EQ(coder.count, 1800u);
+
+    pbb_delta_coder reader;
+    pbb_delta_coder_init(&reader, PBB_DELTA_OF_DELTA);
+    for (int64_t i = 0; i < 1800; ++i) {
+        ASSERT_EQ(pbb_read_delta(pbb, &reader), 1760700000000 + i * 1000) << "point " << i;
+    }
+}
+
+TEST_F(DeltaCoderTest, WriteDelta_BucketWidths_CodeLengths) {
+    const int64_t residuals[] = {0, 63, -64, 64, -256, 2047, -2049, INT32_MIN, (int64_t)INT32_MAX + 1};
+    const size_t lengths[] = {1, 2 + 7, 2 + 7, 3 + 9, 3 + 9, 4 + 12, 5 + 32, 5 + 32, 5 + 64};
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+        pbb = pbb_create(16);
+        pbb_delta_coder coder;
+        pbb_delta_coder_init(&coder, PBB_DELTA);
+        pbb_write_delta(pbb, &coder, 1000);
+        pbb_write_delta(pbb, &coder, 1000 + residuals[i]);
+        ASSERT_EQ(pbb->write_pos, 64 + lengths[i]) << "residual " << residuals[i];
+        pbb_destroy(&pbb);
+    }
+}
+
+TEST_F(DeltaCoderTest, ReadDelta_BoundariesAndWrapAround_SameValues) {
+    for (pbb_delta_order order : {PBB_DELTA, PBB_DELTA_OF_DELTA}) {
+        std::vector<int64_t> values = boundaries(order);
+        pbb = pbb_create(4);
+        pbb_delta_coder coder;
+        pbb_delta_coder_init(&coder, order);
+        for (int64_t value : values) ASSERT_EQ(pbb_write_delta(pbb, &coder, value), 1);
+
+        pbb_delta_coder reader;
+        pbb_delta_coder_init(&reader, order);
+        for (size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(pbb_read_delta(pbb, &reader), values[i]) << "order " << order << " value " << i;
+        }
+        pbb_destroy(&pbb);
+    }
+}
+
+TEST_F(DeltaCoderTest, WriteDeltaArray_SameBitsAsPerValue) {
+    std::vector<int64_t> values = distances(1000);
+    std::vector<int64_t> extremes = boundaries(PBB_DELTA);
+    values.insert(values.begin() + 300, extremes.begin(), extremes.end());
+
+    for (pbb_delta_order order : {PBB_DELTA, PBB_DELTA_OF_DELTA}) {
+        pbb = pbb_create(1);
+        partial_byte_buffer* expected = pbb_create(1);
+        pbb_delta_coder coder;
+        pbb_delta_coder expected_coder;
+        pbb_delta_coder_init(&coder, order);
+        pbb_delta_coder_init(&expected_coder, order);
+
+        pbb_write_byte(pbb, 0x5, 3);
+        pbb_write_byte(expected, 0x5, 3);
+        // Two calls, so that the second one starts with a coder in the middle of the channel
+        ASSERT_EQ(pbb_write_delta_array(pbb, &coder, values.data(), 700), 700u);
+        ASSERT_EQ(pbb_write_delta_array(pbb, &coder, values.data() + 700, values.size() - 700), values.size() - 700);
+        for (int64_t value : values) pbb_write_delta(expected, &expected_coder, value);
+
+        ASSERT_EQ(pbb->write_pos, expected->write_pos);
+        ASSERT_EQ(memcmp(pbb->buffer, expected->buffer, pbb_get_length(expected)), 0);
+        ASSERT_EQ(coder.count, expected_coder.count);
+        ASSERT_EQ(coder.previous, expected_coder.previous);
+        ASSERT_EQ(coder.previous_delta, expected_coder.previous_delta);
+        pbb_destroy(&expected);
+        pbb_destroy(&pbb);
+    }
+}
+
+TEST_F(DeltaCoderTest, ReadDeltaArray_Contiguous_SameAsPerValue) {
+    std::vector<int64_t> values = timestamps(3000);
+    std::vector<int64_t> extremes = boundaries(PBB_DELTA_OF_DELTA);
+    values.insert(values.begin() + 1000, extremes.begin(), extremes.end());
+    pbb = pbb_create(8);
+    pbb_delta_coder coder;
+    pbb_delta_coder_init(&coder, PBB_DELTA_OF_DELTA);
+    ASSERT_EQ(pbb_write_delta_array(pbb, &coder, values.data(), values.size()), values.size());
+
+    std::vector<uint8_t> bytes(pbb->buffer, pbb->buffer + pbb_get_length(pbb));
+    partial_byte_buffer* wrapped = pbb_wrap_array(bytes.data(), bytes.size());
+
+    for (partial_byte_buffer* buffer : {pbb, wrapped}) {
+        pbb_delta_coder reader;
+        pbb_delta_coder_init(&reader, PBB_DELTA_OF_DELTA);
+        std::vector<int64_t> read(values.size());
+        // Uneven calls, so that codes are read both straight from memory and through the buffer
+        ASSERT_EQ(pbb_read_delta_array(buffer, &reader, read.data(), 1), 1u);
+        ASSERT_EQ(pbb_read_delta_array(buffer, &reader, read.data() + 1, 1234), 1234u);
+        ASSERT_EQ(pbb_read_delta_array(buffer, &reader, read.data() + 1235, values.size() - 1235), values.size() - 1235);
+        ASSERT_EQ(read, values);
+        ASSERT_EQ(reader.count, values.size());
+    }
+    pbb_destroy(&wrapped);
+}
+
+TEST_F(DeltaCoderTest, DeltaArray_SegmentedAndRing_SameValues) {
+    std::vector<int64_t> values = distances(2000);
+
+    for (int ring = 0; ring < 2; ++ring) {
+        pbb = ring ? pbb_create_ring(4096) : pbb_create_segmented(32);
+        pbb_delta_coder coder;
+        pbb_delta_coder_init(&coder, PBB_DELTA);
+        ASSERT_EQ(pbb_write_delta_array(pbb, &coder, values.data(), values.size()), values.size());
+
+        pbb_delta_coder reader;
+        pbb_delta_coder_init(&reader, PBB_DELTA);
+        std::vector<int64_t> read(values.size() + 1);
+        ASSERT_EQ(pbb_read_delta_array(pbb, &reader, read.data(), values.size()), values.size());
+        read.resize(values.size());
+        ASSERT_EQ(read, values) << (ring ? "ring" : "segmented");
+        pbb_destroy(&pbb);
+    }
+}
+
+TEST_F(DeltaCoderTest, WriteDelta_FullRing_BufferAndCoderUnchanged) {
+    pbb = pbb_create_ring(24);
+    pbb_delta_coder coder;
+    pbb_delta_coder_init(&coder, PBB_DELTA);
+
+    ASSERT_EQ(pbb_write_delta(pbb, &coder, 5), 1);
+    ASSERT_EQ(pbb_write_delta(pbb, &coder, 5 + ((int64_t)1 << 40)), 1);
+    ASSERT_EQ(pbb_ring_free_bits(pbb), 192u - 64 - 69);
+    pbb_delta_coder before = coder;
+
+    ASSERT_EQ(pbb_write_delta(pbb, &coder, 0), 0);
+    ASSERT_EQ(coder.count, before.count);
+    ASSERT_EQ(coder.previous, before.previous);
+    ASSERT_EQ(pbb_ring_free_bits(pbb), 192u - 64 - 69);
+
+    // The array stops at the last code that fits
+    const int64_t values[] = {5 + ((int64_t)1 << 40), 6 + ((int64_t)1 << 40), 0};
+    ASSERT_EQ(pbb_write_delta_array(pbb, &coder, values, 3), 2u);
+    ASSERT_EQ(coder.previous, values[1]);
+}
+
+TEST_F(DeltaCoderTest, ReadDelta_TruncatedCode_NothingConsumed) {
+    pbb = pbb_create(16);
+    pbb_delta_coder coder;
+    pbb_delta_coder_init(&coder, PBB_DELTA);
+    pbb_write_delta(pbb, &coder, 100);
+    // A 9-bit residual whose code is cut after its prefix
+    pbb_write_byte(pbb, 0x6, 3);
+    ASSERT_EQ(pbb->write_pos, 67);
+
+    pbb_delta_coder reader;
+    pbb_delta_coder_init(&reader, PBB_DELTA);
+    ASSERT_EQ(pbb_read_delta(pbb, &reader), 100);
+    pbb_delta_coder before = reader;
+    ASSERT_EQ(pbb_read_delta(pbb, &reader), 0);
+    ASSERT_EQ(pbb->read_pos, 64);
+    ASSERT_EQ(reader.count, before.count);
+    ASSERT_EQ(reader.previous, before.previous);
+
+    int64_t values[4];
+    ASSERT_EQ(pbb_read_delta_array(pbb, &reader, values, 4), 0u);
+    ASSERT_EQ(pbb->read_pos, 64);
+}
+
+TEST_F(DeltaCoderTest, DeltaFunctions_Null_NothingDone) {
+    pbb = pbb_create(4);
+    pbb_delta_coder coder;
+    pbb_delta_coder_init(&coder, PBB_DELTA);
+    pbb_delta_coder_init(nullptr, PBB_DELTA);
+    int64_t values[1] = {7};
+
+    ASSERT_EQ(pbb_write_delta(nullptr, &coder, 1), 0);
+    ASSERT_EQ(pbb_write_delta(pbb, nullptr, 1), 0);
+    ASSERT_EQ(pbb_write_delta_array(pbb, &coder, nullptr, 1), 0u);
+    ASSERT_EQ(pbb_read_delta(pbb, nullptr), 0);
+    ASSERT_EQ(pbb_read_delta_array(pbb, &coder, nullptr, 1), 0u);
+    ASSERT_EQ(pbb_read_delta_array(pbb, &coder, values, 1), 0u);
+    ASSERT_EQ(pbb->write_pos, 0);
+    ASSERT_EQ(coder.count, 0u);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+class FixedPointTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+            pbb_destroy(&pbb);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        /**
+         * Longitudes with 5 decimal places, including both limits.
+         */
+        static std::vector<double> longitudes(size_t count) {
+            std::vector<double> values = {180.0, -180.0, 0.00001, 0.0, -0.00001};
+            srand(24);
+            while (values.size() < count) {
+                values.push_back(std::round(((double)rand() / RAND_MAX * 360 - 180) * 1e5) / 1e5);
+            }
+            return values;
+        }
+};
+
+TEST_F(FixedPointTest, FormatInit_Longitudes_26Bits) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -180.0, 180.0, 0.00001), 1);
+    ASSERT_EQ(format.max_code, 36000000u);
+    ASSERT_EQ(format.bits, 26);
+
+    ASSERT_EQ(fxp_format_init(&format, -40.0, 60.0, 0.01), 1);
+    ASSERT_EQ(format.bits, 14);
+
+    ASSERT_EQ(fxp_format_init(&format, 5.0, 5.0, 1.0), 1);
+    ASSERT_EQ(format.max_code, 0u);
+    ASSERT_EQ(format.bits, 1);
+}
+
+TEST_F(FixedPointTest, FormatInit_InvalidRangeOrStep_Failure) {
+    fxp_format format;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    ASSERT_EQ(fxp_format_init(&format, 1.0, 0.0, 0.1), 0);
+    ASSERT_EQ(fxp_format_init(&format, 0.0, 1.0, 0.0), 0);
+    ASSERT_EQ(fxp_format_init(&format, 0.0, 1.0, -0.1), 0);
+    ASSERT_EQ(fxp_format_init(&format, 0.0, 1.0, nan), 0);
+    ASSERT_EQ(fxp_format_init(&format, nan, 1.0, 0.1), 0);
+    ASSERT_EQ(fxp_format_init(&format, 0.0, inf, 0.1), 0);
+    ASSERT_EQ(fxp_format_init(&format, 0.0, 1.0, 1e-16), 0);
+    ASSERT_EQ(fxp_format_init(nullptr, 0.0, 1.0, 0.1), 0);
+
+    ASSERT_EQ(fxp_format_init(&format, 0.0, std::ldexp(1.0, 52) - 1, 1.0), 1);
+    ASSERT_EQ(format.bits, FXP_MAX_BITS);
+}
+
+TEST_F(FixedPointTest, Quantize_BoundsOutOfRangeAndNan_ClampedCodes) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -40.0, 60.0, 0.5), 1);
+
+    ASSERT_EQ(fxp_quantize(&format, -40.0), 0u);
+    ASSERT_EQ(fxp_quantize(&format, 60.0), 200u);
+    ASSERT_EQ(fxp_quantize(&format, 0.2), 80u);
+    ASSERT_EQ(fxp_quantize(&format, 0.3), 81u);
+    // Ties go to the even code
+    ASSERT_EQ(fxp_quantize(&format, 0.25), 80u);
+    ASSERT_EQ(fxp_quantize(&format, 0.75), 82u);
+    ASSERT_EQ(fxp_quantize(&format, -100.0), 0u);
+    ASSERT_EQ(fxp_quantize(&format, 1e300), 200u);
+    ASSERT_EQ(fxp_quantize(&format, std::numeric_limits<double>::infinity()), 200u);
+    ASSERT_EQ(fxp_quantize(&format, -std::numeric_limits<double>::infinity()), 0u);
+    ASSERT_EQ(fxp_quantize(&format, std::numeric_limits<double>::quiet_NaN()), 0u);
+
+    ASSERT_EQ(fxp_dequantize(&format, 0), -40.0);
+    ASSERT_EQ(fxp_dequantize(&format, 81), 0.5);
+    ASSERT_EQ(fxp_dequantize(&format, 200), 60.0);
+    ASSERT_EQ(fxp_dequantize(&format, 81 | (uint64_t)1 << 40), 0.5);
+}
+
+TEST_F(FixedPointTest, QuantizeDequantize_Longitudes_WithinHalfStep) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -180.0, 180.0, 0.00001), 1);
+
+    for (double value : longitudes(20000)) {
+        uint64_t code = fxp_quantize(&format, value);
+        ASSERT_LE(code, format.max_code);
+        ASSERT_NEAR(fxp_dequantize(&format, code), value, 0.5e-5 + 1e-12) << value;
+    }
+}
+
+TEST_F(FixedPointTest, QuantizeArray_AllKernels_SameAsQuantize) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -180.0, 180.0, 0.00001), 1);
+    std::vector<double> values = longitudes(2003);
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(-std::numeric_limits<double>::infinity());
+    values.push_back(181.0);
+    values.push_back(-0.0);
+    values.push_back(-180.000004);
+    std::vector<uint64_t> codes(values.size());
+    std::vector<double> restored(values.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        fxp_quantize_array(&format, values.data(), codes.data(), values.size());
+        fxp_dequantize_array(&format, codes.data(), restored.data(), codes.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(codes[i], fxp_quantize(&format, values[i])) << pbb_get_kernel_name() << " value " << values[i];
+            ASSERT_DOUBLE_EQ(restored[i], fxp_dequantize(&format, codes[i])) << pbb_get_kernel_name() << " code " << codes[i];
+        }
+    }
+}
+
+TEST_F(FixedPointTest, WriteDoubleFixed_Temperatures_BitsPerValueAndSameValues) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -40.0, 60.0, 0.01), 1);
+    pbb = pbb_create(8);
+    std::vector<double> values = {36.6, -12.25, 0.0, 59.99, -40.0};
+
+    for (double value : values) pbb_write_double_fixed(pbb, &format, value);
+    ASSERT_EQ(pbb->write_pos, 14 * values.size());
+
+    for (double value : values) {
+        ASSERT_NEAR(pbb_read_double_fixed(pbb, &format), value, 0.005 + 1e-12);
+    }
+    ASSERT_EQ(pbb_read_double_fixed(pbb, &format), 0.0);
+}
+
+TEST_F(FixedPointTest, WriteDoubleArrayFixed_Segmented_SameAsPerValue) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, -180.0, 180.0, 0.00001), 1);
+    pbb = pbb_create_segmented(32);
+    partial_byte_buffer* expected = pbb_create(1);
+    std::vector<double> values = longitudes(1777);
+
+    pbb_write_byte(pbb, 0x5, 3);
+    pbb_write_byte(expected, 0x5, 3);
+    ASSERT_EQ(pbb_write_double_array_fixed(pbb, &format, values.data(), values.size()), values.size());
+    for (double value : values) pbb_write_double_fixed(expected, &format, value);
+    ASSERT_EQ(pbb->write_pos, expected->write_pos);
+
+    pbb_read_byte(pbb, 3);
+    pbb_read_byte(expected, 3);
+    std::vector<double> read(values.size() + 4);
+    ASSERT_EQ(pbb_read_double_array_fixed(pbb, &format, read.data(), read.size()), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_DOUBLE_EQ(read[i], pbb_read_double_fixed(expected, &format)) << "value " << i;
+        ASSERT_NEAR(read[i], values[i], 0.5e-5 + 1e-12);
+    }
+    pbb_destroy(&expected);
+}
+
+TEST_F(FixedPointTest, FixedFunctions_Null_NothingDone) {
+    fxp_format format;
+    ASSERT_EQ(fxp_format_init(&format, 0.0, 1.0, 0.1), 1);
+    double values[1] = {0.5};
+    uint64_t codes[1] = {7};
+
+    fxp_quantize_array(nullptr, values, codes, 1);
+    fxp_dequantize_array(&format, codes, nullptr, 1);
+    ASSERT_EQ(codes[0], 7u);
+    ASSERT_EQ(fxp_quantize(nullptr, 0.5), 0u);
+
+    pbb = pbb_create(4);
+    pbb_write_double_fixed(pbb, nullptr, 0.5);
+    ASSERT_EQ(pbb_write_double_array_fixed(pbb, &format, nullptr, 1), 0u);
+    ASSERT_EQ(pbb_read_double_array_fixed(pbb, nullptr, values, 1), 0u);
+    ASSERT_EQ(pbb->write_pos, 0);
+}
@@ -0,0 +1,111 @@
+#include "partial_byte_buffer.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class FloatResizerArrayTest : public ::testing::Test {
+    protected:
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        /**
+         * Doubles covering every exponent class: zeros, subnormals, normals of all magnitudes, infinities and NaN.
+         */
+        static std::vector<double> sampleDoubles(size_t count) {
+            std::vector<double> values = {
+                0.0, -0.0, 1.0, -1.0, 3.141592653589793, -12345.6789, 0.123456789,
+                std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::min(),
+                std::numeric_limits<double>::max(), -std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::quiet_NaN(), 1e-300, -1e300
+            };
+            srand(16);
+            while (values.size() < count) {
+                double mantissa = (double)rand() / RAND_MAX - 0.5;
+                values.push_back(std::ldexp(mantissa, rand() % 80 - 40));
+            }
+            return values;
+        }
+};
+
+TEST_F(FloatResizerArrayTest, ResizeDoubleArray_AllKernels_SameAsResizeFloatDouble) {
+    const int formats[][2] = {{6, 25}, {5, 10}, {8, 7}, {11, 52}, {3, 60}, {2, 3}};
+    std::vector<double> values = sampleDoubles(1003);
+    std::vector<uint64_t> resized(values.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        for (const int* format : formats) {
+            flr_resize_double_array(values.data(), resized.data(), values.size(), 11, 52, format[0], format[1]);
+            for (size_t i = 0; i < values.size(); ++i) {
+                ASSERT_EQ(resized[i], flr_resize_float_double(values[i], 11, 52, format[0], format[1]))
+                    << pbb_get_kernel_name() << " format " << format[0] << "+" << format[1] << " value " << i;
+            }
+        }
+    }
+}
+
+TEST_F(FloatResizerArrayTest, ResizeLongArray_ExpandBackInPlace_SameAsResizeFloatLong) {
+    std::vector<double> values = sampleDoubles(517);
+    std::vector<uint64_t> resized(values.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        flr_resize_double_array(values.data(), resized.data(), values.size(), 11, 52, 6, 25);
+        std::vector<uint64_t> expected(resized.size());
+        for (size_t i = 0; i < resized.size(); ++i) {
+            expected[i] = flr_resize_float_long(resized[i], 6, 25, 11, 52);
+        }
+
+        flr_resize_long_array(resized.data(), resized.data(), resized.size(), 6, 25, 11, 52);
+        ASSERT_EQ(resized, expected) << pbb_get_kernel_name();
+    }
+}
+
+TEST_F(FloatResizerArrayTest, ResizeLongArray_NoExponentBits_SameAsResizeFloatLong) {
+    std::vector<uint64_t> values(37);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = (i * 0x9E3779B97F4A7C15) >> 40;
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        std::vector<uint64_t> widened(values.size());
+        std::vector<uint64_t> narrowed(values.size());
+        flr_resize_long_array(values.data(), widened.data(), values.size(), 0, 20, 8, 23);
+        flr_resize_long_array(values.data(), narrowed.data(), values.size(), 0, 20, 0, 12);
+        for (size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(widened[i], flr_resize_float_long(values[i], 0, 20, 8, 23)) << pbb_get_kernel_name();
+            ASSERT_EQ(narrowed[i], flr_resize_float_long(values[i], 0, 20, 0, 12)) << pbb_get_kernel_name();
+        }
+    }
+}
+
+TEST_F(FloatResizerArrayTest, ResizeDoubleArray_NullArrays_NothingWritten) {
+    uint64_t resized[2] = {7, 7};
+    double values[2] = {1.0, 2.0};
+
+    flr_resize_double_array(nullptr, resized, 2, 11, 52, 6, 25);
+    flr_resize_double_array(values, nullptr, 2, 11, 52, 6, 25);
+    flr_resize_double_array(values, resized, 0, 11, 52, 6, 25);
+
+    ASSERT_EQ(resized[0], 7);
+    ASSERT_EQ(resized[1], 7);
+}
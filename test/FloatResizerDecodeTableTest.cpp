@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class FloatResizerDecodeTableTest : public ::testing::Test {
+    protected:
+        flr_decode_table *table = nullptr;
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            flr_decode_table_destroy(&table);
+            pbb_destroy(&pbb);
+        }
+
+        static uint64_t bitsOf(double value) {
+            qword q;
+            q.double_val = value;
+            return q.uint64_val;
+        }
+
+        /**
+         * Random codes of [bits] bits, followed by every special exponent of the 5+10 format.
+         */
+        static std::vector<uint64_t> codes(size_t count, int bits) {
+            std::vector<uint64_t> values = {0x0000, 0x8000, 0x7C00, 0xFC00, 0x7E00, 0x0001, 0x83FF};
+            for (uint64_t& value : values) value &= ((uint64_t)1 << bits) - 1;
+            srand(19);
+            while (values.size() < count) {
+                values.push_back((uint64_t)rand() & (((uint64_t)1 << bits) - 1));
+            }
+            return values;
+        }
+};
+
+TEST_F(FloatResizerDecodeTableTest, Create_TooWideOrInvalidFormat_ReturnsNull) {
+    ASSERT_EQ(flr_decode_table_create(5, 11), nullptr);
+    ASSERT_EQ(flr_decode_table_create(8, 23), nullptr);
+    ASSERT_EQ(flr_decode_table_create(-1, 4), nullptr);
+
+    table = flr_decode_table_create(8, 7);
+    ASSERT_NE(table, nullptr);
+}
+
+TEST_F(FloatResizerDecodeTableTest, Decode_EveryCode_SameBitsAsResizeFloatLong) {
+    const int formats[][2] = {{5, 10}, {8, 7}, {4, 3}, {0, 6}, {3, 0}};
+
+    for (const int* format : formats) {
+        table = flr_decode_table_create(format[0], format[1]);
+        ASSERT_NE(table, nullptr);
+
+        uint64_t size = (uint64_t)1 << (1 + format[0] + format[1]);
+        for (uint64_t code = 0; code < size; ++code) {
+            ASSERT_EQ(bitsOf(flr_decode(table, code)), flr_resize_float_long(code, format[0], format[1], 11, 52))
+                << "format " << format[0] << "+" << format[1] << " code " << code;
+        }
+        ASSERT_EQ(bitsOf(flr_decode(table, size | 1)), bitsOf(flr_decode(table, 1)));
+        flr_decode_table_destroy(&table);
+    }
+}
+
+TEST_F(FloatResizerDecodeTableTest, DecodeArray_RandomCodes_SameAsDecode) {
+    table = flr_decode_table_create(5, 10);
+    std::vector<uint64_t> src = codes(1000, 16);
+    std::vector<double> dst(src.size());
+
+    flr_decode_array(table, src.data(), dst.data(), src.size());
+    for (size_t i = 0; i < src.size(); ++i) {
+        ASSERT_EQ(bitsOf(dst[i]), bitsOf(flr_decode(table, src[i]))) << "code " << i;
+    }
+}
+
+TEST_F(FloatResizerDecodeTableTest, ReadDoubleArrayTable_SignedCodes_SameAsReadDoubleArrayAs) {
+    table = flr_decode_table_create(5, 10);
+    pbb = pbb_create(1);
+    std::vector<uint64_t> src = codes(1301, 16);
+
+    pbb_write_byte(pbb, 0x3, 3);
+    pbb_write_int64_array(pbb, (const int64_t*)src.data(), src.size(), 16);
+
+    std::vector<double> expected(src.size());
+    pbb_read_byte(pbb, 3);
+    ASSERT_EQ(pbb_read_double_array_as(pbb, expected.data(), expected.size(), 5, 10), src.size());
+
+    pbb->read_pos = 3;
+    std::vector<double> read(src.size() + 5);
+    ASSERT_EQ(pbb_read_double_array_table(pbb, table, read.data(), read.size()), src.size());
+    for (size_t i = 0; i < src.size(); ++i) {
+        ASSERT_EQ(bitsOf(read[i]), bitsOf(expected[i])) << "value " << i;
+    }
+}
+
+TEST_F(FloatResizerDecodeTableTest, ReadDoubleArrayTable_Segmented_SameAsWrittenValues) {
+    table = flr_decode_table_create(4, 7);
+    pbb = pbb_create_segmented(16);
+    std::vector<double> values = {36.6, -4.25, 120.0, 0.0, 1.5};
+    for (int i = 0; i < 300; ++i) values.push_back((rand() % 2000 - 1000) / 10.0);
+
+    ASSERT_EQ(pbb_write_double_array_as(pbb, values.data(), values.size(), 4, 7), values.size());
+
+    std::vector<double> read(values.size());
+    ASSERT_EQ(pbb_read_double_array_table(pbb, table, read.data(), read.size()), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint64_t resized = flr_resize_float_double(values[i], 11, 52, 4, 7);
+        ASSERT_EQ(bitsOf(read[i]), flr_resize_float_long(resized, 4, 7, 11, 52)) << "value " << i;
+    }
+}
+
+TEST_F(FloatResizerDecodeTableTest, DecodeTable_Null_NothingDone) {
+    double dst[1] = {7.0};
+    uint64_t src[1] = {1};
+
+    ASSERT_EQ(flr_decode(nullptr, 1), 0.0);
+    flr_decode_array(nullptr, src, dst, 1);
+    ASSERT_EQ(dst[0], 7.0);
+
+    pbb = pbb_create(4);
+    ASSERT_EQ(pbb_read_double_array_table(pbb, nullptr, dst, 1), 0);
+    flr_decode_table_destroy(&table);
+    ASSERT_EQ(table, nullptr);
+}
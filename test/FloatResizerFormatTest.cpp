@@ -0,0 +1,76 @@
+#include "partial_byte_buffer.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+class FloatResizerFormatTest : public ::testing::Test {
+    protected:
+        flr_format format;
+};
+
+// Formats known at compile time are resized at compile time
+static_assert(flr_static_format<11, 52, 5, 10>::resize(0x3FF0000000000000) == 0x3C00, "1.0 as binary16");
+static_assert(flr_static_format<11, 52, 8, 7>::resize(0xC000000000000000) == 0xC000, "-2.0 as bfloat16");
+static_assert(flr_static_format<5, 10, 11, 52>::resize(0x7C00) == 0x7FF0000000000000, "infinity back to double");
+
+TEST_F(FloatResizerFormatTest, FormatInit_InvalidFormats_Rejected) {
+    ASSERT_EQ(flr_format_init(&format, 11, 52, 6, 25), 1);
+    ASSERT_EQ(flr_format_init(&format, -1, 52, 6, 25), 0);
+    ASSERT_EQ(flr_format_init(&format, 11, 53, 6, 25), 0);
+    ASSERT_EQ(flr_format_init(&format, 11, 52, 6, -25), 0);
+    ASSERT_EQ(flr_format_init(&format, 11, 52, 32, 32), 0);
+}
+
+TEST_F(FloatResizerFormatTest, Resize_ManyFormats_SameAsResizeFloatLong) {
+    const int formats[][2] = {{11, 52}, {8, 23}, {6, 25}, {5, 10}, {4, 31}, {7, 20}, {0, 20}, {3, 0}, {1, 62}};
+    srand(17);
+
+    for (const int* src : formats) {
+        for (const int* dst : formats) {
+            ASSERT_EQ(flr_format_init(&format, src[0], src[1], dst[0], dst[1]), 1);
+            for (int i = 0; i < 200; ++i) {
+                uint64_t value = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+                value &= i < 100 ? ~(uint64_t)0 >> (63 - src[0] - src[1]) : ~(uint64_t)0;
+                ASSERT_EQ(flr_resize(&format, value), flr_resize_float_long(value, src[0], src[1], dst[0], dst[1]))
+                    << src[0] << "+" << src[1] << " to " << dst[0] << "+" << dst[1] << " value " << value;
+            }
+        }
+    }
+}
+
+TEST_F(FloatResizerFormatTest, ResizeDouble_Longitudes_SameAsResizeFloatDouble) {
+    flr_format_init(&format, 11, 52, 6, 25);
+
+    for (double longitude = -180.0; longitude <= 180.0; longitude += 0.731) {
+        ASSERT_EQ(flr_resize_double(&format, longitude), flr_resize_float_double(longitude, 11, 52, 6, 25));
+    }
+    ASSERT_EQ(flr_resize_double(&format, -0.0), (uint64_t)1 << 31);
+}
+
+TEST_F(FloatResizerFormatTest, ResizeArray_RoundTrip_SameAsStaticFormat) {
+    std::vector<double> values = {0.0, 1.5, -3.25, 1e-9, 6.02e23, std::numeric_limits<double>::infinity()};
+    for (int i = 0; i < 100; ++i) values.push_back(std::sin(i) * 100);
+    std::vector<uint64_t> packed(values.size());
+    std::vector<uint64_t> restored(values.size());
+
+    flr_format narrow, widen;
+    flr_format_init(&narrow, 11, 52, 8, 23);
+    flr_format_init(&widen, 8, 23, 11, 52);
+    flr_resize_array_double(&narrow, values.data(), packed.data(), values.size());
+    flr_resize_array(&widen, packed.data(), restored.data(), packed.size());
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        qword wq;
+        wq.double_val = values[i];
+        ASSERT_EQ(packed[i], (flr_static_format<11, 52, 8, 23>::resize(wq.uint64_val))) << "value " << i;
+        ASSERT_EQ(restored[i], (flr_static_format<8, 23, 11, 52>::resize(packed[i]))) << "value " << i;
+    }
+
+    // binary32 keeps values that are exact in it
+    qword wq;
+    wq.uint64_val = restored[2];
+    ASSERT_EQ(wq.double_val, -3.25);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+class FloatResizerHalfTest : public ::testing::Test {
+    protected:
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        static uint32_t bitsOf(float value) {
+            qword q;
+            q.float_val = value;
+            return q.uint32_val;
+        }
+
+        static float floatOf(uint32_t bits) {
+            qword q;
+            q.uint32_val = bits;
+            return q.float_val;
+        }
+
+        /**
+         * Floats around every rounding boundary of both formats, and random bit patterns of all classes.
+         */
+        static std::vector<float> sampleFloats(size_t count) {
+            std::vector<uint32_t> bits = {
+                0x00000000, 0x80000000, 0x3F800000, 0x477FE000, 0x477FEFFF, 0x477FF000, 0x477FF001,
+                0x38800000, 0x387FFFFF, 0x33000000, 0x33000001, 0x33400000, 0x33C00000, 0x35000000,
+                0x00000001, 0x807FFFFF, 0x7F800000, 0xFF800000, 0x7FC00000, 0x7F800001, 0xFFBFE000,
+                0x3F808000, 0x3F818000, 0x3F807FFF, 0x7F7FFFFF, 0x00800000, 0x3F801000, 0x3F803000
+            };
+            std::vector<float> values;
+            for (uint32_t value : bits) values.push_back(floatOf(value));
+            srand(20);
+            while (values.size() < count) {
+                values.push_back(floatOf(((uint32_t)rand() << 16) ^ (uint32_t)rand()));
+            }
+            return values;
+        }
+};
+
+TEST_F(FloatResizerHalfTest, FloatToHalf_KnownValues_RoundedToNearestEven) {
+    ASSERT_EQ(flr_float_to_half(1.0f), 0x3C00);
+    ASSERT_EQ(flr_float_to_half(-2.0f), 0xC000);
+    ASSERT_EQ(flr_float_to_half(65504.0f), 0x7BFF);
+    ASSERT_EQ(flr_float_to_half(65519.0f), 0x7BFF);
+    ASSERT_EQ(flr_float_to_half(65520.0f), 0x7C00);
+    ASSERT_EQ(flr_float_to_half(1e10f), 0x7C00);
+    ASSERT_EQ(flr_float_to_half(std::ldexp(1.0f, -24)), 0x0001);
+    ASSERT_EQ(flr_float_to_half(std::ldexp(1.0f, -25)), 0x0000);
+    ASSERT_EQ(flr_float_to_half(std::ldexp(3.0f, -26)), 0x0001);
+    ASSERT_EQ(flr_float_to_half(floatOf(0x3F801000)), 0x3C00);
+    ASSERT_EQ(flr_float_to_half(floatOf(0x3F803000)), 0x3C02);
+    ASSERT_EQ(flr_float_to_half(floatOf(0x7F800001)), 0x7E00);
+}
+
+TEST_F(FloatResizerHalfTest, HalfToFloat_EveryCode_ExactValueAndRoundTrip) {
+    for (uint32_t code = 0; code < 0x10000; ++code) {
+        float value = flr_half_to_float((uint16_t)code);
+        uint32_t exponent = (code >> 10) & 0x1F;
+        uint32_t mant = code & 0x3FF;
+        float sign = (code & 0x8000) ? -1.0f : 1.0f;
+
+        if (exponent == 0x1F) {
+            ASSERT_TRUE(mant != 0 ? std::isnan(value) : std::isinf(value)) << "code " << code;
+            if (mant != 0) continue;
+        } else if (exponent == 0) {
+            ASSERT_EQ(value, sign * std::ldexp((float)mant, -24)) << "code " << code;
+        } else {
+            ASSERT_EQ(value, sign * std::ldexp((float)(mant | 0x400), (int)exponent - 25)) << "code " << code;
+        }
+        ASSERT_EQ(flr_float_to_half(value), code) << "code " << code;
+    }
+}
+
+TEST_F(FloatResizerHalfTest, FloatToBfloat16_KnownValues_RoundedToNearestEven) {
+    ASSERT_EQ(flr_float_to_bfloat16(1.0f), 0x3F80);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x3F808000)), 0x3F80);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x3F818000)), 0x3F82);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x3F808001)), 0x3F81);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x7F7FFFFF)), 0x7F80);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x807FFFFF)), 0x8000);
+    ASSERT_EQ(flr_float_to_bfloat16(floatOf(0x7F800001)), 0x7FC0);
+    ASSERT_EQ(flr_float_to_bfloat16(-std::numeric_limits<float>::infinity()), 0xFF80);
+
+    for (uint32_t code = 0; code < 0x10000; ++code) {
+        ASSERT_EQ(bitsOf(flr_bfloat16_to_float((uint16_t)code)), code << 16);
+    }
+}
+
+TEST_F(FloatResizerHalfTest, FloatToHalfArray_AllKernels_SameAsSoftware) {
+    std::vector<float> values = sampleFloats(100003);
+    std::vector<uint16_t> half(values.size());
+    std::vector<uint16_t> bfloat(values.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        flr_float_to_half_array(values.data(), half.data(), values.size());
+        flr_float_to_bfloat16_array(values.data(), bfloat.data(), values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(half[i], flr_float_to_half(values[i]))
+                << pbb_get_kernel_name() << " float 0x" << std::hex << bitsOf(values[i]);
+            ASSERT_EQ(bfloat[i], flr_float_to_bfloat16(values[i]))
+                << pbb_get_kernel_name() << " float 0x" << std::hex << bitsOf(values[i]);
+        }
+    }
+}
+
+TEST_F(FloatResizerHalfTest, HalfToFloatArray_AllKernels_SameAsSoftware) {
+    std::vector<uint16_t> codes(0x10000 + 5);
+    for (size_t i = 0; i < codes.size(); ++i) codes[i] = (uint16_t)(i * 40503);
+    std::vector<float> half(codes.size());
+    std::vector<float> bfloat(codes.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        flr_half_to_float_array(codes.data(), half.data(), codes.size());
+        flr_bfloat16_to_float_array(codes.data(), bfloat.data(), codes.size());
+        for (size_t i = 0; i < codes.size(); ++i) {
+            ASSERT_EQ(bitsOf(half[i]), bitsOf(flr_half_to_float(codes[i]))) << pbb_get_kernel_name() << " code " << codes[i];
+            ASSERT_EQ(bitsOf(bfloat[i]), bitsOf(flr_bfloat16_to_float(codes[i]))) << pbb_get_kernel_name() << " code " << codes[i];
+        }
+    }
+}
+
+TEST_F(FloatResizerHalfTest, HalfArrays_NullArrays_NothingWritten) {
+    float values[2] = {1.0f, 2.0f};
+    uint16_t codes[2] = {7, 7};
+
+    flr_float_to_half_array(nullptr, codes, 2);
+    flr_float_to_bfloat16_array(values, nullptr, 2);
+    flr_half_to_float_array(nullptr, values, 2);
+    flr_bfloat16_to_float_array(codes, nullptr, 2);
+
+    ASSERT_EQ(codes[0], 7);
+    ASSERT_EQ(values[1], 2.0f);
+}
@@ -0,0 +1,294 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class FloatResizerRoundingTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+            pbb_destroy(&pbb);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        static uint64_t bitsOf(double value) {
+            qword q;
+            q.double_val = value;
+            return q.uint64_val;
+        }
+
+        static double doubleOf(uint64_t bits) {
+            qword q;
+            q.uint64_val = bits;
+            return q.double_val;
+        }
+
+        static uint32_t floatBitsOf(float value) {
+            qword q;
+            q.float_val = value;
+            return q.uint32_val;
+        }
+
+        static double expand(uint64_t bits, int exp_bits, int mant_bits) {
+            return doubleOf(flr_resize_float_long(bits, exp_bits, mant_bits, 11, 52));
+        }
+
+        /**
+         * Doubles within the normal range of floats, with ties and carries of the 8+23 format among them.
+         */
+        static std::vector<double> floatRangeDoubles(size_t count) {
+            std::vector<uint64_t> bits = {
+                0x3FF0000010000000, 0x3FF0000030000000, 0x3FF0000010000001, 0x3FEFFFFFFFFFFFFF,
+                0x3FFFFFFFF0000000, 0xBFFFFFFFEFFFFFFF, 0x47EFFFFFE0000000, 0x47EFFFFFEFFFFFFF,
+                0x3810000000000000, 0xB80FFFFFFFFFFFFF
+            };
+            std::vector<double> values;
+            for (uint64_t value : bits) values.push_back(doubleOf(value));
+            srand(23);
+            while (values.size() < count) {
+                uint64_t mant = (((uint64_t)rand() << 31) ^ (uint64_t)rand()) & 0xFFFFFFFFFFFFF;
+                uint64_t exponent = 1023 - 126 + (uint64_t)(rand() % 254);
+                values.push_back(doubleOf((uint64_t)(rand() & 1) << 63 | exponent << 52 | mant));
+            }
+            return values;
+        }
+
+        /**
+         * Longitudes with 5 decimal places, including both limits.
+         */
+        static std::vector<double> longitudes(size_t count) {
+            std::vector<double> values = {180.0, -180.0, 0.00001, 0.0};
+            srand(2023);
+            while (values.size() < count) {
+                values.push_back(std::round(((double)rand() / RAND_MAX * 360 - 180) * 1e5) / 1e5);
+            }
+            return values;
+        }
+};
+
+TEST_F(FloatResizerRoundingTest, ResizeFloatDoubleNearest_FloatRange_SameAsFloatConversion) {
+    for (double value : floatRangeDoubles(20000)) {
+        ASSERT_EQ(flr_resize_float_double_nearest(value, 11, 52, 8, 23), floatBitsOf((float)value))
+            << "double 0x" << std::hex << bitsOf(value);
+    }
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeFloatLongNearest_Carry_NextExponent) {
+    // 1.1111 rounds up to 10.000
+    ASSERT_EQ(flr_resize_float_long_nearest(0x3FFF800000000000, 11, 52, 5, 4), 0x100u);
+    // A tie keeps an even mantissa, or rounds an odd one up
+    ASSERT_EQ(flr_resize_float_long_nearest(0x3FF0800000000000, 11, 52, 5, 4), 0xF0u);
+    ASSERT_EQ(flr_resize_float_long_nearest(0x3FF1800000000000, 11, 52, 5, 4), 0xF2u);
+    // The largest finite values round up to infinity
+    ASSERT_EQ(flr_resize_float_double_nearest(65520.0, 11, 52, 5, 10), 0x7C00u);
+    ASSERT_EQ(flr_resize_float_double_nearest(65519.0, 11, 52, 5, 10), 0x7BFFu);
+    // The same values truncated
+    ASSERT_EQ(flr_resize_float_long(0x3FFF800000000000, 11, 52, 5, 4), 0xFFu);
+    ASSERT_EQ(flr_resize_float_double(65520.0, 11, 52, 5, 10), 0x7BFFu);
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeFloatLongNearest_SpecialsAndFullCodes_NotRounded) {
+    const uint64_t specials[] = {
+        0x7FF0000000000000, 0xFFF0000000000000, 0x7FF8000000000000, 0x7FFFFFFFFFFFFFFF, 0x7FF0000000000001
+    };
+    for (uint64_t value : specials) {
+        ASSERT_EQ(flr_resize_float_long_nearest(value, 11, 52, 5, 10), flr_resize_float_long(value, 11, 52, 5, 10));
+    }
+
+    // Without exponent bits there is nothing to carry into, so 1.1111 stays 1.111
+    ASSERT_EQ(flr_resize_float_long_nearest(0x3FFF800000000000, 11, 52, 0, 3), 0x7u);
+    ASSERT_EQ(flr_resize_float_long_nearest(0x3FF7000000000000, 11, 52, 0, 3), 0x4u);
+
+    // Widening mantissas are not rounded
+    ASSERT_EQ(flr_resize_float_long_nearest(0x7BFF, 5, 10, 11, 52), flr_resize_float_long(0x7BFF, 5, 10, 11, 52));
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeNearest_ZerosAndSubnormals_AllKernelsNotRounded) {
+    // The largest subnormal has an all-ones mantissa, which must not carry into exponent 1
+    const uint64_t values[] = {
+        0x000FFFFFFFFFFFFF, 0x800FFFFFFFFFFFFF, 0x0000000000000000, 0x8000000000000000,
+        0x0000000000000001, 0x0008000000000000, 0x000FFFFFFF800000, 0x0007FFFFFFFFFFFF
+    };
+    flr_format format = {};
+    ASSERT_EQ(flr_format_init(&format, 11, 52, 6, 24), 1);
+    flr_format_set_rounding(&format, FLR_ROUND_NEAREST_EVEN);
+
+    ASSERT_LT(std::fabs(expand(flr_resize_float_long_nearest(0x000FFFFFFFFFFFFF, 11, 52, 6, 24), 6, 24)), 1e-300);
+
+    // Enough copies for the vector loops of every kernel, and a scalar tail
+    std::vector<uint64_t> src;
+    for (int i = 0; i < 3; ++i) src.insert(src.end(), values, values + 8);
+    src.push_back(values[0]);
+    std::vector<uint64_t> dst(src.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        flr_resize_array(&format, src.data(), dst.data(), src.size());
+        for (size_t i = 0; i < src.size(); ++i) {
+            uint64_t truncated = flr_resize_float_long(src[i], 11, 52, 6, 24);
+            ASSERT_EQ(flr_resize(&format, src[i]), truncated) << "value " << i;
+            ASSERT_EQ(dst[i], truncated) << pbb_get_kernel_name() << " value " << i;
+        }
+    }
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeFloatDoubleNearest_RandomValues_HalfTheTruncationError) {
+    std::vector<double> values = longitudes(10000);
+    double max_truncated = 0.0;
+    double max_rounded = 0.0;
+
+    for (double value : values) {
+        double truncated = expand(flr_resize_float_double(value, 11, 52, 6, 20), 6, 20);
+        double rounded = expand(flr_resize_float_double_nearest(value, 11, 52, 6, 20), 6, 20);
+        double ulp = std::ldexp(1.0, std::ilogb(value == 0.0 ? 1.0 : value) - 20);
+        ASSERT_LE(std::fabs(rounded - value), ulp / 2) << value;
+        ASSERT_LE(std::fabs(rounded - value), std::fabs(truncated - value)) << value;
+        max_truncated = std::fmax(max_truncated, std::fabs(truncated - value));
+        max_rounded = std::fmax(max_rounded, std::fabs(rounded - value));
+    }
+    ASSERT_LE(max_rounded, max_truncated / 2 + 1e-12);
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeArrayNearest_AllKernels_SameAsResize) {
+    const int formats[][4] = {{11, 52, 5, 10}, {11, 52, 8, 23}, {11, 52, 0, 7}, {11, 52, 6, 1}, {8, 23, 4, 3}, {0, 9, 3, 2}};
+    std::vector<double> doubles = floatRangeDoubles(2003);
+    doubles.push_back(std::numeric_limits<double>::infinity());
+    doubles.push_back(-std::numeric_limits<double>::quiet_NaN());
+    doubles.push_back(65520.0);
+    doubles.push_back(std::numeric_limits<double>::denorm_min());
+    std::vector<uint64_t> src(doubles.size());
+    for (size_t i = 0; i < src.size(); ++i) src[i] = bitsOf(doubles[i]);
+    std::vector<uint64_t> dst(src.size());
+
+    for (const int* f : formats) {
+        flr_format format = {};
+        ASSERT_EQ(flr_format_init(&format, f[0], f[1], f[2], f[3]), 1);
+        flr_format_set_rounding(&format, FLR_ROUND_NEAREST_EVEN);
+        uint64_t src_mask = (uint64_t)-1 >> (63 - f[0] - f[1]);
+
+        for (pbb_kernel kernel : supportedKernels()) {
+            pbb_set_kernel(kernel);
+            std::vector<uint64_t> masked(src.size());
+            for (size_t i = 0; i < src.size(); ++i) masked[i] = src[i] & src_mask;
+            flr_resize_array(&format, masked.data(), dst.data(), masked.size());
+            for (size_t i = 0; i < src.size(); ++i) {
+                ASSERT_EQ(dst[i], flr_resize(&format, masked[i]))
+                    << pbb_get_kernel_name() << " format " << f[2] << "+" << f[3] << " value " << i;
+                ASSERT_EQ(dst[i], flr_resize_float_long_nearest(masked[i], f[0], f[1], f[2], f[3]));
+            }
+        }
+    }
+}
+
+TEST_F(FloatResizerRoundingTest, ResizeDoubleArrayNearest_Longitudes_SameAsScalar) {
+    std::vector<double> values = longitudes(1001);
+    std::vector<uint64_t> resized(values.size());
+
+    flr_resize_double_array_nearest(values.data(), resized.data(), values.size(), 11, 52, 6, 24);
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(resized[i], flr_resize_float_double_nearest(values[i], 11, 52, 6, 24)) << "value " << i;
+    }
+
+    std::vector<uint64_t> src(values.size());
+    for (size_t i = 0; i < values.size(); ++i) src[i] = bitsOf(values[i]);
+    flr_resize_long_array_nearest(src.data(), src.data(), src.size(), 11, 52, 6, 24);
+    ASSERT_EQ(src, resized);
+}
+
+TEST_F(FloatResizerRoundingTest, SelectFormatNearest_Coordinates_OneMantissaBitLess) {
+    flr_format_spec truncated;
+    flr_format_spec rounded;
+    std::vector<double> values = longitudes(5000);
+
+    ASSERT_EQ(flr_select_format_decimals(values.data(), values.size(), 5, 0, &truncated), 1);
+    ASSERT_EQ(flr_select_format_decimals_nearest(values.data(), values.size(), 5, 0, &rounded), 1);
+    ASSERT_EQ(rounded.exp_bits, truncated.exp_bits);
+    ASSERT_EQ(rounded.mant_bits, 24);
+    ASSERT_EQ(rounded.mant_bits + 1, truncated.mant_bits);
+
+    for (double value : values) {
+        double restored = expand(flr_resize_float_double_nearest(value, 11, 52, rounded.exp_bits, rounded.mant_bits), rounded.exp_bits, rounded.mant_bits);
+        ASSERT_LT(std::fabs(restored - value), 0.5e-5) << value;
+    }
+}
+
+TEST_F(FloatResizerRoundingTest, SelectFormatNearest_LargestValuesCarry_ExponentRangeKept) {
+    // 3.96875 rounds up to 4, which needs one more exponent than 3.96875
+    double values[2] = {3.96875, 1.0};
+    flr_format_spec spec;
+
+    ASSERT_EQ(flr_select_format_nearest(values, 2, 0.2, 0, &spec), 1);
+    for (double value : values) {
+        uint64_t bits = flr_resize_float_double_nearest(value, 11, 52, spec.exp_bits, spec.mant_bits);
+        double restored = expand(bits, spec.exp_bits, spec.mant_bits);
+        ASSERT_TRUE(std::isfinite(restored)) << "format " << (int)spec.exp_bits << "+" << (int)spec.mant_bits;
+        ASSERT_LT(std::fabs(restored - value), 0.2);
+    }
+}
+
+TEST_F(FloatResizerRoundingTest, WriteDoubleNearestAs_Longitudes_ReadBackWithinHalfStep) {
+    pbb = pbb_create(8);
+    std::vector<double> values = longitudes(2000);
+
+    for (double value : values) pbb_write_double_nearest_as(pbb, value, 6, 24);
+    ASSERT_EQ(pbb->write_pos, 31 * values.size());
+    ASSERT_EQ(pbb_write_double_array_nearest_as(pbb, values.data(), values.size(), 6, 24), values.size());
+
+    std::vector<double> read(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        read[i] = pbb_read_double_as(pbb, 6, 24);
+        ASSERT_LT(std::fabs(read[i] - values[i]), 0.5e-5) << values[i];
+    }
+    std::vector<double> array(values.size());
+    ASSERT_EQ(pbb_read_double_array_as(pbb, array.data(), array.size(), 6, 24), values.size());
+    ASSERT_EQ(memcmp(array.data(), read.data(), read.size() * sizeof(double)), 0);
+}
+
+TEST_F(FloatResizerRoundingTest, WriteUnsignedDoubleNearestAs_Segmented_SameAsPerValue) {
+    pbb = pbb_create_segmented(16);
+    partial_byte_buffer* expected = pbb_create(1);
+    std::vector<double> values = longitudes(555);
+    for (double& value : values) value = std::fabs(value);
+
+    ASSERT_EQ(pbb_write_unsigned_double_array_nearest_as(pbb, values.data(), values.size(), 6, 24), values.size());
+    for (double value : values) pbb_write_unsigned_double_nearest_as(expected, value, 6, 24);
+    ASSERT_EQ(pbb->write_pos, 30 * values.size());
+
+    for (double value : values) {
+        double read = pbb_read_unsigned_double_as(pbb, 6, 24);
+        ASSERT_EQ(read, pbb_read_unsigned_double_as(expected, 6, 24));
+        ASSERT_LT(std::fabs(read - value), 0.5e-5) << value;
+    }
+    pbb_destroy(&expected);
+}
+
+TEST_F(FloatResizerRoundingTest, StaticFormat_NearestEven_SameAsDescriptor) {
+    typedef flr_static_format<11, 52, 6, 24, FLR_ROUND_NEAREST_EVEN> nearest;
+    static_assert(nearest::format.round_bit == 1, "rounding is set at compile time");
+    static_assert(flr_static_format<11, 52, 6, 24>::format.round_bit == 0, "truncation by default");
+
+    for (double value : longitudes(500)) {
+        ASSERT_EQ(nearest::resize(bitsOf(value)), flr_resize_float_double_nearest(value, 11, 52, 6, 24));
+    }
+}
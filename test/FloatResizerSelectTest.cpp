@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+class FloatResizerSelectTest : public ::testing::Test {
+    protected:
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        /**
+         * Values with [decimals] decimal places within [-limit, limit], including both limits and the smallest step.
+         */
+        static std::vector<double> decimalValues(size_t count, double limit, int decimals) {
+            double scale = std::pow(10.0, decimals);
+            std::vector<double> values = {limit, -limit, 1 / scale, 0.0};
+            srand(21);
+            while (values.size() < count) {
+                values.push_back(std::round(((double)rand() / RAND_MAX * 2 - 1) * limit * scale) / scale);
+            }
+            return values;
+        }
+
+        /**
+         * The value expected back after a resize to [spec] and back to double.
+         */
+        static double restored(double value, const flr_format_spec& spec) {
+            qword q;
+            q.uint64_val = flr_resize_float_long(
+                flr_resize_float_double(value, 11, 52, spec.exp_bits, spec.mant_bits), spec.exp_bits, spec.mant_bits, 11, 52
+            );
+            return q.double_val;
+        }
+};
+
+TEST_F(FloatResizerSelectTest, SelectFormatDecimals_Coordinates_SameAsReadmeTable) {
+    flr_format_spec spec;
+    std::vector<double> longitudes = decimalValues(5000, 180.0, 5);
+    std::vector<double> latitudes = decimalValues(5000, 90.0, 5);
+
+    ASSERT_EQ(flr_select_format_decimals(longitudes.data(), longitudes.size(), 5, 0, &spec), 1);
+    ASSERT_EQ(spec.exp_bits, 6);
+    ASSERT_EQ(spec.mant_bits, 25);
+    ASSERT_EQ(spec.sign_bits, 1);
+
+    ASSERT_EQ(flr_select_format_decimals(latitudes.data(), latitudes.size(), 5, 1, &spec), 1);
+    ASSERT_EQ(spec.exp_bits, 6);
+    ASSERT_EQ(spec.mant_bits, 24);
+    ASSERT_EQ(spec.sign_bits, 1);
+}
+
+TEST_F(FloatResizerSelectTest, SelectFormat_RandomColumns_EveryValueWithinPrecisionAndNarrowest) {
+    srand(2021);
+    for (int column = 0; column < 50; ++column) {
+        std::vector<double> values(1 + rand() % 300);
+        int min_exponent = rand() % 60 - 40;
+        int range = rand() % 30;
+        for (double& value : values) {
+            value = std::ldexp(1.0 + (double)rand() / RAND_MAX, min_exponent + rand() % (range + 1));
+            if (rand() % 2) value = -value;
+        }
+        double precision = std::ldexp(1.0 + (double)rand() / RAND_MAX, min_exponent + range - rand() % 40);
+
+        flr_format_spec spec;
+        ASSERT_EQ(flr_select_format(values.data(), values.size(), precision, 0, &spec), 1);
+        double largest = 0.0;
+        for (double value : values) {
+            ASSERT_LT(std::fabs(restored(value, spec) - value), precision) << "column " << column << " value " << value;
+            largest = std::fmax(largest, std::fabs(value));
+        }
+
+        // One bit less: the exponent range or the precision is lost
+        int max_exponent = std::ilogb(largest);
+        ASSERT_TRUE(spec.mant_bits == 0 || std::ldexp(1.0, max_exponent - spec.mant_bits + 1) > precision);
+        int bias = (1 << (spec.exp_bits - 2)) - 1;
+        bool fits = true;
+        for (double value : values) fits &= std::ilogb(value) >= 1 - bias && std::ilogb(value) <= bias;
+        ASSERT_TRUE(spec.exp_bits == 1 || !fits) << "column " << column;
+    }
+}
+
+TEST_F(FloatResizerSelectTest, SelectFormat_AllowUnsigned_SignDroppedWithoutNegatives) {
+    std::vector<double> values = {36.6, 0.0, -0.0, 120.5, std::numeric_limits<double>::quiet_NaN(), 0.25};
+    flr_format_spec spec;
+
+    ASSERT_EQ(flr_select_format(values.data(), values.size(), 0.05, 1, &spec), 1);
+    ASSERT_EQ(spec.sign_bits, 0);
+    ASSERT_EQ(flr_select_format(values.data(), values.size(), 0.05, 0, &spec), 1);
+    ASSERT_EQ(spec.sign_bits, 1);
+
+    values.push_back(-0.5);
+    ASSERT_EQ(flr_select_format(values.data(), values.size(), 0.05, 1, &spec), 1);
+    ASSERT_EQ(spec.sign_bits, 1);
+}
+
+TEST_F(FloatResizerSelectTest, SelectFormat_AllKernels_SameFormat) {
+    std::vector<double> values = decimalValues(1000, 1000.0, 2);
+    values.push_back(std::ldexp(1.0, -30));
+    values.push_back(std::numeric_limits<double>::infinity());
+    values.push_back(std::numeric_limits<double>::denorm_min());
+
+    for (size_t extreme = values.size() - 3; extreme < values.size() + 1; ++extreme) {
+        std::vector<double> column(values.begin(), values.begin() + extreme);
+        flr_format_spec expected;
+        pbb_set_kernel(PBB_KERNEL_SCALAR);
+        ASSERT_EQ(flr_select_format_decimals(column.data(), column.size(), 2, 1, &expected), 1);
+
+        for (pbb_kernel kernel : supportedKernels()) {
+            pbb_set_kernel(kernel);
+            flr_format_spec spec;
+            ASSERT_EQ(flr_select_format_decimals(column.data(), column.size(), 2, 1, &spec), 1);
+            ASSERT_EQ(spec.exp_bits, expected.exp_bits) << pbb_get_kernel_name();
+            ASSERT_EQ(spec.mant_bits, expected.mant_bits) << pbb_get_kernel_name();
+            ASSERT_EQ(spec.sign_bits, expected.sign_bits) << pbb_get_kernel_name();
+        }
+    }
+}
+
+TEST_F(FloatResizerSelectTest, SelectFormat_OnlyZerosOrInvalidPrecision_SmallestFormatOrFailure) {
+    double zeros[3] = {0.0, -0.0, 0.0};
+    flr_format_spec spec;
+
+    ASSERT_EQ(flr_select_format(zeros, 3, 1e-3, 0, &spec), 1);
+    ASSERT_EQ(spec.exp_bits, 1);
+    ASSERT_EQ(spec.mant_bits, 0);
+    ASSERT_EQ(restored(-0.0, spec), 0.0);
+
+    ASSERT_EQ(flr_select_format(zeros, 3, 0.0, 0, &spec), 0);
+    ASSERT_EQ(flr_select_format(zeros, 3, std::numeric_limits<double>::quiet_NaN(), 0, &spec), 0);
+    ASSERT_EQ(flr_select_format(nullptr, 3, 1e-3, 0, &spec), 0);
+    ASSERT_EQ(flr_select_format(zeros, 3, 1e-3, 0, nullptr), 0);
+}
+
+TEST_F(FloatResizerSelectTest, SelectFormat_PrecisionBeyondDouble_FullMantissa) {
+    double values[2] = {1e6, 3.5};
+    flr_format_spec spec;
+
+    ASSERT_EQ(flr_select_format(values, 2, 1e-300, 0, &spec), 1);
+    ASSERT_EQ(spec.mant_bits, 52);
+    ASSERT_EQ(restored(values[1], spec), values[1]);
+}
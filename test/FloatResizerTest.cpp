@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <bit>
+#include <cmath>
 
 class FloatResizerTest : public ::testing::Test {
 };
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class PartialByteBufferDoubleAsTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *expected = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            pbb_destroy(&expected);
+        }
+
+        /**
+         * Longitudes with 5 decimal places, plus a few special values.
+         */
+        static std::vector<double> longitudes(size_t count) {
+            std::vector<double> values = {0.0, -0.0, 180.0, -180.0, std::numeric_limits<double>::infinity()};
+            srand(18);
+            while (values.size() < count) {
+                values.push_back((rand() % 36000001 - 18000000) / 100000.0);
+            }
+            return values;
+        }
+
+        /**
+         * The value expected back after a resize to [exp_bits] + [mant_bits] and back to double.
+         */
+        static double restored(double value, int exp_bits, int mant_bits) {
+            qword q;
+            q.uint64_val = flr_resize_float_long(
+                flr_resize_float_double(value, 11, 52, exp_bits, mant_bits), exp_bits, mant_bits, 11, 52
+            );
+            return q.double_val;
+        }
+};
+
+TEST_F(PartialByteBufferDoubleAsTest, WriteDoubleAs_Longitude_SameBitsAsResizeThenWrite) {
+    pbb = pbb_create(8);
+    expected = pbb_create(8);
+
+    pbb_write_byte(pbb, 0x1, 3);
+    pbb_write_byte(expected, 0x1, 3);
+    pbb_write_double_as(pbb, 13.40495, 6, 25);
+    pbb_write_int64(expected, (int64_t)flr_resize_float_double(13.40495, 11, 52, 6, 25), 32);
+
+    ASSERT_EQ(pbb->write_pos, 35);
+    ASSERT_EQ(memcmp(pbb->buffer, expected->buffer, pbb_get_length(pbb)), 0);
+}
+
+TEST_F(PartialByteBufferDoubleAsTest, ReadDoubleAs_AfterWrite_FiveDecimalsKept) {
+    pbb = pbb_create(8);
+    std::vector<double> values = longitudes(1000);
+
+    for (double value : values) {
+        pbb_write_double_as(pbb, value, 6, 25);
+    }
+    for (double value : values) {
+        double read = pbb_read_double_as(pbb, 6, 25);
+        ASSERT_EQ(read, restored(value, 6, 25));
+        if (std::isfinite(value)) {
+            ASSERT_NEAR(read, value, 0.5e-5);
+        }
+    }
+    ASSERT_EQ(pbb_read_double_as(pbb, 6, 25), 0.0);
+}
+
+TEST_F(PartialByteBufferDoubleAsTest, WriteDoubleAs_InvalidFormat_NothingWritten) {
+    pbb = pbb_create(8);
+    double values[2] = {1.0, 2.0};
+
+    pbb_write_double_as(pbb, 1.0, 11, 53);
+    ASSERT_EQ(pbb_write_double_array_as(pbb, values, 2, 40, 30), 0);
+    ASSERT_EQ(pbb->write_pos, 0);
+}
+
+TEST_F(PartialByteBufferDoubleAsTest, WriteDoubleArrayAs_ManyBlocks_SameBitsAsPerValue) {
+    pbb = pbb_create(1);
+    expected = pbb_create(1);
+    std::vector<double> values = longitudes(1537);
+
+    pbb_write_byte(pbb, 0x5, 5);
+    pbb_write_byte(expected, 0x5, 5);
+    ASSERT_EQ(pbb_write_double_array_as(pbb, values.data(), values.size(), 6, 24), values.size());
+    for (double value : values) {
+        pbb_write_double_as(expected, value, 6, 24);
+    }
+
+    ASSERT_EQ(pbb->write_pos, expected->write_pos);
+    ASSERT_EQ(memcmp(pbb->buffer, expected->buffer, pbb_get_length(pbb)), 0);
+}
+
+TEST_F(PartialByteBufferDoubleAsTest, ReadDoubleArrayAs_Segmented_SameValuesAsPerValue) {
+    pbb = pbb_create_segmented(64);
+    std::vector<double> values = longitudes(700);
+
+    ASSERT_EQ(pbb_write_double_array_as(pbb, values.data(), values.size(), 5, 17), values.size());
+
+    std::vector<double> read(values.size() + 10);
+    ASSERT_EQ(pbb_read_double_array_as(pbb, read.data(), read.size(), 5, 17), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(read[i], restored(values[i], 5, 17)) << "value " << i;
+    }
+}
+
+TEST_F(PartialByteBufferDoubleAsTest, WriteDoubleArrayAs_RingFillsUp_ValuesThatFitWritten) {
+    pbb = pbb_create_ring(16);
+    std::vector<double> values = longitudes(10);
+
+    ASSERT_EQ(pbb_write_double_array_as(pbb, values.data(), values.size(), 6, 25), 4);
+
+    double read[4];
+    ASSERT_EQ(pbb_read_double_array_as(pbb, read, 4, 6, 25), 4);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(read[i], restored(values[i], 6, 25));
+    }
+}
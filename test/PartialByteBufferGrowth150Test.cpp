@@ -12,10 +12,20 @@ class PartialByteBufferGrowth150Test : public ::testing::Test {
                 pbb_destroy(&pbb);
             }
         }
+
+        /**
+         * Create a buffer growing by 1.5x, whatever CAPACITY_GROWTH_MODE the library is built with.
+         */
+        static partial_byte_buffer* create(int capacity) {
+            partial_byte_buffer* created = pbb_create(capacity);
+            pbb_growth_policy policy = {PBB_GROWTH_HALF, 0, 0, nullptr, nullptr};
+            pbb_set_growth_policy(created, &policy);
+            return created;
+        }
 };
 
 TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExceedCapacityOnce_BufferGrowsCorrectly) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
     pbb_write_byte(pbb, 0x11, 8);
     pbb_write_byte(pbb, 0x22, 8);
@@ -30,7 +40,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExceedCapacityOnce_BufferGrowsC
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExceedCapacityTwice_BufferGrowsCorrectly) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
     pbb_write_byte(pbb, 0x11, 8);
     pbb_write_byte(pbb, 0x22, 8);
@@ -50,7 +60,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExceedCapacityTwice_BufferGrows
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteInt_ExceedCapacityOnce_BufferGrowsCorrectly) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_int(pbb, 0x11223344, 32); // requires growth past initial 2 bytes
@@ -66,7 +76,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteInt_ExceedCapacityOnce_BufferGrowsCo
 }
 
 TEST_F(PartialByteBufferGrowth150Test, PutPartialByteThenPartialInt_ExceedCapacity_CorrectBufferValuesAndCapacity) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_byte(pbb, 0b10100, 5);      
@@ -82,7 +92,7 @@ TEST_F(PartialByteBufferGrowth150Test, PutPartialByteThenPartialInt_ExceedCapaci
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteByteThenInt_ExceedCapacityTwiceAtOnce_CorrectBufferCapacity) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_byte(pbb, 0x11, 8);
@@ -93,7 +103,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteByteThenInt_ExceedCapacityTwiceAtOnc
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExactlyAtCapacity_NoGrowthYet) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_byte(pbb, 0xAA, 8);
@@ -108,7 +118,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteByte_ExactlyAtCapacity_NoGrowthYet)
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WritePartialByte_AtMaxCap_GrowsAndPreservesData) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_byte(pbb, 0xFF, 8);          // Byte 0 full
@@ -125,7 +135,7 @@ TEST_F(PartialByteBufferGrowth150Test, WritePartialByte_AtMaxCap_GrowsAndPreserv
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteInt_PartialBytesWithinCap_CapMaintained) {
-    pbb = pbb_create(4);
+    pbb = create(4);
     ASSERT_NE(pbb, nullptr);
 
     // Write 5 bits first
@@ -145,7 +155,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteInt_PartialBytesWithinCap_CapMaintai
 }
 
 TEST_F(PartialByteBufferGrowth150Test, WriteFullBytes_WriteMultipleTimes_CorrectFinalCapacity) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     // Write 16 bytes of data - will require multiple growth cycles
@@ -167,7 +177,7 @@ TEST_F(PartialByteBufferGrowth150Test, WriteFullBytes_WriteMultipleTimes_Correct
 
 TEST_F(PartialByteBufferGrowth150Test, WritePartialBytes_WriteMultipleTimes_CorrectFinalCapacity) {
     int cap = 2;
-    pbb = pbb_create(cap);
+    pbb = create(cap);
     ASSERT_NE(pbb, nullptr);
 
     const int random_seed = 42;
@@ -188,7 +198,7 @@ TEST_F(PartialByteBufferGrowth150Test, WritePartialBytes_WriteMultipleTimes_Corr
 }
 
 TEST_F(PartialByteBufferGrowth150Test, AlternatingBytesAndInts_MultipleGrowths_DataIntegrity) {
-    pbb = pbb_create(2);
+    pbb = create(2);
     ASSERT_NE(pbb, nullptr);
 
     pbb_write_byte(pbb, 0xAA, 8);         // 1 byte, capacity 2
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class PartialByteBufferGrowthPolicyTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+
+        void setPolicy(pbb_growth_mode mode, size_t increment, size_t max_capacity) {
+            pbb_growth_policy policy = {mode, increment, max_capacity, nullptr, nullptr};
+            ASSERT_EQ(pbb_set_growth_policy(pbb, &policy), 1);
+        }
+};
+
+static size_t addSixteenBytes(size_t, size_t required, void* context) {
+    ++*(int*)context;
+    return required + 16;
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Create_DefaultPolicy_BuildGrowthModeWithoutLimit) {
+    pbb = pbb_create(4);
+
+    ASSERT_TRUE(pbb->growth.mode == PBB_GROWTH_DOUBLE || pbb->growth.mode == PBB_GROWTH_HALF);
+    ASSERT_EQ(pbb->growth.max_capacity, 0);
+    ASSERT_EQ(pbb->growth.callback, nullptr);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, SetGrowthPolicy_InvalidPolicies_Rejected) {
+    pbb = pbb_create(4);
+    pbb_growth_mode mode = pbb->growth.mode;
+    pbb_growth_policy fixed = {PBB_GROWTH_FIXED, 0, 0, nullptr, nullptr};
+    pbb_growth_policy callback = {PBB_GROWTH_CALLBACK, 0, 0, nullptr, nullptr};
+
+    ASSERT_EQ(pbb_set_growth_policy(pbb, &fixed), 0);
+    ASSERT_EQ(pbb_set_growth_policy(pbb, &callback), 0);
+    ASSERT_EQ(pbb_set_growth_policy(pbb, nullptr), 0);
+    ASSERT_EQ(pbb->growth.mode, mode);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, WriteByte_DoubleAndHalfPolicies_BuffersGrowIndependently) {
+    pbb = pbb_create(4);
+    partial_byte_buffer* other = pbb_create(4);
+    setPolicy(PBB_GROWTH_DOUBLE, 0, 0);
+    pbb_growth_policy half = {PBB_GROWTH_HALF, 0, 0, nullptr, nullptr};
+    pbb_set_growth_policy(other, &half);
+
+    for (int i = 0; i < 5; ++i) {
+        pbb_write_byte(pbb, 0x11, 8);
+        pbb_write_byte(other, 0x11, 8);
+    }
+
+    ASSERT_EQ(pbb->capacity, 8);
+    ASSERT_EQ(other->capacity, 6);
+    pbb_destroy(&other);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, WriteInt_FixedIncrement_GrowsByWholeIncrements) {
+    pbb = pbb_create(4);
+    setPolicy(PBB_GROWTH_FIXED, 3, 0);
+
+    pbb_write_int(pbb, 0x12345678, 32);
+    pbb_write_byte(pbb, 0x11, 8);
+    ASSERT_EQ(pbb->capacity, 7);
+
+    pbb_write_int64(pbb, 0x0123456789ABCDEF, 64);
+    ASSERT_EQ(pbb->capacity, 13);
+    ASSERT_EQ(pbb->buffer[5], 0x01);
+    ASSERT_EQ(pbb->buffer[12], 0xEF);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, WriteByte_MaximumCapacity_GrowthClampedThenWritesDropped) {
+    pbb = pbb_create(4);
+    setPolicy(PBB_GROWTH_DOUBLE, 0, 6);
+
+    for (int i = 0; i < 6; ++i) {
+        pbb_write_byte(pbb, (int8_t)(i + 1), 8);
+    }
+    ASSERT_EQ(pbb->capacity, 6);
+    ASSERT_EQ(pbb->write_pos, 48);
+
+    pbb_write_byte(pbb, 0x7F, 8);
+    ASSERT_EQ(pbb->capacity, 6);
+    ASSERT_EQ(pbb->write_pos, 48);
+    ASSERT_EQ(pbb->buffer[5], 6);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, WriteByte_Callback_CapacityFromCallback) {
+    pbb = pbb_create(2);
+    int calls = 0;
+    pbb_growth_policy policy = {PBB_GROWTH_CALLBACK, 0, 0, addSixteenBytes, &calls};
+    pbb_set_growth_policy(pbb, &policy);
+
+    pbb_write_byte(pbb, 0x11, 8);
+    pbb_write_byte(pbb, 0x22, 8);
+    pbb_write_byte(pbb, 0x33, 8);
+
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(pbb->capacity, 19);
+    ASSERT_EQ(pbb->buffer[2], 0x33);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Reserve_MoreBits_ExactCapacityAndNoLaterGrowth) {
+    pbb = pbb_create(2);
+    pbb_write_byte(pbb, 0x11, 4);
+
+    ASSERT_EQ(pbb_reserve(pbb, 100), 1);
+    ASSERT_EQ(pbb->capacity, 13);
+    uint8_t* buffer = pbb->buffer;
+
+    for (int i = 0; i < 10; ++i) {
+        pbb_write_int(pbb, 0x3FF, 10);
+    }
+    ASSERT_EQ(pbb->buffer, buffer);
+    ASSERT_EQ(pbb->capacity, 13);
+    ASSERT_EQ(pbb->buffer[12], 0xFF);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Reserve_EnoughCapacityOrAboveMaximum_CapacityUnchanged) {
+    pbb = pbb_create(8);
+    setPolicy(PBB_GROWTH_DOUBLE, 0, 16);
+
+    ASSERT_EQ(pbb_reserve(pbb, 64), 1);
+    ASSERT_EQ(pbb_reserve(pbb, 129), 0);
+    ASSERT_EQ(pbb->capacity, 8);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Reserve_BorrowedArray_CopiedIntoOwnedBuffer) {
+    uint8_t array[] = {0xAB, 0xCD};
+    pbb = pbb_wrap_array(array, 2);
+
+    ASSERT_EQ(pbb_reserve(pbb, 16), 1);
+
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_OWNED);
+    ASSERT_NE(pbb->buffer, array);
+    ASSERT_EQ(pbb->capacity, 4);
+    ASSERT_EQ(pbb->buffer[1], 0xCD);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Reserve_BorrowedArrayLargeEnough_CopiedBeforeWrites) {
+    uint8_t array[] = {0xAB, 0xCD};
+    pbb = pbb_wrap_array(array, 2);
+    pbb_read_byte(pbb, 8);
+
+    // No bit to add: the capacity already fits, but the array still cannot take writes
+    ASSERT_EQ(pbb_reserve(pbb, 0), 1);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_OWNED);
+    ASSERT_EQ(pbb->capacity, 2);
+
+    ASSERT_EQ(pbb_reserve(pbb, 8), 1);
+    uint8_t* buffer = pbb->buffer;
+    pbb_write_byte(pbb, 0x12, 8);
+    ASSERT_EQ(pbb->buffer, buffer);
+    ASSERT_EQ(pbb->buffer[2], 0x12);
+    ASSERT_EQ(array[1], 0xCD);
+    ASSERT_EQ(pbb_read_byte(pbb, 8), (int8_t)0xCD);
+}
+
+TEST_F(PartialByteBufferGrowthPolicyTest, Reserve_BorrowedArrayAboveMaximum_StaysBorrowed) {
+    uint8_t array[] = {0xAB, 0xCD, 0xEF};
+    pbb = pbb_wrap_array(array, 3);
+    setPolicy(PBB_GROWTH_DOUBLE, 0, 3);
+
+    ASSERT_EQ(pbb_reserve(pbb, 1), 0);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_BORROWED);
+    ASSERT_EQ(pbb->buffer, array);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+class PartialByteBufferIovecTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+
+        /**
+         * Concatenate the ranges described by [count] entries.
+         */
+        static std::vector<uint8_t> concat(const struct iovec* iov, size_t count) {
+            std::vector<uint8_t> bytes;
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t* base = (const uint8_t*)iov[i].iov_base;
+                bytes.insert(bytes.end(), base, base + iov[i].iov_len);
+            }
+            return bytes;
+        }
+
+        /**
+         * Read everything from [fd] until end of file.
+         */
+        static std::vector<uint8_t> drain(int fd) {
+            std::vector<uint8_t> bytes;
+            uint8_t chunk[4096];
+            ssize_t count;
+            while ((count = read(fd, chunk, sizeof(chunk))) > 0) bytes.insert(bytes.end(), chunk, chunk + count);
+            return bytes;
+        }
+};
+
+TEST_F(PartialByteBufferIovecTest, ToIovec_PartialLastByte_OneEntryWithPaddedByte) {
+    pbb = pbb_create(16);
+    pbb_write_int(pbb, 0xABC, 12);
+    struct iovec iov[2];
+
+    ASSERT_EQ(pbb_to_iovec(pbb, iov, 2), 1);
+    ASSERT_EQ(iov[0].iov_base, pbb->buffer);
+    ASSERT_EQ(iov[0].iov_len, 2);
+    ASSERT_EQ(concat(iov, 1), std::vector<uint8_t>({0xAB, 0xC0}));
+}
+
+TEST_F(PartialByteBufferIovecTest, ToIovec_EmptyOrNull_NoEntries) {
+    pbb = pbb_create(16);
+
+    ASSERT_EQ(pbb_to_iovec(pbb, nullptr, 0), 0);
+    ASSERT_EQ(pbb_to_iovec(nullptr, nullptr, 0), 0);
+}
+
+TEST_F(PartialByteBufferIovecTest, ToIovec_Segmented_OneEntryPerSegmentPointingIntoStorage) {
+    pbb = pbb_create_segmented(16);
+    for (int i = 0; i < 40; ++i) {
+        pbb_write_byte(pbb, (int8_t)i, 8);
+    }
+    pbb_write_byte(pbb, 0x1, 1);
+
+    ASSERT_EQ(pbb_to_iovec(pbb, nullptr, 0), 3);
+
+    struct iovec iov[3];
+    ASSERT_EQ(pbb_to_iovec(pbb, iov, 2), 3);
+    ASSERT_EQ(iov[0].iov_base, pbb->segments[0]);
+    ASSERT_EQ(iov[1].iov_base, pbb->segments[1]);
+    ASSERT_EQ(iov[1].iov_len, 16);
+
+    ASSERT_EQ(pbb_to_iovec(pbb, iov, 3), 3);
+    ASSERT_EQ(iov[2].iov_len, 9);
+    std::vector<uint8_t> bytes = concat(iov, 3);
+    std::vector<uint8_t> exported(pbb_get_length(pbb));
+    ASSERT_EQ(pbb_export(pbb, exported.data(), exported.size()), 41);
+    ASSERT_EQ(bytes, exported);
+    ASSERT_EQ(bytes[40], 0x80);
+}
+
+TEST_F(PartialByteBufferIovecTest, ToIovec_WrappedRing_TwoEntriesFromReadCursor) {
+    pbb = pbb_create_ring(16);
+    uint8_t data[16];
+    for (int i = 0; i < 16; ++i) data[i] = (uint8_t)(i + 1);
+
+    ASSERT_EQ(pbb_ring_write(pbb, data, 12 * 8), 12 * 8);
+    ASSERT_EQ(pbb_ring_read(pbb, data, 10 * 8), 10 * 8);
+    ASSERT_EQ(pbb_ring_write(pbb, data, 8 * 8), 8 * 8);
+
+    struct iovec iov[2];
+    ASSERT_EQ(pbb_to_iovec(pbb, iov, 2), 2);
+    ASSERT_EQ(iov[0].iov_base, pbb->buffer + 10);
+    ASSERT_EQ(iov[0].iov_len, 6);
+    ASSERT_EQ(iov[1].iov_base, pbb->buffer);
+    ASSERT_EQ(iov[1].iov_len, 4);
+    ASSERT_EQ(concat(iov, 2), std::vector<uint8_t>({11, 12, 1, 2, 3, 4, 5, 6, 7, 8}));
+}
+
+TEST_F(PartialByteBufferIovecTest, Writev_ManySegments_SameBytesAsExport) {
+    pbb = pbb_create_segmented(16);
+    srand(15);
+    for (int i = 0; i < 3000; ++i) {
+        pbb_write_int(pbb, rand(), (uint8_t)(rand() % 32 + 1));
+    }
+    ASSERT_GT(pbb_to_iovec(pbb, nullptr, 0), 200);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(pbb_writev(pbb, fds[1]), 1);
+    close(fds[1]);
+
+    std::vector<uint8_t> exported(pbb_get_length(pbb));
+    pbb_export(pbb, exported.data(), exported.size());
+    ASSERT_EQ(drain(fds[0]), exported);
+    close(fds[0]);
+}
+
+TEST_F(PartialByteBufferIovecTest, Writev_TemporaryFile_BytesWritten) {
+    pbb = pbb_create(4);
+    pbb_write_int64(pbb, 0x0123456789ABCDEF, 64);
+    pbb_write_byte(pbb, 0x5, 3);
+
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(pbb_writev(pbb, fileno(file)), 1);
+    ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+    ASSERT_EQ(drain(fileno(file)), std::vector<uint8_t>({0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xA0}));
+    fclose(file);
+}
+
+TEST_F(PartialByteBufferIovecTest, Writev_InvalidDescriptor_Fails) {
+    pbb = pbb_create(4);
+    pbb_write_byte(pbb, 1, 8);
+
+    ASSERT_EQ(pbb_writev(pbb, -1), 0);
+    ASSERT_EQ(pbb_writev(nullptr, 1), 0);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class PartialByteBufferKernelTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *expected = nullptr;
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+            pbb_destroy(&pbb);
+            pbb_destroy(&expected);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+};
+
+TEST_F(PartialByteBufferKernelTest, GetKernel_AfterLoad_FastestSupportedKernel) {
+    std::vector<pbb_kernel> kernels = supportedKernels();
+
+    ASSERT_FALSE(kernels.empty());
+    ASSERT_EQ(kernels.front(), PBB_KERNEL_SCALAR);
+    ASSERT_EQ(pbb_get_kernel(), kernels.back());
+}
+
+TEST_F(PartialByteBufferKernelTest, SetKernel_Scalar_AlwaysSupported) {
+    ASSERT_EQ(pbb_set_kernel(PBB_KERNEL_SCALAR), 1);
+    ASSERT_EQ(pbb_get_kernel(), PBB_KERNEL_SCALAR);
+    ASSERT_STREQ(pbb_get_kernel_name(), "scalar");
+}
+
+TEST_F(PartialByteBufferKernelTest, SetKernel_InvalidKernel_SelectionUnchanged) {
+    pbb_set_kernel(PBB_KERNEL_SCALAR);
+
+    ASSERT_EQ(pbb_set_kernel(PBB_KERNEL_COUNT), 0);
+    ASSERT_EQ(pbb_get_kernel(), PBB_KERNEL_SCALAR);
+}
+
+TEST_F(PartialByteBufferKernelTest, AllKernels_WriteAndReadInt32Array_SameAsSingleCalls) {
+    const size_t count = 131;
+    int32_t values[count], actual[count];
+    srand(2024);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+    }
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        for (uint8_t bits = 1; bits <= 32; ++bits) {
+            for (uint8_t lead_bits = 1; lead_bits <= 8; ++lead_bits) {
+                pbb = pbb_create(1);
+                expected = pbb_create(1);
+                pbb_write_byte(pbb, 0x5A, lead_bits);
+                pbb_write_byte(expected, 0x5A, lead_bits);
+
+                pbb_write_int32_array(pbb, values, count, bits);
+                for (size_t i = 0; i < count; ++i) pbb_write_int32(expected, values[i], bits);
+
+                ASSERT_EQ(pbb->write_pos, expected->write_pos);
+                ASSERT_EQ(memcmp(pbb->buffer, expected->buffer, pbb_get_length(pbb)), 0)
+                    << pbb_get_kernel_name() << ", bits = " << (int)bits << ", lead = " << (int)lead_bits;
+
+                pbb_read_byte(pbb, lead_bits);
+                ASSERT_EQ(pbb_read_int32_array(pbb, actual, count, bits), count);
+                pbb_read_byte(expected, lead_bits);
+                for (size_t i = 0; i < count; ++i) {
+                    ASSERT_EQ(actual[i], pbb_read_int32(expected, bits))
+                        << pbb_get_kernel_name() << ", bits = " << (int)bits << ", lead = " << (int)lead_bits << ", value " << i;
+                }
+
+                pbb_destroy(&pbb);
+                pbb_destroy(&expected);
+            }
+        }
+    }
+}
+
+TEST_F(PartialByteBufferKernelTest, AllKernels_WriteAndReadInt64Array_SameAsSingleCalls) {
+    const size_t count = 67;
+    int64_t values[count], actual[count];
+    srand(4202);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = (int64_t)(((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand());
+    }
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        for (uint8_t bits = 1; bits <= 64; ++bits) {
+            for (uint8_t lead_bits = 1; lead_bits <= 8; ++lead_bits) {
+                pbb = pbb_create(1);
+                expected = pbb_create(1);
+                pbb_write_byte(pbb, 0x5A, lead_bits);
+                pbb_write_byte(expected, 0x5A, lead_bits);
+
+                pbb_write_int64_array(pbb, values, count, bits);
+                for (size_t i = 0; i < count; ++i) pbb_write_int64(expected, values[i], bits);
+
+                ASSERT_EQ(pbb->write_pos, expected->write_pos);
+                ASSERT_EQ(memcmp(pbb->buffer, expected->buffer, pbb_get_length(pbb)), 0)
+                    << pbb_get_kernel_name() << ", bits = " << (int)bits << ", lead = " << (int)lead_bits;
+
+                pbb_read_byte(pbb, lead_bits);
+                ASSERT_EQ(pbb_read_int64_array(pbb, actual, count, bits), count);
+                pbb_read_byte(expected, lead_bits);
+                for (size_t i = 0; i < count; ++i) {
+                    ASSERT_EQ(actual[i], pbb_read_int64(expected, bits))
+                        << pbb_get_kernel_name() << ", bits = " << (int)bits << ", lead = " << (int)lead_bits << ", value " << i;
+                }
+
+                pbb_destroy(&pbb);
+                pbb_destroy(&expected);
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+class PartialByteBufferMmapTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        char path[32] = "/tmp/pbb_mmap_XXXXXX";
+
+        void SetUp() override {
+            int fd = mkstemp(path);
+            ASSERT_GE(fd, 0);
+            close(fd);
+        }
+
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            unlink(path);
+        }
+
+        void writeFile(const uint8_t* data, size_t size) {
+            FILE* file = fopen(path, "wb");
+            ASSERT_NE(file, nullptr);
+            ASSERT_EQ(fwrite(data, 1, size, file), size);
+            fclose(file);
+        }
+};
+
+TEST_F(PartialByteBufferMmapTest, OpenMmap_FewBytes_CorrectBufferAndCursors) {
+    uint8_t data[] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+    writeFile(data, 5);
+
+    pbb = pbb_open_mmap(path);
+
+    ASSERT_NE(pbb, nullptr);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_MAPPED);
+    ASSERT_EQ(pbb->capacity, 5);
+    ASSERT_EQ(pbb->write_pos, 40);
+    ASSERT_EQ(pbb->read_pos, 0);
+    ASSERT_EQ(pbb->buffer[4], 0x9A);
+}
+
+TEST_F(PartialByteBufferMmapTest, OpenMmap_ReadValues_SameAsFromArray) {
+    uint8_t data[4099];
+    srand(707);
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = (uint8_t)rand();
+    writeFile(data, sizeof(data));
+
+    pbb = pbb_open_mmap(path);
+    partial_byte_buffer* copy = pbb_from_array(data, sizeof(data));
+    ASSERT_NE(pbb, nullptr);
+
+    int64_t values[sizeof(data) * 8 / 37];
+    size_t count = pbb_read_int64_array(pbb, values, sizeof(values) / sizeof(values[0]), 37);
+    ASSERT_EQ(count, sizeof(values) / sizeof(values[0]));
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(values[i], pbb_read_int64(copy, 37)) << "Mismatch at value " << i;
+    }
+    ASSERT_EQ(pbb_read_int(pbb, 7), pbb_read_int(copy, 7));
+
+    pbb_destroy(&copy);
+}
+
+TEST_F(PartialByteBufferMmapTest, OpenMmap_MissingOrEmptyFile_ReturnsNull) {
+    ASSERT_EQ(pbb_open_mmap(path), nullptr); // Empty file
+    ASSERT_EQ(pbb_open_mmap("/nonexistent/pbb_file"), nullptr);
+    ASSERT_EQ(pbb_open_mmap(nullptr), nullptr);
+}
+
+TEST_F(PartialByteBufferMmapTest, WriteInt_MappedFile_CopiesAndLeavesFileUnchanged) {
+    uint8_t data[] = {0xAB, 0xCD};
+    writeFile(data, 2);
+    pbb = pbb_open_mmap(path);
+
+    pbb_write_int(pbb, 0x1234, 16);
+
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_OWNED);
+    ASSERT_EQ(pbb->buffer[0], 0xAB);
+    ASSERT_EQ(pbb->buffer[2], 0x12);
+    ASSERT_EQ(pbb->buffer[3], 0x34);
+    ASSERT_EQ(pbb->write_pos, 32);
+
+    uint8_t file_data[4] = {0};
+    FILE* file = fopen(path, "rb");
+    ASSERT_EQ(fread(file_data, 1, sizeof(file_data), file), 2);
+    fclose(file);
+    ASSERT_EQ(file_data[0], 0xAB);
+    ASSERT_EQ(file_data[1], 0xCD);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class PartialByteBufferReadArrayTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+
+        /**
+         * Fill a buffer with [lead_bits] bits followed by [count] random values of [bits] bits.
+         * The expected sign-extended values are returned in [expected].
+         */
+        void writeRandomValues(uint8_t lead_bits, size_t count, uint8_t bits, std::vector<int64_t>& expected) {
+            pbb_destroy(&pbb);
+            pbb = pbb_create(1);
+            if (lead_bits > 0) pbb_write_byte(pbb, 0x55, lead_bits);
+
+            expected.clear();
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t random = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+                int64_t value = bits == 64 ? (int64_t)random : (int64_t)(random << (64 - bits)) >> (64 - bits);
+                pbb_write_int64(pbb, value, bits);
+                expected.push_back(value);
+            }
+            pbb_read_byte(pbb, lead_bits);
+        }
+};
+
+TEST_F(PartialByteBufferReadArrayTest, ReadInt32Array_FewValues_CorrectValuesAndCursor) {
+    uint8_t data[] = {0b10101011, 0b10011100};
+    pbb = pbb_from_array(data, 2);
+    int32_t values[5];
+
+    size_t read = pbb_read_int32_array(pbb, values, 5, 3);
+
+    ASSERT_EQ(read, 5);
+    ASSERT_EQ(values[0], -3);
+    ASSERT_EQ(values[1], 2);
+    ASSERT_EQ(values[2], -1);
+    ASSERT_EQ(values[3], 1);
+    ASSERT_EQ(values[4], -2);
+    ASSERT_EQ(pbb->read_pos, 15);
+}
+
+TEST_F(PartialByteBufferReadArrayTest, ReadInt32Array_AllWidthsAndOffsets_SameAsSingleReads) {
+    std::vector<int64_t> expected;
+    int32_t values[203];
+    srand(12345);
+
+    for (uint8_t bits = 1; bits <= 32; ++bits) {
+        for (uint8_t lead_bits = 0; lead_bits < 8; ++lead_bits) {
+            writeRandomValues(lead_bits, 203, bits, expected);
+
+            ASSERT_EQ(pbb_read_int32_array(pbb, values, 203, bits), 203);
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQ(values[i], (int32_t)expected[i]) << "bits = " << (int)bits << ", lead = " << (int)lead_bits << ", value " << i;
+            }
+            ASSERT_EQ(pbb->read_pos, pbb->write_pos);
+        }
+    }
+}
+
+TEST_F(PartialByteBufferReadArrayTest, ReadInt64Array_AllWidthsAndOffsets_SameAsSingleReads) {
+    std::vector<int64_t> expected;
+    int64_t values[101];
+    srand(54321);
+
+    for (uint8_t bits = 1; bits <= 64; ++bits) {
+        for (uint8_t lead_bits = 0; lead_bits < 8; ++lead_bits) {
+            writeRandomValues(lead_bits, 101, bits, expected);
+
+            ASSERT_EQ(pbb_read_int64_array(pbb, values, 101, bits), 101);
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQ(values[i], expected[i]) << "bits = " << (int)bits << ", lead = " << (int)lead_bits << ", value " << i;
+            }
+            ASSERT_EQ(pbb->read_pos, pbb->write_pos);
+        }
+    }
+}
+
+TEST_F(PartialByteBufferReadArrayTest, ReadArray_MoreThanAvailable_ReadsWholeValuesOnly) {
+    uint8_t data[] = {0x12, 0x34, 0x56};
+    pbb = pbb_from_array(data, 3);
+    int32_t values[4] = {0};
+
+    size_t read = pbb_read_int32_array(pbb, values, 4, 10); // Only 2 whole values in 24 bits
+
+    ASSERT_EQ(read, 2);
+    ASSERT_EQ(values[0], 0x048);
+    ASSERT_EQ(values[1], -0x0BB);
+    ASSERT_EQ(values[2], 0);
+    ASSERT_EQ(pbb->read_pos, 20);
+
+    ASSERT_EQ(pbb_read_int32_array(pbb, values, 4, 10), 0);
+    ASSERT_EQ(pbb->read_pos, 20);
+}
+
+TEST_F(PartialByteBufferReadArrayTest, ReadArray_InvalidArguments_ReturnsZero) {
+    uint8_t data[] = {0x12, 0x34};
+    pbb = pbb_from_array(data, 2);
+    int32_t values32[2];
+    int64_t values64[2];
+
+    ASSERT_EQ(pbb_read_int32_array(nullptr, values32, 2, 8), 0);
+    ASSERT_EQ(pbb_read_int32_array(pbb, nullptr, 2, 8), 0);
+    ASSERT_EQ(pbb_read_int32_array(pbb, values32, 2, 0), 0);
+    ASSERT_EQ(pbb_read_int32_array(pbb, values32, 2, 33), 0);
+    ASSERT_EQ(pbb_read_int64_array(pbb, values64, 2, 65), 0);
+    ASSERT_EQ(pbb->read_pos, 0);
+}
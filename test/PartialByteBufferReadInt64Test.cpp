@@ -126,3 +126,36 @@ TEST_F(PartialByteBufferReadInt64Test, ReadInt64_CrossByteBoundaries_CorrectValu
     ASSERT_EQ(value2, (int64_t) 0xFFFFFFFAB3C03F5A);
     ASSERT_EQ(pbb->read_pos, 42);
 }
+
+TEST_F(PartialByteBufferReadInt64Test, ReadInt64_FullInt64AfterPartialByte_SpansNineBytes) {
+    uint8_t data[] = {0xA0, 0x24, 0x68, 0xAC, 0xF1, 0x35, 0x79, 0xBD, 0xE0};
+    pbb = pbb_from_array(data, 9);
+
+    int64_t value1 = pbb_read_int64(pbb, 3); // Read 3 bits: 101
+    ASSERT_EQ(value1, -3);
+
+    int64_t value2 = pbb_read_int64(pbb, 64); // Read 64 bits spread over 9 bytes
+    ASSERT_EQ(value2, (int64_t) 0x0123456789ABCDEF);
+    ASSERT_EQ(pbb->read_pos, 67);
+}
+
+TEST_F(PartialByteBufferReadInt64Test, ReadInt64_WriteThenReadRandomWidths_RoundTrip) {
+    const int total_values = 1000;
+    int64_t values[total_values];
+    uint8_t widths[total_values];
+    pbb = pbb_create(16);
+
+    srand(12345);
+    for (int i = 0; i < total_values; ++i) {
+        widths[i] = (uint8_t)(rand() % 64 + 1);
+        int64_t random = (int64_t)(((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^ (uint64_t)rand());
+        // Keep only [widths[i]] bits, sign-extended
+        values[i] = widths[i] == 64 ? random : (int64_t)((uint64_t)random << (64 - widths[i])) >> (64 - widths[i]);
+        pbb_write_int64(pbb, values[i], widths[i]);
+    }
+
+    for (int i = 0; i < total_values; ++i) {
+        ASSERT_EQ(pbb_read_int64(pbb, widths[i]), values[i]) << "Mismatch at value " << i;
+    }
+    ASSERT_EQ(pbb->read_pos, pbb->write_pos);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+class PartialByteBufferReaderTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *reference = nullptr;
+        std::vector<uint8_t> stream;
+        size_t offset = 0;
+        size_t max_chunk = 3;
+        int calls = 0;
+
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            pbb_destroy(&reference);
+        }
+
+        static size_t provide(uint8_t* dst, size_t size, void* context) {
+            // Hand out at most [max_chunk] bytes at once, like a slow socket
+            PartialByteBufferReaderTest* test = (PartialByteBufferReaderTest*)context;
+            ++test->calls;
+            size_t count = std::min(std::min(size, test->max_chunk), test->stream.size() - test->offset);
+            memcpy(dst, test->stream.data() + test->offset, count);
+            test->offset += count;
+            return count;
+        }
+};
+
+TEST_F(PartialByteBufferReaderTest, CreateReader_InvalidParameters_NothingAllocated) {
+    ASSERT_EQ(pbb_create_reader(16, nullptr, this), nullptr);
+    ASSERT_EQ(pbb_create_fd_reader(-1, 16), nullptr);
+    ASSERT_EQ(pbb_create_file_reader(nullptr, 16), nullptr);
+}
+
+TEST_F(PartialByteBufferReaderTest, ReadInt_BitsNotPulledYet_RefilledOnDemand) {
+    stream = {0x12, 0x34, 0x56, 0x78, 0x9A};
+    pbb = pbb_create_reader(4, provide, this);
+
+    ASSERT_EQ(pbb->capacity, 16);
+    ASSERT_EQ(calls, 0);
+    ASSERT_EQ(pbb_read_int(pbb, 12), 0x123);
+    ASSERT_EQ(offset, 3);
+
+    ASSERT_EQ(pbb_read_int(pbb, 24), 0x456789);
+    ASSERT_EQ(offset, 5);
+    // The first byte was dropped from the window by the refill
+    ASSERT_EQ(pbb->read_pos, 28);
+}
+
+TEST_F(PartialByteBufferReaderTest, ReadByte_EndOfStream_ReturnsZeroAndKeepsCursor) {
+    stream = {0xAB};
+    pbb = pbb_create_reader(16, provide, this);
+
+    ASSERT_EQ(pbb_read_byte(pbb, 4), -6);
+    ASSERT_EQ(pbb_read_byte(pbb, 5), 0);
+    ASSERT_EQ(pbb_read_byte(pbb, 4), -5);
+    ASSERT_EQ(pbb_read_byte(pbb, 1), 0);
+}
+
+TEST_F(PartialByteBufferReaderTest, ReadInt64_LongRandomStream_SameValuesWithConstantWindow) {
+    reference = pbb_create(1);
+    std::vector<uint8_t> widths;
+    std::vector<int64_t> values;
+
+    srand(13);
+    for (int i = 0; i < 20000; ++i) {
+        uint8_t bits = (uint8_t)(rand() % 64 + 1);
+        int64_t value = (int64_t)(((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand());
+        value = (int64_t)((uint64_t)value << (64 - bits)) >> (64 - bits);
+        widths.push_back(bits);
+        values.push_back(value);
+        pbb_write_int64(reference, value, bits);
+    }
+    stream.assign(reference->buffer, reference->buffer + pbb_get_length(reference));
+    max_chunk = 100;
+    pbb = pbb_create_reader(64, provide, this);
+
+    for (size_t i = 0; i < widths.size(); ++i) {
+        ASSERT_EQ(pbb_read_int64(pbb, widths[i]), values[i]) << "value " << i;
+    }
+    ASSERT_EQ(pbb->capacity, 64);
+    ASSERT_EQ(offset, stream.size());
+}
+
+TEST_F(PartialByteBufferReaderTest, ReadInt32Array_MoreValuesThanWindow_DecodedWindowByWindow) {
+    reference = pbb_create(1);
+    const size_t count = 1000;
+    int32_t values[count];
+
+    srand(14);
+    pbb_write_byte(reference, 0x3, 3);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = (int32_t)((uint32_t)rand() << 9) >> 9;
+    }
+    pbb_write_int32_array(reference, values, count, 23);
+    stream.assign(reference->buffer, reference->buffer + pbb_get_length(reference));
+    max_chunk = 37;
+    pbb = pbb_create_reader(32, provide, this);
+
+    int32_t decoded[count + 10];
+    ASSERT_EQ(pbb_read_byte(pbb, 3), 0x3);
+    ASSERT_EQ(pbb_read_int32_array(pbb, decoded, count + 10, 23), count);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(decoded[i], values[i]) << "value " << i;
+    }
+    ASSERT_EQ(pbb->capacity, 32);
+}
+
+TEST_F(PartialByteBufferReaderTest, CreateFileReader_TemporaryFile_ValuesRead) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    for (int i = 0; i < 100; ++i) fputc(i, file);
+    rewind(file);
+    pbb = pbb_create_file_reader(file, 16);
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(pbb_read_int(pbb, 16), (2 * i) << 8 | (2 * i + 1));
+    }
+    ASSERT_EQ(pbb_read_int(pbb, 1), 0);
+    fclose(file);
+}
+
+TEST_F(PartialByteBufferReaderTest, CreateFdReader_Pipe_ValuesRead) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    uint8_t data[] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xF0};
+    ASSERT_EQ(write(fds[1], data, sizeof(data)), (ssize_t)sizeof(data));
+    close(fds[1]);
+    pbb = pbb_create_fd_reader(fds[0], 16);
+
+    ASSERT_EQ(pbb_read_int64(pbb, 64), (int64_t)0x0123456789ABCDEF);
+    ASSERT_EQ(pbb_read_byte(pbb, 4), -1);
+    ASSERT_EQ(pbb_read_byte(pbb, 8), 0);
+    close(fds[0]);
+}
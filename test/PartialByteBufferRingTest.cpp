@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+class PartialByteBufferRingTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+};
+
+TEST_F(PartialByteBufferRingTest, CreateRing_ValidCapacity_EmptyRing) {
+    pbb = pbb_create_ring(4);
+
+    ASSERT_NE(pbb, nullptr);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_RING);
+    ASSERT_EQ(pbb->capacity, 4);
+    ASSERT_EQ(pbb_ring_is_empty(pbb), 1);
+    ASSERT_EQ(pbb_ring_is_full(pbb), 0);
+    ASSERT_EQ(pbb_ring_free_bits(pbb), 32);
+    ASSERT_EQ(pbb_ring_used_bits(pbb), 0);
+}
+
+TEST_F(PartialByteBufferRingTest, CreateRing_ZeroCapacity_NothingAllocated) {
+    ASSERT_EQ(pbb_create_ring(0), nullptr);
+}
+
+TEST_F(PartialByteBufferRingTest, WriteInt_UntilFull_ExtraWriteDroppedWithoutGrowth) {
+    pbb = pbb_create_ring(4);
+    uint8_t* buffer = pbb->buffer;
+
+    pbb_write_int(pbb, 0x1234, 16);
+    pbb_write_int(pbb, 0x5678, 16);
+    ASSERT_EQ(pbb_ring_is_full(pbb), 1);
+    ASSERT_EQ(pbb->write_pos, 0);
+
+    pbb_write_byte(pbb, 0x01, 1);
+    ASSERT_EQ(pbb_ring_used_bits(pbb), 32);
+    ASSERT_EQ(pbb->buffer, buffer);
+    ASSERT_EQ(pbb->capacity, 4);
+    ASSERT_EQ(pbb->buffer[0], 0x12);
+}
+
+TEST_F(PartialByteBufferRingTest, ReadInt_UntilEmpty_ExtraReadReturnsZero) {
+    pbb = pbb_create_ring(4);
+    pbb_write_int(pbb, 0x123, 12);
+
+    ASSERT_EQ(pbb_read_int(pbb, 12), 0x123);
+    ASSERT_EQ(pbb_ring_is_empty(pbb), 1);
+    ASSERT_EQ(pbb_read_int(pbb, 4), 0);
+    ASSERT_EQ(pbb->read_pos, 12);
+}
+
+TEST_F(PartialByteBufferRingTest, WriteInt64_AcrossEndOfRing_CursorsWrap) {
+    pbb = pbb_create_ring(8);
+    pbb_write_int64(pbb, 0, 44);
+    pbb_read_int64(pbb, 44);
+
+    pbb_write_int64(pbb, (int64_t)0x0123456789ABCDEF, 64);
+
+    ASSERT_EQ(pbb->write_pos, 44);
+    ASSERT_EQ(pbb->buffer[6], 0x12);
+    ASSERT_EQ(pbb->buffer[7], 0x34);
+    ASSERT_EQ(pbb->buffer[0], 0x56);
+    ASSERT_EQ(pbb->buffer[4], 0xDE);
+    ASSERT_EQ(pbb->buffer[5], 0xF0);
+    ASSERT_EQ(pbb_ring_is_full(pbb), 1);
+    ASSERT_EQ(pbb_read_int64(pbb, 64), (int64_t)0x0123456789ABCDEF);
+    ASSERT_EQ(pbb->read_pos, 44);
+    ASSERT_EQ(pbb_ring_is_empty(pbb), 1);
+}
+
+TEST_F(PartialByteBufferRingTest, ReadByte_ReadBits_ClearedForNextWrites) {
+    pbb = pbb_create_ring(2);
+    pbb_write_int(pbb, 0xFFFF, 16);
+
+    ASSERT_EQ(pbb_read_byte(pbb, 3), -1);
+    ASSERT_EQ(pbb->buffer[0], 0x1F);
+    pbb_write_byte(pbb, 0x2, 3);
+
+    ASSERT_EQ(pbb->buffer[0], 0x5F);
+    ASSERT_EQ(pbb_read_int(pbb, 13), -1);
+    ASSERT_EQ(pbb_read_byte(pbb, 3), 0x2);
+}
+
+TEST_F(PartialByteBufferRingTest, RingWrite_MoreBitsThanFree_PartialWriteReported) {
+    pbb = pbb_create_ring(3);
+    uint8_t data[] = {0xAB, 0xCD, 0xEF, 0x12};
+    pbb_write_byte(pbb, 0x5, 4);
+
+    ASSERT_EQ(pbb_ring_write(pbb, data, 32), 20);
+    ASSERT_EQ(pbb_ring_is_full(pbb), 1);
+    ASSERT_EQ(pbb_ring_write(pbb, data, 8), 0);
+
+    uint8_t out[4] = {0};
+    ASSERT_EQ(pbb_ring_read(pbb, out, 4), 4);
+    ASSERT_EQ(out[0], 0x50);
+    ASSERT_EQ(pbb_ring_read(pbb, out, 32), 20);
+    ASSERT_EQ(out[0], 0xAB);
+    ASSERT_EQ(out[1], 0xCD);
+    ASSERT_EQ(out[2], 0xE0);
+    ASSERT_EQ(pbb_ring_is_empty(pbb), 1);
+}
+
+TEST_F(PartialByteBufferRingTest, RingWrite_WholeRingFromUnalignedCursor_NoBitLost) {
+    pbb = pbb_create_ring(2);
+    pbb_write_byte(pbb, 0x3, 4);
+    pbb_read_byte(pbb, 4);
+    uint8_t data[] = {0xC3, 0x5A};
+
+    ASSERT_EQ(pbb_ring_write(pbb, data, 16), 16);
+
+    uint8_t out[2] = {0};
+    ASSERT_EQ(pbb_ring_read(pbb, out, 16), 16);
+    ASSERT_EQ(out[0], 0xC3);
+    ASSERT_EQ(out[1], 0x5A);
+}
+
+TEST_F(PartialByteBufferRingTest, WriteInt32Array_MoreValuesThanFree_CountOfWrittenValues) {
+    pbb = pbb_create_ring(4);
+    int32_t values[] = {1, -2, 3, -4, 5};
+
+    ASSERT_EQ(pbb_write_int32_array(pbb, values, 5, 7), 4);
+    ASSERT_EQ(pbb_ring_free_bits(pbb), 4);
+
+    int32_t decoded[5] = {0};
+    ASSERT_EQ(pbb_read_int32_array(pbb, decoded, 5, 7), 4);
+    ASSERT_EQ(decoded[1], -2);
+    ASSERT_EQ(decoded[3], -4);
+}
+
+TEST_F(PartialByteBufferRingTest, ProducerConsumer_RandomWidths_SameValuesInOrder) {
+    pbb = pbb_create_ring(24);
+    std::deque<std::pair<int64_t, uint8_t>> pending;
+    int64_t values[8];
+    int64_t decoded[8];
+
+    srand(10);
+    for (int step = 0; step < 4000; ++step) {
+        uint8_t bits = (uint8_t)(rand() % 64 + 1);
+        if (rand() % 2 == 0) {
+            // Produce a few values, singly or as an array, as long as they fit
+            size_t count = (size_t)(rand() % 8 + 1);
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t random = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+                values[i] = (int64_t)(random << (64 - bits)) >> (64 - bits);
+            }
+            size_t fitting = std::min(count, pbb_ring_free_bits(pbb) / bits);
+            size_t written;
+            if (count == 1) {
+                size_t before = pbb_ring_used_bits(pbb);
+                pbb_write_int64(pbb, values[0], bits);
+                written = (pbb_ring_used_bits(pbb) - before) / bits;
+            } else {
+                written = pbb_write_int64_array(pbb, values, count, bits);
+            }
+            ASSERT_EQ(written, fitting);
+            for (size_t i = 0; i < written; ++i) pending.emplace_back(values[i], bits);
+        } else {
+            // Consume the pending values sharing the width of the first one
+            size_t count = 0;
+            while (count < pending.size() && count < 8 && pending[count].second == pending.front().second) ++count;
+            if (count == 0) continue;
+            ASSERT_EQ(pbb_read_int64_array(pbb, decoded, count, pending.front().second), count);
+            for (size_t i = 0; i < count; ++i) {
+                ASSERT_EQ(decoded[i], pending.front().first) << "step " << step;
+                pending.pop_front();
+            }
+        }
+    }
+}
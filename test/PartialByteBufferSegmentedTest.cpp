@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class PartialByteBufferSegmentedTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *reference = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            pbb_destroy(&reference);
+        }
+};
+
+TEST_F(PartialByteBufferSegmentedTest, CreateSegmented_SizeRoundedUp_OneSegmentAndCorrectCursors) {
+    pbb = pbb_create_segmented(20);
+
+    ASSERT_NE(pbb, nullptr);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_SEGMENTED);
+    ASSERT_EQ(pbb->buffer, nullptr);
+    ASSERT_EQ(pbb->segment_count, 1);
+    ASSERT_EQ(pbb->segment_shift, 5);
+    ASSERT_EQ(pbb->capacity, 32);
+    ASSERT_EQ(pbb->write_pos, 0);
+    ASSERT_EQ(pbb->read_pos, 0);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, CreateSegmented_InvalidSize_NothingAllocated) {
+    ASSERT_EQ(pbb_create_segmented(0), nullptr);
+    ASSERT_EQ(pbb_create_segmented(((size_t)1 << 30) + 1), nullptr);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, WriteByte_PastFirstSegment_SegmentsAddedWithoutMovingData) {
+    pbb = pbb_create_segmented(16);
+    uint8_t* first = pbb->segments[0];
+
+    for (int i = 0; i < 40; ++i) {
+        pbb_write_byte(pbb, (uint8_t)i, 8);
+    }
+
+    ASSERT_EQ(pbb->segment_count, 3);
+    ASSERT_EQ(pbb->capacity, 48);
+    ASSERT_EQ(pbb->segments[0], first);
+    ASSERT_EQ(pbb->segments[1][0], 16);
+    ASSERT_EQ(pbb->segments[2][7], 39);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, WriteInt64_AcrossSegmentBoundary_BytesSplitBetweenSegments) {
+    pbb = pbb_create_segmented(16);
+
+    pbb_write_int64(pbb, 0, 64);
+    pbb_write_int64(pbb, 0, 36);
+    pbb_write_int64(pbb, (int64_t)0x0123456789ABCDEF, 64);
+    pbb_write_byte(pbb, 0x5, 4);
+
+    ASSERT_EQ(pbb->segments[0][12], 0x00);
+    ASSERT_EQ(pbb->segments[0][13], 0x12);
+    ASSERT_EQ(pbb->segments[0][15], 0x56);
+    ASSERT_EQ(pbb->segments[1][0], 0x78);
+    ASSERT_EQ(pbb->segments[1][4], 0xF5);
+
+    pbb_read_int64(pbb, 64);
+    pbb_read_int64(pbb, 36);
+    ASSERT_EQ(pbb_read_int64(pbb, 64), (int64_t)0x0123456789ABCDEF);
+    ASSERT_EQ(pbb_read_byte(pbb, 4), 0x5);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, WriteRead_RandomWidths_SameBytesAsContiguousBuffer) {
+    pbb = pbb_create_segmented(16);
+    reference = pbb_create(1);
+    std::vector<uint8_t> widths;
+    std::vector<int64_t> values;
+
+    srand(8);
+    for (int i = 0; i < 500; ++i) {
+        uint8_t bits = (uint8_t)(rand() % 64 + 1);
+        int64_t value = (int64_t)(((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^ (uint64_t)rand());
+        value = (int64_t)((uint64_t)value << (64 - bits)) >> (64 - bits);
+        widths.push_back(bits);
+        values.push_back(value);
+        pbb_write_int64(pbb, value, bits);
+        pbb_write_int64(reference, value, bits);
+    }
+
+    size_t length = pbb_get_length(pbb);
+    ASSERT_EQ(length, pbb_get_length(reference));
+    std::vector<uint8_t> exported(length);
+    ASSERT_EQ(pbb_export(pbb, exported.data(), length), length);
+    ASSERT_EQ(memcmp(exported.data(), reference->buffer, length), 0);
+
+    for (size_t i = 0; i < widths.size(); ++i) {
+        ASSERT_EQ(pbb_read_int64(pbb, widths[i]), values[i]) << "value " << i;
+    }
+    ASSERT_EQ(pbb->read_pos, pbb->write_pos);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, Int32Array_AcrossManySegments_SameAsSingleCalls) {
+    pbb = pbb_create_segmented(16);
+    reference = pbb_create(1);
+    const size_t count = 300;
+    int32_t values[count];
+
+    srand(9);
+    for (uint8_t bits = 1; bits <= 32; bits += 5) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = (int32_t)((uint32_t)rand() << (32 - bits)) >> (32 - bits);
+            pbb_write_int(reference, values[i], bits);
+        }
+        pbb_write_int32_array(pbb, values, count, bits);
+    }
+
+    size_t length = pbb_get_length(pbb);
+    ASSERT_EQ(length, pbb_get_length(reference));
+    std::vector<uint8_t> exported(length);
+    pbb_export(pbb, exported.data(), length);
+    ASSERT_EQ(memcmp(exported.data(), reference->buffer, length), 0);
+
+    int32_t decoded[count];
+    for (uint8_t bits = 1; bits <= 32; bits += 5) {
+        ASSERT_EQ(pbb_read_int32_array(pbb, decoded, count, bits), count);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(decoded[i], pbb_read_int(reference, bits)) << "bits " << (int)bits << " value " << i;
+        }
+    }
+}
+
+TEST_F(PartialByteBufferSegmentedTest, Int64Array_AcrossManySegments_SameAsSingleCalls) {
+    pbb = pbb_create_segmented(16);
+    reference = pbb_create(1);
+    const size_t count = 200;
+    int64_t values[count];
+
+    srand(10);
+    for (uint8_t bits = 3; bits <= 64; bits += 7) {
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t random = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+            values[i] = (int64_t)(random << (64 - bits)) >> (64 - bits);
+            pbb_write_int64(reference, values[i], bits);
+        }
+        pbb_write_int64_array(pbb, values, count, bits);
+    }
+
+    int64_t decoded[count];
+    for (uint8_t bits = 3; bits <= 64; bits += 7) {
+        ASSERT_EQ(pbb_read_int64_array(pbb, decoded, count, bits), count);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(decoded[i], pbb_read_int64(reference, bits)) << "bits " << (int)bits << " value " << i;
+        }
+    }
+}
+
+TEST_F(PartialByteBufferSegmentedTest, Export_SmallerDestination_TruncatedCopy) {
+    pbb = pbb_create_segmented(16);
+    for (int i = 0; i < 20; ++i) {
+        pbb_write_byte(pbb, (uint8_t)(0xA0 + i), 8);
+    }
+    uint8_t exported[18] = {0};
+
+    ASSERT_EQ(pbb_export(pbb, exported, sizeof(exported)), sizeof(exported));
+    ASSERT_EQ(exported[0], 0xA0);
+    ASSERT_EQ(exported[15], 0xAF);
+    ASSERT_EQ(exported[17], 0xB1);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, Flatten_SegmentedData_ContiguousOwnedBuffer) {
+    pbb = pbb_create_segmented(16);
+    for (int i = 0; i < 40; ++i) {
+        pbb_write_byte(pbb, (uint8_t)i, 8);
+    }
+
+    ASSERT_EQ(pbb_flatten(pbb), 1);
+
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_OWNED);
+    ASSERT_EQ(pbb->segments, nullptr);
+    ASSERT_EQ(pbb->segment_count, 0);
+    ASSERT_EQ(pbb->capacity, 48);
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_EQ(pbb->buffer[i], i);
+    }
+
+    pbb_write_int(pbb, 0x1234, 16);
+    ASSERT_EQ(pbb->buffer[40], 0x12);
+    ASSERT_EQ(pbb->buffer[41], 0x34);
+}
+
+TEST_F(PartialByteBufferSegmentedTest, Flatten_ContiguousBuffer_Unchanged) {
+    pbb = pbb_create(4);
+    uint8_t* buffer = pbb->buffer;
+
+    ASSERT_EQ(pbb_flatten(pbb), 1);
+    ASSERT_EQ(pbb->buffer, buffer);
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class PartialByteBufferUnsignedTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        pbb_kernel initial_kernel;
+
+        void SetUp() override {
+            initial_kernel = pbb_get_kernel();
+        }
+
+        void TearDown() override {
+            pbb_set_kernel(initial_kernel);
+            pbb_destroy(&pbb);
+        }
+
+        std::vector<pbb_kernel> supportedKernels() {
+            std::vector<pbb_kernel> kernels;
+            for (int kernel = PBB_KERNEL_SCALAR; kernel < PBB_KERNEL_COUNT; ++kernel) {
+                if (pbb_set_kernel((pbb_kernel)kernel)) kernels.push_back((pbb_kernel)kernel);
+            }
+            pbb_set_kernel(initial_kernel);
+            return kernels;
+        }
+
+        static uint64_t random64() {
+            return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+        }
+
+        /**
+         * Altitudes in meters with 2 decimal places, none below zero.
+         */
+        static std::vector<double> altitudes(size_t count) {
+            std::vector<double> values = {0.0, 8848.86, 0.01};
+            srand(22);
+            while (values.size() < count) {
+                values.push_back((rand() % 900000) / 100.0);
+            }
+            return values;
+        }
+};
+
+TEST_F(PartialByteBufferUnsignedTest, ReadUint32_TopBitSet_NoSignExtension) {
+    pbb = pbb_create(8);
+    pbb_write_uint32(pbb, 0x5, 3);
+    pbb_write_uint32(pbb, 0xFFFFFFFF, 32);
+    pbb_write_uint32(pbb, 0x1FF, 9);
+
+    ASSERT_EQ(pbb->write_pos, 44);
+    ASSERT_EQ(pbb_read_uint32(pbb, 3), 5u);
+    ASSERT_EQ(pbb_read_uint32(pbb, 32), 0xFFFFFFFFu);
+    ASSERT_EQ(pbb_read_uint32(pbb, 9), 0x1FFu);
+    ASSERT_EQ(pbb_read_uint32(pbb, 1), 0u);
+}
+
+TEST_F(PartialByteBufferUnsignedTest, ReadUint64_TopBitSet_NoSignExtension) {
+    pbb = pbb_create(8);
+    pbb_write_uint64(pbb, 0xFEDCBA9876543210, 64);
+    pbb_write_uint64(pbb, 0x7FFFFFFFFFFFFFFF, 63);
+    pbb_write_uint64(pbb, 0xB, 4);
+
+    ASSERT_EQ(pbb_read_uint64(pbb, 64), 0xFEDCBA9876543210u);
+    ASSERT_EQ(pbb_read_uint64(pbb, 63), 0x7FFFFFFFFFFFFFFFu);
+    ASSERT_EQ(pbb_read_uint64(pbb, 4), 0xBu);
+    ASSERT_EQ(pbb_read_uint64(pbb, 65), 0u);
+}
+
+TEST_F(PartialByteBufferUnsignedTest, ReadUintArrays_AllKernels_SameAsMaskedSignedReads) {
+    const uint8_t widths[] = {1, 7, 13, 25, 31, 32};
+    const uint8_t widths64[] = {1, 17, 40, 57, 63, 64};
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        for (int w = 0; w < 6; ++w) {
+            std::vector<uint32_t> values(203);
+            std::vector<uint64_t> values64(203);
+            srand(w);
+            for (size_t i = 0; i < values.size(); ++i) {
+                values[i] = (uint32_t)random64();
+                values64[i] = random64() << 1 | (uint64_t)(rand() & 1);
+            }
+
+            pbb = pbb_create(4);
+            pbb_write_byte(pbb, 0x1, 5);
+            ASSERT_EQ(pbb_write_uint32_array(pbb, values.data(), values.size(), widths[w]), values.size());
+            ASSERT_EQ(pbb_write_uint64_array(pbb, values64.data(), values64.size(), widths64[w]), values64.size());
+            pbb_read_byte(pbb, 5);
+
+            std::vector<uint32_t> read(values.size());
+            std::vector<uint64_t> read64(values64.size());
+            ASSERT_EQ(pbb_read_uint32_array(pbb, read.data(), read.size(), widths[w]), read.size());
+            ASSERT_EQ(pbb_read_uint64_array(pbb, read64.data(), read64.size(), widths64[w]), read64.size());
+            uint32_t mask = (uint32_t)(((uint64_t)1 << widths[w]) - 1);
+            uint64_t mask64 = (uint64_t)-1 >> (64 - widths64[w]);
+            for (size_t i = 0; i < values.size(); ++i) {
+                ASSERT_EQ(read[i], values[i] & mask) << pbb_get_kernel_name() << " bits " << (int)widths[w] << " value " << i;
+                ASSERT_EQ(read64[i], values64[i] & mask64) << pbb_get_kernel_name() << " bits " << (int)widths64[w] << " value " << i;
+            }
+            pbb_destroy(&pbb);
+        }
+    }
+}
+
+TEST_F(PartialByteBufferUnsignedTest, ReadUint32Array_Segmented_NoSignExtension) {
+    pbb = pbb_create_segmented(16);
+    std::vector<uint32_t> values(300);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = (uint32_t)(i * 2654435761u) & 0x7FF;
+
+    ASSERT_EQ(pbb_write_uint32_array(pbb, values.data(), values.size(), 11), values.size());
+    std::vector<uint32_t> read(values.size());
+    ASSERT_EQ(pbb_read_uint32_array(pbb, read.data(), read.size(), 11), values.size());
+    ASSERT_EQ(read, values);
+}
+
+TEST_F(PartialByteBufferUnsignedTest, FormatInitSigns_UnsignedFormats_SignDroppedOrZero) {
+    flr_format to_unsigned = {};
+    flr_format from_unsigned = {};
+    flr_format to_signed = {};
+    ASSERT_EQ(flr_format_init_signs(&to_unsigned, 11, 52, 1, 5, 17, 0), 1);
+    ASSERT_EQ(flr_format_init_signs(&from_unsigned, 5, 17, 0, 11, 52, 1), 1);
+    ASSERT_EQ(flr_format_init(&to_signed, 11, 52, 5, 17), 1);
+
+    for (double value : altitudes(500)) {
+        uint64_t resized = flr_resize_double(&to_unsigned, value);
+        ASSERT_EQ(resized, flr_resize_double(&to_signed, value));
+        ASSERT_EQ(flr_resize_double(&to_unsigned, -value), resized);
+
+        qword q;
+        q.uint64_val = flr_resize(&from_unsigned, resized);
+        ASSERT_EQ(q.uint64_val, flr_resize_float_long(resized, 5, 17, 11, 52));
+    }
+    ASSERT_EQ(flr_resize(&from_unsigned, (uint64_t)1 << 22), flr_resize(&from_unsigned, 0));
+}
+
+TEST_F(PartialByteBufferUnsignedTest, ResizeArray_UnsignedFormats_AllKernelsSameAsResize) {
+    flr_format format = {};
+    ASSERT_EQ(flr_format_init_signs(&format, 11, 52, 1, 6, 20, 0), 1);
+    std::vector<double> values = altitudes(301);
+    for (size_t i = 0; i < values.size(); i += 3) values[i] = -values[i];
+    std::vector<uint64_t> resized(values.size());
+
+    for (pbb_kernel kernel : supportedKernels()) {
+        pbb_set_kernel(kernel);
+        flr_resize_array_double(&format, values.data(), resized.data(), values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(resized[i], flr_resize_double(&format, values[i])) << pbb_get_kernel_name() << " value " << i;
+            ASSERT_LT(resized[i], (uint64_t)1 << 26);
+        }
+    }
+}
+
+TEST_F(PartialByteBufferUnsignedTest, WriteUnsignedDoubleAs_Altitudes_OneBitLessSameValues) {
+    pbb = pbb_create(8);
+    partial_byte_buffer* signed_pbb = pbb_create(8);
+    std::vector<double> values = altitudes(1000);
+
+    for (double value : values) {
+        pbb_write_unsigned_double_as(pbb, value, 5, 21);
+        pbb_write_double_as(signed_pbb, value, 5, 21);
+    }
+    ASSERT_EQ(pbb->write_pos, 26 * values.size());
+    ASSERT_EQ(signed_pbb->write_pos, 27 * values.size());
+
+    for (double value : values) {
+        double read = pbb_read_unsigned_double_as(pbb, 5, 21);
+        ASSERT_EQ(read, pbb_read_double_as(signed_pbb, 5, 21));
+        ASSERT_NEAR(read, value, 0.005);
+    }
+    pbb_destroy(&signed_pbb);
+
+    pbb_write_unsigned_double_as(pbb, -12.5, 5, 21);
+    ASSERT_EQ(pbb_read_unsigned_double_as(pbb, 5, 21), 12.5);
+}
+
+TEST_F(PartialByteBufferUnsignedTest, WriteUnsignedDoubleArrayAs_Segmented_SameAsPerValue) {
+    pbb = pbb_create_segmented(32);
+    partial_byte_buffer* expected = pbb_create(1);
+    std::vector<double> values = altitudes(777);
+
+    ASSERT_EQ(pbb_write_unsigned_double_array_as(pbb, values.data(), values.size(), 5, 21), values.size());
+    for (double value : values) pbb_write_unsigned_double_as(expected, value, 5, 21);
+
+    std::vector<uint8_t> exported(pbb_get_length(pbb));
+    ASSERT_EQ(pbb_export(pbb, exported.data(), exported.size()), pbb_get_length(expected));
+    ASSERT_EQ(memcmp(exported.data(), expected->buffer, exported.size()), 0);
+
+    std::vector<double> read(values.size() + 3);
+    ASSERT_EQ(pbb_read_unsigned_double_array_as(pbb, read.data(), read.size(), 5, 21), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(read[i], pbb_read_unsigned_double_as(expected, 5, 21)) << "value " << i;
+    }
+    pbb_destroy(&expected);
+}
+
+TEST_F(PartialByteBufferUnsignedTest, WriteUnsignedDoubleAs_EmptyFormat_NothingWritten) {
+    pbb = pbb_create(8);
+    double values[1] = {1.0};
+
+    pbb_write_unsigned_double_as(pbb, 1.0, 0, 0);
+    ASSERT_EQ(pbb_write_unsigned_double_array_as(pbb, values, 1, 0, 0), 0);
+    ASSERT_EQ(pbb->write_pos, 0);
+}
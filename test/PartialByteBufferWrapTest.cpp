@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class PartialByteBufferWrapTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+        }
+};
+
+TEST_F(PartialByteBufferWrapTest, WrapArray_FewElements_SharesMemoryAndCorrectCursors) {
+    uint8_t array[] = {0x12, 0x34, 0x56, 0x78};
+    pbb = pbb_wrap_array(array, 4);
+
+    ASSERT_NE(pbb, nullptr);
+    ASSERT_EQ(pbb->buffer, array);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_BORROWED);
+    ASSERT_EQ(pbb->capacity, 4);
+    ASSERT_EQ(pbb->write_pos, 32);
+    ASSERT_EQ(pbb->read_pos, 0);
+    ASSERT_EQ(pbb_get_length(pbb), 4);
+}
+
+TEST_F(PartialByteBufferWrapTest, WrapArray_InvalidParameters_NothingAllocated) {
+    uint8_t array[] = {0x12};
+
+    ASSERT_EQ(pbb_wrap_array(nullptr, 4), nullptr);
+    ASSERT_EQ(pbb_wrap_array(array, 0), nullptr);
+}
+
+TEST_F(PartialByteBufferWrapTest, Destroy_BorrowedArray_ArrayNotFreed) {
+    uint8_t* array = new uint8_t[3]{0xAA, 0xBB, 0xCC};
+    pbb = pbb_wrap_array(array, 3);
+
+    pbb_destroy(&pbb);
+
+    ASSERT_EQ(pbb, nullptr);
+    ASSERT_EQ(array[2], 0xCC);
+    delete[] array;
+}
+
+TEST_F(PartialByteBufferWrapTest, ReadInt64_UpToLastByteOfExactSizeArray_CorrectValues) {
+    // Heap array of the exact size, so that any load past its end is reported by sanitizers
+    const size_t size = 11;
+    uint8_t* array = new uint8_t[size]{0xA0, 0x24, 0x68, 0xAC, 0xF1, 0x35, 0x79, 0xBD, 0xE1, 0x23, 0x45};
+    pbb = pbb_wrap_array(array, size);
+
+    ASSERT_EQ(pbb_read_int64(pbb, 3), -3);
+    ASSERT_EQ(pbb_read_int64(pbb, 64), (int64_t)0x0123456789ABCDEF);
+    ASSERT_EQ(pbb_read_byte(pbb, 5), 1);
+    ASSERT_EQ(pbb_read_int(pbb, 16), 0x2345);
+    ASSERT_EQ(pbb->read_pos, 88);
+    ASSERT_EQ(pbb_read_byte(pbb, 1), 0);
+
+    pbb_destroy(&pbb);
+    delete[] array;
+}
+
+TEST_F(PartialByteBufferWrapTest, ReadArrays_ExactSizeArray_SameAsOwnedCopy) {
+    std::vector<uint8_t> data(37);
+    srand(606);
+    for (auto& byte : data) byte = (uint8_t)rand();
+
+    for (uint8_t bits = 1; bits <= 64; ++bits) {
+        uint8_t* array = new uint8_t[data.size()];
+        memcpy(array, data.data(), data.size());
+        pbb = pbb_wrap_array(array, data.size());
+        partial_byte_buffer* copy = pbb_from_array(data.data(), data.size());
+
+        size_t count = data.size() * 8 / bits;
+        std::vector<int64_t> actual(count), expected(count);
+        ASSERT_EQ(pbb_read_int64_array(pbb, actual.data(), count, bits), count);
+        ASSERT_EQ(pbb_read_int64_array(copy, expected.data(), count, bits), count);
+        ASSERT_EQ(actual, expected) << "bits = " << (int)bits;
+
+        if (bits <= 32) {
+            std::vector<int32_t> actual32(count), expected32(count);
+            pbb->read_pos = 0;
+            copy->read_pos = 0;
+            ASSERT_EQ(pbb_read_int32_array(pbb, actual32.data(), count, bits), count);
+            ASSERT_EQ(pbb_read_int32_array(copy, expected32.data(), count, bits), count);
+            ASSERT_EQ(actual32, expected32) << "bits = " << (int)bits;
+        }
+
+        pbb_destroy(&copy);
+        pbb_destroy(&pbb);
+        delete[] array;
+    }
+}
+
+TEST_F(PartialByteBufferWrapTest, WriteByte_BorrowedArray_CopiesBeforeWriting) {
+    uint8_t array[] = {0x12, 0x34};
+    pbb = pbb_wrap_array(array, 2);
+    pbb_growth_policy policy = {PBB_GROWTH_DOUBLE, 0, 0, nullptr, nullptr};
+    pbb_set_growth_policy(pbb, &policy);
+    pbb_read_byte(pbb, 4);
+
+    pbb_write_byte(pbb, 0b101, 3);
+
+    ASSERT_NE(pbb->buffer, array);
+    ASSERT_EQ(pbb->storage, PBB_STORAGE_OWNED);
+    ASSERT_EQ(array[0], 0x12);
+    ASSERT_EQ(array[1], 0x34);
+    ASSERT_EQ(pbb->buffer[0], 0x12);
+    ASSERT_EQ(pbb->buffer[1], 0x34);
+    ASSERT_EQ(pbb->buffer[2], 0b10100000);
+    ASSERT_EQ(pbb->write_pos, 19);
+    ASSERT_EQ(pbb->read_pos, 4);
+    ASSERT_EQ(pbb->capacity, 4);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class PartialByteBufferWriteArrayTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *expected = nullptr;
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            pbb_destroy(&expected);
+        }
+};
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteInt32Array_FewValues_CorrectBufferValues) {
+    pbb = pbb_create(4);
+    int32_t values[] = {0b101, 0b010, 0b111, 0b001, 0b110};
+
+    pbb_write_int32_array(pbb, values, 5, 3);
+
+    ASSERT_EQ(pbb->buffer[0], 0b10101011);
+    ASSERT_EQ(pbb->buffer[1], 0b10011100);
+    ASSERT_EQ(pbb->write_pos, 15);
+    ASSERT_EQ(pbb->capacity, 4);
+}
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteInt32Array_AfterPartialByte_KeepsExistingBits) {
+    pbb = pbb_create(8);
+    int32_t values[] = {0x12345, -1};
+
+    pbb_write_byte(pbb, 0b11, 2);
+    pbb_write_int32_array(pbb, values, 2, 20);
+
+    ASSERT_EQ(pbb->buffer[0], 0b11000100);
+    ASSERT_EQ(pbb->buffer[1], 0b10001101);
+    ASSERT_EQ(pbb->buffer[2], 0b00010111);
+    ASSERT_EQ(pbb->buffer[3], 0xFF);
+    ASSERT_EQ(pbb->buffer[4], 0xFF);
+    ASSERT_EQ(pbb->buffer[5], 0b11000000);
+    ASSERT_EQ(pbb->write_pos, 42);
+}
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteInt32Array_AllWidths_SameAsSingleWrites) {
+    const int total_values = 257;
+    int32_t values[total_values];
+    srand(12345);
+    for (int i = 0; i < total_values; ++i) {
+        values[i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+    }
+
+    for (uint8_t bits = 1; bits <= 32; ++bits) {
+        pbb = pbb_create(1);
+        expected = pbb_create(1);
+        pbb_write_byte(pbb, 0b1011, bits % 8 + 1);
+        pbb_write_byte(expected, 0b1011, bits % 8 + 1);
+
+        pbb_write_int32_array(pbb, values, total_values, bits);
+        for (int i = 0; i < total_values; ++i) {
+            pbb_write_int32(expected, values[i], bits);
+        }
+
+        ASSERT_EQ(pbb->write_pos, expected->write_pos) << "bits = " << (int)bits;
+        for (size_t i = 0; i < pbb_get_length(expected); ++i) {
+            ASSERT_EQ(pbb->buffer[i], expected->buffer[i]) << "bits = " << (int)bits << ", byte " << i;
+        }
+        pbb_destroy(&pbb);
+        pbb_destroy(&expected);
+    }
+}
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteInt64Array_AllWidths_SameAsSingleWrites) {
+    const int total_values = 129;
+    int64_t values[total_values];
+    srand(54321);
+    for (int i = 0; i < total_values; ++i) {
+        values[i] = (int64_t)(((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand());
+    }
+
+    for (uint8_t bits = 1; bits <= 64; ++bits) {
+        pbb = pbb_create(3);
+        expected = pbb_create(3);
+        pbb_write_byte(pbb, 0b0110, bits % 8 + 1);
+        pbb_write_byte(expected, 0b0110, bits % 8 + 1);
+
+        pbb_write_int64_array(pbb, values, total_values, bits);
+        for (int i = 0; i < total_values; ++i) {
+            pbb_write_int64(expected, values[i], bits);
+        }
+
+        ASSERT_EQ(pbb->write_pos, expected->write_pos) << "bits = " << (int)bits;
+        for (size_t i = 0; i < pbb_get_length(expected); ++i) {
+            ASSERT_EQ(pbb->buffer[i], expected->buffer[i]) << "bits = " << (int)bits << ", byte " << i;
+        }
+        pbb_destroy(&pbb);
+        pbb_destroy(&expected);
+    }
+}
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteInt64Array_ExceedCapacity_GrowsOnce) {
+    pbb = pbb_create(2);
+    pbb_growth_policy policy = {PBB_GROWTH_DOUBLE, 0, 0, nullptr, nullptr};
+    pbb_set_growth_policy(pbb, &policy);
+    int64_t values[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    pbb_write_int64_array(pbb, values, 8, 16);
+
+    ASSERT_EQ(pbb->write_pos, 128);
+    ASSERT_EQ(pbb->capacity, 32);
+    ASSERT_EQ(pbb->buffer[14], 0x00);
+    ASSERT_EQ(pbb->buffer[15], 0x08);
+}
+
+TEST_F(PartialByteBufferWriteArrayTest, WriteArray_InvalidArguments_DoesNothing) {
+    pbb = pbb_create(4);
+    int32_t values32[] = {1, 2};
+    int64_t values64[] = {1, 2};
+
+    pbb_write_int32_array(nullptr, values32, 2, 8);
+    pbb_write_int32_array(pbb, nullptr, 2, 8);
+    pbb_write_int32_array(pbb, values32, 2, 0);
+    pbb_write_int32_array(pbb, values32, 2, 33);
+    pbb_write_int64_array(pbb, values64, 2, 65);
+    pbb_write_int64_array(pbb, values64, 0, 8);
+
+    ASSERT_EQ(pbb->write_pos, 0);
+    ASSERT_EQ(pbb->buffer[0], 0);
+    ASSERT_EQ(pbb->capacity, 4);
+}
@@ -80,6 +80,26 @@ TEST_F(PartialByteBufferWriteInt64Test, WriteInt64_PartialInt64_Above32Bits_Corr
     ASSERT_EQ(pbb->write_pos, 41);
 }
 
+TEST_F(PartialByteBufferWriteInt64Test, WriteInt64_FullInt64AfterPartialByte_SpansNineBytes) {
+    pbb = pbb_create(9);
+
+    pbb_write_byte(pbb, 0b101, 3);
+    pbb_write_int64(pbb, 0x0123456789ABCDEF, 64);
+
+    // 101 followed by 0000 0001 0010 0011 ... 1110 1111
+    ASSERT_EQ(pbb->buffer[0], 0xA0);
+    ASSERT_EQ(pbb->buffer[1], 0x24);
+    ASSERT_EQ(pbb->buffer[2], 0x68);
+    ASSERT_EQ(pbb->buffer[3], 0xAC);
+    ASSERT_EQ(pbb->buffer[4], 0xF1);
+    ASSERT_EQ(pbb->buffer[5], 0x35);
+    ASSERT_EQ(pbb->buffer[6], 0x79);
+    ASSERT_EQ(pbb->buffer[7], 0xBD);
+    ASSERT_EQ(pbb->buffer[8], 0xE0);
+    ASSERT_EQ(pbb->write_pos, 67);
+    ASSERT_EQ(pbb->capacity, 9);
+}
+
 TEST_F(PartialByteBufferWriteInt64Test, WriteInt64_NullBuffer_DoNothing) {
     partial_byte_buffer* pbb_ptr = nullptr;
     pbb_write_int64(pbb_ptr, 0x123456789ABCDEF0, 64);
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+class PartialByteBufferWriterTest : public ::testing::Test {
+    protected:
+        partial_byte_buffer *pbb = nullptr;
+        partial_byte_buffer *reference = nullptr;
+        std::vector<uint8_t> sunk;
+        int calls = 0;
+        bool failing = false;
+
+        void TearDown() override {
+            pbb_destroy(&pbb);
+            pbb_destroy(&reference);
+        }
+
+        static int collect(const uint8_t* data, size_t size, void* context) {
+            PartialByteBufferWriterTest* test = (PartialByteBufferWriterTest*)context;
+            ++test->calls;
+            if (test->failing) return 0;
+            test->sunk.insert(test->sunk.end(), data, data + size);
+            return 1;
+        }
+};
+
+TEST_F(PartialByteBufferWriterTest, CreateWriter_InvalidParameters_NothingAllocated) {
+    ASSERT_EQ(pbb_create_writer(0, collect, this), nullptr);
+    ASSERT_EQ(pbb_create_writer(16, nullptr, this), nullptr);
+    ASSERT_EQ(pbb_create_fd_writer(-1, 16), nullptr);
+    ASSERT_EQ(pbb_create_file_writer(nullptr, 16), nullptr);
+}
+
+TEST_F(PartialByteBufferWriterTest, WriteByte_WatermarkCrossed_CompleteBytesFlushedBeforeNextWrite) {
+    pbb = pbb_create_writer(4, collect, this);
+
+    for (int i = 0; i < 4; ++i) {
+        pbb_write_byte(pbb, (int8_t)(0x11 * (i + 1)), 8);
+    }
+    ASSERT_EQ(calls, 0);
+
+    pbb_write_byte(pbb, 0x5, 4);
+    pbb_write_byte(pbb, 0x3, 3);
+
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0x11, 0x22, 0x33, 0x44}));
+    ASSERT_EQ(pbb->flushed, 4);
+    ASSERT_EQ(pbb->write_pos, 7);
+    ASSERT_EQ(pbb->buffer[0], 0x56);
+    ASSERT_EQ(pbb->buffer[1], 0x00);
+}
+
+TEST_F(PartialByteBufferWriterTest, Finish_PartialLastByte_PaddedAndFlushed) {
+    pbb = pbb_create_writer(16, collect, this);
+    pbb_write_int(pbb, 0x1234, 16);
+    pbb_write_byte(pbb, 0x5, 3);
+
+    ASSERT_EQ(pbb_flush(pbb), 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0x12, 0x34}));
+    ASSERT_EQ(pbb->write_pos, 3);
+
+    ASSERT_EQ(pbb_finish(pbb), 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0x12, 0x34, 0xA0}));
+    ASSERT_EQ(pbb->write_pos, 0);
+    ASSERT_EQ(pbb->flushed, 3);
+}
+
+TEST_F(PartialByteBufferWriterTest, Flush_SinkFails_DataKeptUntilNextSuccess) {
+    pbb = pbb_create_writer(2, collect, this);
+    failing = true;
+
+    for (int i = 0; i < 6; ++i) {
+        pbb_write_byte(pbb, (int8_t)(i + 1), 8);
+    }
+    ASSERT_EQ(pbb_flush(pbb), 0);
+    ASSERT_EQ(pbb->write_pos, 48);
+    ASSERT_TRUE(sunk.empty());
+
+    failing = false;
+    ASSERT_EQ(pbb_flush(pbb), 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({1, 2, 3, 4, 5, 6}));
+}
+
+TEST_F(PartialByteBufferWriterTest, WriteInt64_LongRandomStream_SameBytesAsBufferAndBoundedMemory) {
+    pbb = pbb_create_writer(64, collect, this);
+    reference = pbb_create(1);
+    int32_t values[40];
+
+    srand(12);
+    for (int i = 0; i < 20000; ++i) {
+        uint8_t bits = (uint8_t)(rand() % 64 + 1);
+        int64_t value = (int64_t)(((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand());
+        if (i % 100 == 0) {
+            // Mix in array writes, packed by the kernels
+            uint8_t array_bits = (uint8_t)(bits % 32 + 1);
+            for (int j = 0; j < 40; ++j) values[j] = rand();
+            pbb_write_int32_array(pbb, values, 40, array_bits);
+            pbb_write_int32_array(reference, values, 40, array_bits);
+        }
+        pbb_write_int64(pbb, value, bits);
+        pbb_write_int64(reference, value, bits);
+    }
+    ASSERT_EQ(pbb_finish(pbb), 1);
+
+    // Watermark plus the largest write, grown by at most one doubling
+    ASSERT_LE(pbb->capacity, 2 * (64 + 40 * 4 + 16));
+    ASSERT_EQ(sunk.size(), pbb_get_length(reference));
+    ASSERT_EQ(memcmp(sunk.data(), reference->buffer, sunk.size()), 0);
+}
+
+TEST_F(PartialByteBufferWriterTest, WriteIntArrays_LargeArrays_SameBytesAsBufferAndBoundedMemory) {
+    pbb = pbb_create_writer(64, collect, this);
+    reference = pbb_create(1);
+    size_t capacity = pbb->capacity;
+    std::vector<int32_t> values32(1 << 20);
+    std::vector<int64_t> values64(1 << 18);
+    srand(21);
+    for (int32_t& value : values32) value = rand();
+    for (int64_t& value : values64) value = (int64_t)(((uint64_t)rand() << 40) ^ (uint64_t)rand());
+
+    pbb_write_byte(pbb, 0x5, 3);
+    pbb_write_byte(reference, 0x5, 3);
+    ASSERT_EQ(pbb_write_int32_array(pbb, values32.data(), values32.size(), 32), values32.size());
+    ASSERT_EQ(pbb_write_int32_array(reference, values32.data(), values32.size(), 32), values32.size());
+    ASSERT_EQ(pbb->capacity, capacity);
+    ASSERT_EQ(pbb_write_int64_array(pbb, values64.data(), values64.size(), 61), values64.size());
+    ASSERT_EQ(pbb_write_int64_array(reference, values64.data(), values64.size(), 61), values64.size());
+    ASSERT_EQ(pbb->capacity, capacity);
+    ASSERT_LE(pbb->write_pos >> 3, capacity);
+
+    ASSERT_EQ(pbb_finish(pbb), 1);
+    ASSERT_EQ(sunk.size(), pbb_get_length(reference));
+    ASSERT_EQ(memcmp(sunk.data(), reference->buffer, sunk.size()), 0);
+}
+
+TEST_F(PartialByteBufferWriterTest, CreateFileWriter_TemporaryFile_BytesWritten) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    pbb = pbb_create_file_writer(file, 8);
+
+    for (int i = 0; i < 20; ++i) {
+        pbb_write_byte(pbb, (int8_t)i, 8);
+    }
+    pbb_write_byte(pbb, 0x1, 1);
+    ASSERT_EQ(pbb_finish(pbb), 1);
+
+    uint8_t read_back[32] = {0};
+    rewind(file);
+    ASSERT_EQ(fread(read_back, 1, sizeof(read_back), file), 21);
+    ASSERT_EQ(read_back[19], 19);
+    ASSERT_EQ(read_back[20], 0x80);
+    fclose(file);
+}
+
+TEST_F(PartialByteBufferWriterTest, CreateFdWriter_Pipe_BytesWritten) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pbb = pbb_create_fd_writer(fds[1], 4);
+
+    pbb_write_int64(pbb, 0x0123456789ABCDEF, 64);
+    pbb_write_int(pbb, 0x0FED, 12);
+    ASSERT_EQ(pbb_finish(pbb), 1);
+    close(fds[1]);
+
+    uint8_t read_back[16] = {0};
+    ASSERT_EQ(read(fds[0], read_back, sizeof(read_back)), 10);
+    ASSERT_EQ(read_back[0], 0x01);
+    ASSERT_EQ(read_back[7], 0xEF);
+    ASSERT_EQ(read_back[8], 0xFE);
+    ASSERT_EQ(read_back[9], 0xD0);
+    close(fds[0]);
+}
@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+
+#include "partial_byte_buffer.h"
+#include "pbb_pipeline.h"
+#include <chrono>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+class PbbPipelineTest : public ::testing::Test {
+    protected:
+        pbb_pipeline *pipeline = nullptr;
+        partial_byte_buffer *reference = nullptr;
+        std::vector<uint8_t> sunk;
+        int calls = 0;
+        int fail_after = -1;
+        int delay_ms = 0;
+
+        void TearDown() override {
+            pbb_pipeline_destroy(&pipeline);
+            pbb_destroy(&reference);
+        }
+
+        static int collect(const uint8_t* data, size_t size, void* context) {
+            PbbPipelineTest* test = (PbbPipelineTest*)context;
+            if (test->delay_ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(test->delay_ms));
+            }
+            if (test->calls++ == test->fail_after) return 0;
+            test->sunk.insert(test->sunk.end(), data, data + size);
+            return 1;
+        }
+
+        /**
+         * Encode a deterministic stream of fields through the pipeline and into [reference].
+         */
+        void encode(int count) {
+            reference = pbb_create(1);
+            srand(14);
+            for (int i = 0; i < count; ++i) {
+                uint8_t bits = (uint8_t)(rand() % 64 + 1);
+                int64_t value = (int64_t)(((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand());
+                partial_byte_buffer* pbb = pbb_pipeline_buffer(pipeline);
+                ASSERT_NE(pbb, nullptr);
+                pbb_write_int64(pbb, value, bits);
+                pbb_write_int64(reference, value, bits);
+            }
+        }
+};
+
+TEST_F(PbbPipelineTest, Create_InvalidParameters_NothingAllocated) {
+    ASSERT_EQ(pbb_pipeline_create(0, 64, collect, this), nullptr);
+    ASSERT_EQ(pbb_pipeline_create(2, 0, collect, this), nullptr);
+    ASSERT_EQ(pbb_pipeline_create(2, 64, nullptr, this), nullptr);
+    ASSERT_EQ(pbb_pipeline_create_fd(-1, 2, 64), nullptr);
+}
+
+TEST_F(PbbPipelineTest, Submit_SingleBuffer_BlockingWithPartialByteCarried) {
+    pipeline = pbb_pipeline_create(1, 64, collect, this);
+    ASSERT_EQ(pbb_pipeline_get_backend(pipeline), PBB_PIPELINE_BLOCKING);
+
+    partial_byte_buffer* pbb = pbb_pipeline_buffer(pipeline);
+    pbb_write_int(pbb, 0xABC, 12);
+    pbb = pbb_pipeline_submit(pipeline);
+
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0xAB}));
+    ASSERT_EQ(pbb->write_pos, 4);
+    ASSERT_EQ(pbb->buffer[0], 0xC0);
+    ASSERT_EQ(pbb->buffer[1], 0x00);
+
+    pbb_write_byte(pbb, 0x5, 4);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0xAB, 0xC5}));
+}
+
+TEST_F(PbbPipelineTest, Finish_WorkerThread_SameBytesAsBuffer) {
+    pipeline = pbb_pipeline_create(3, 64, collect, this);
+    ASSERT_EQ(pbb_pipeline_get_backend(pipeline), PBB_PIPELINE_THREAD);
+
+    encode(20000);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+
+    pbb_pipeline_stats stats;
+    pbb_pipeline_get_stats(pipeline, &stats);
+    ASSERT_EQ(sunk.size(), pbb_get_length(reference));
+    ASSERT_EQ(memcmp(sunk.data(), reference->buffer, sunk.size()), 0);
+    ASSERT_EQ(stats.submitted, (size_t)calls);
+    ASSERT_EQ(stats.completed, stats.submitted);
+    ASSERT_EQ(stats.bytes_written, sunk.size());
+    ASSERT_EQ(stats.queue_depth, 0);
+    ASSERT_LE(stats.max_queue_depth, 3);
+}
+
+TEST_F(PbbPipelineTest, Submit_SlowSink_StallsCounted) {
+    pipeline = pbb_pipeline_create(2, 16, collect, this);
+    delay_ms = 5;
+
+    for (int i = 0; i < 4; ++i) {
+        partial_byte_buffer* pbb = pbb_pipeline_buffer(pipeline);
+        for (int j = 0; j < 4; ++j) pbb_write_int(pbb, i, 32);
+        ASSERT_NE(pbb_pipeline_submit(pipeline), nullptr);
+    }
+
+    pbb_pipeline_stats stats;
+    pbb_pipeline_get_stats(pipeline, &stats);
+    ASSERT_EQ(stats.submitted, 4);
+    ASSERT_GE(stats.stalls, 1);
+    ASSERT_GT(stats.stall_nanoseconds, 0);
+    ASSERT_EQ(stats.max_queue_depth, 2);
+
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+    ASSERT_EQ(sunk.size(), 4 * 16);
+    ASSERT_EQ(sunk[63], 3);
+}
+
+TEST_F(PbbPipelineTest, Submit_SinkFails_ErrorReportedAndRestDropped) {
+    pipeline = pbb_pipeline_create(2, 8, collect, this);
+    fail_after = 1;
+
+    partial_byte_buffer* pbb = pbb_pipeline_buffer(pipeline);
+    for (int i = 0; i < 100 && pbb != nullptr; ++i) {
+        pbb_write_int(pbb, i, 32);
+        pbb = pbb_pipeline_submit(pipeline);
+    }
+
+    ASSERT_EQ(pbb, nullptr);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 0);
+    ASSERT_EQ(sunk, std::vector<uint8_t>({0, 0, 0, 0}));
+}
+
+TEST_F(PbbPipelineTest, CreateFd_TemporaryFile_SameBytesAsBuffer) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    pipeline = pbb_pipeline_create_fd(fileno(file), 4, 256);
+    ASSERT_NE(pbb_pipeline_get_backend(pipeline), PBB_PIPELINE_BLOCKING);
+
+    encode(50000);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+
+    std::vector<uint8_t> read_back(pbb_get_length(reference) + 16);
+    ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+    ASSERT_EQ(read(fileno(file), read_back.data(), read_back.size()), (ssize_t)pbb_get_length(reference));
+    ASSERT_EQ(memcmp(read_back.data(), reference->buffer, pbb_get_length(reference)), 0);
+
+    pbb_pipeline_stats stats;
+    pbb_pipeline_get_stats(pipeline, &stats);
+    ASSERT_EQ(stats.bytes_written, pbb_get_length(reference));
+    ASSERT_EQ(stats.queue_depth, 0);
+    fclose(file);
+}
+
+TEST_F(PbbPipelineTest, CreateFd_Pipe_WrittenInOrder) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pipeline = pbb_pipeline_create_fd(fds[1], 2, 16);
+
+    for (int i = 0; i < 64; ++i) {
+        pbb_write_int(pbb_pipeline_buffer(pipeline), i, 16);
+    }
+    pbb_write_byte(pbb_pipeline_buffer(pipeline), 0x1, 1);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+    close(fds[1]);
+
+    uint8_t read_back[256] = {0};
+    size_t total = 0;
+    ssize_t count;
+    while ((count = read(fds[0], read_back + total, sizeof(read_back) - total)) > 0) total += (size_t)count;
+    ASSERT_EQ(total, 129);
+    for (int i = 0; i < 64; ++i) {
+        ASSERT_EQ(read_back[2 * i + 1], i) << "value " << i;
+    }
+    ASSERT_EQ(read_back[128], 0x80);
+    close(fds[0]);
+}
+
+TEST_F(PbbPipelineTest, CreateFd_FileWithPrefix_WrittenAfterItAndPositionMoved) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+    ASSERT_EQ(write(fd, "head", 4), 4);
+    pipeline = pbb_pipeline_create_fd(fd, 8, 64);
+
+    encode(20000);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+    size_t length = pbb_get_length(reference);
+    ASSERT_EQ(lseek(fd, 0, SEEK_CUR), (off_t)(4 + length));
+    pbb_pipeline_destroy(&pipeline);
+    ASSERT_EQ(lseek(fd, 0, SEEK_CUR), (off_t)(4 + length));
+
+    std::vector<uint8_t> read_back(4 + length + 16);
+    ASSERT_EQ(pread(fd, read_back.data(), read_back.size(), 0), (ssize_t)(4 + length));
+    ASSERT_EQ(memcmp(read_back.data(), "head", 4), 0);
+    ASSERT_EQ(memcmp(read_back.data() + 4, reference->buffer, length), 0);
+    fclose(file);
+}
+
+TEST_F(PbbPipelineTest, CreateFd_AppendMode_WrittenInOrder) {
+    char path[] = "/tmp/pbb_pipeline_XXXXXX";
+    int created = mkstemp(path);
+    ASSERT_GE(created, 0);
+    ASSERT_EQ(write(created, "head", 4), 4);
+    int fd = open(path, O_WRONLY | O_APPEND);
+    unlink(path);
+    ASSERT_GE(fd, 0);
+    pipeline = pbb_pipeline_create_fd(fd, 4, 32);
+
+    encode(5000);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 1);
+
+    size_t length = pbb_get_length(reference);
+    std::vector<uint8_t> read_back(4 + length + 16);
+    ASSERT_EQ(pread(created, read_back.data(), read_back.size(), 0), (ssize_t)(4 + length));
+    ASSERT_EQ(memcmp(read_back.data() + 4, reference->buffer, length), 0);
+    close(fd);
+    close(created);
+}
+
+TEST_F(PbbPipelineTest, CreateFd_ReadOnlyDescriptor_ErrorReported) {
+    int fd = open("/dev/null", O_RDONLY);
+    ASSERT_GE(fd, 0);
+    pipeline = pbb_pipeline_create_fd(fd, 4, 8);
+
+    partial_byte_buffer* pbb = pbb_pipeline_buffer(pipeline);
+    for (int i = 0; i < 100 && pbb != nullptr; ++i) {
+        pbb_write_int(pbb, i, 32);
+        pbb = pbb_pipeline_submit(pipeline);
+    }
+
+    ASSERT_EQ(pbb, nullptr);
+    ASSERT_EQ(pbb_pipeline_finish(pipeline), 0);
+    pbb_pipeline_stats stats;
+    pbb_pipeline_get_stats(pipeline, &stats);
+    ASSERT_EQ(stats.bytes_written, 0u);
+    pbb_pipeline_destroy(&pipeline);
+    close(fd);
+}
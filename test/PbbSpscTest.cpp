@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "pbb_spsc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+
+class PbbSpscTest : public ::testing::Test {
+    protected:
+        pbb_spsc *spsc = nullptr;
+        void TearDown() override {
+            pbb_spsc_destroy(&spsc);
+        }
+};
+
+/**
+ * Deterministic value and length of the [i]th field of the threaded tests.
+ */
+static uint8_t fieldBits(uint64_t i) {
+    return (uint8_t)(i * 7 % 64 + 1);
+}
+
+static int64_t fieldValue(uint64_t i) {
+    uint8_t bits = fieldBits(i);
+    uint64_t random = (i + 1) * 0x9E3779B97F4A7C15;
+    return (int64_t)(random << (64 - bits)) >> (64 - bits);
+}
+
+TEST_F(PbbSpscTest, Create_CapacityRoundedUp_CursorsOnSeparateCacheLines) {
+    spsc = pbb_spsc_create(20);
+
+    ASSERT_NE(spsc, nullptr);
+    ASSERT_EQ(spsc->capacity, 32);
+    ASSERT_EQ((uintptr_t)&spsc->producer % PBB_CACHE_LINE_SIZE, 0);
+    ASSERT_EQ((uintptr_t)&spsc->consumer % PBB_CACHE_LINE_SIZE, 0);
+    ASSERT_GE((uintptr_t)&spsc->consumer - (uintptr_t)&spsc->producer, PBB_CACHE_LINE_SIZE);
+    ASSERT_EQ(pbb_spsc_writable_bits(spsc), 256);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 0);
+}
+
+TEST_F(PbbSpscTest, Create_ZeroCapacity_NothingAllocated) {
+    ASSERT_EQ(pbb_spsc_create(0), nullptr);
+}
+
+TEST_F(PbbSpscTest, Read_PartialByte_NotPublishedUntilCompletedOrFlushed) {
+    spsc = pbb_spsc_create(16);
+    int64_t value = 0;
+
+    ASSERT_EQ(pbb_spsc_write(spsc, 0x5, 4), 1);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 0);
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 4), 0);
+
+    ASSERT_EQ(pbb_spsc_write(spsc, -3, 6), 1);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 8);
+    ASSERT_EQ(spsc->buffer[0], 0x5F);
+
+    ASSERT_EQ(pbb_spsc_flush(spsc), 1);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 16);
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 4), 1);
+    ASSERT_EQ(value, 5);
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 6), 1);
+    ASSERT_EQ(value, -3);
+
+    pbb_spsc_align_read(spsc);
+    ASSERT_EQ(spsc->consumer.read_pos, 16);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 0);
+}
+
+TEST_F(PbbSpscTest, Write_RingFull_FailsUntilConsumerReleasesBytes) {
+    spsc = pbb_spsc_create(16);
+    int64_t value = 0;
+
+    ASSERT_EQ(pbb_spsc_write(spsc, -1, 64), 1);
+    ASSERT_EQ(pbb_spsc_write(spsc, 0x0123456789ABCDEF, 64), 1);
+    ASSERT_EQ(pbb_spsc_write(spsc, 1, 1), 0);
+    ASSERT_EQ(pbb_spsc_writable_bits(spsc), 0);
+
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 12), 1);
+    ASSERT_EQ(pbb_spsc_writable_bits(spsc), 8);
+    ASSERT_EQ(pbb_spsc_write(spsc, 0x2A, 8), 1);
+
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 52), 1);
+    ASSERT_EQ(value, -1);
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 64), 1);
+    ASSERT_EQ(value, 0x0123456789ABCDEF);
+    ASSERT_EQ(pbb_spsc_read(spsc, &value, 8), 1);
+    ASSERT_EQ(value, 0x2A);
+}
+
+TEST_F(PbbSpscTest, WriteRead_FieldsAcrossEndOfRing_SameValues) {
+    spsc = pbb_spsc_create(16);
+    int64_t value = 0;
+    uint64_t next = 0;
+
+    for (uint64_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(pbb_spsc_write(spsc, fieldValue(i), fieldBits(i)), 1) << "field " << i;
+        while (next <= i && pbb_spsc_readable_bits(spsc) >= fieldBits(next)) {
+            ASSERT_EQ(pbb_spsc_read(spsc, &value, fieldBits(next)), 1);
+            ASSERT_EQ(value, fieldValue(next)) << "field " << next;
+            ++next;
+        }
+    }
+    ASSERT_GT(spsc->producer.write_pos, 16 * 8 * 10);
+}
+
+TEST_F(PbbSpscTest, ProducerConsumerThreads_SmallRing_AllValuesInOrder) {
+    spsc = pbb_spsc_create(64);
+    const uint64_t count = 200000;
+
+    std::thread producer([this, count]() {
+        for (uint64_t i = 0; i < count; ++i) {
+            while (!pbb_spsc_write(spsc, fieldValue(i), fieldBits(i))) {
+                std::this_thread::yield();
+            }
+        }
+        while (!pbb_spsc_flush(spsc)) {
+            std::this_thread::yield();
+        }
+    });
+
+    uint64_t mismatches = 0;
+    int64_t value = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        while (!pbb_spsc_read(spsc, &value, fieldBits(i))) {
+            std::this_thread::yield();
+        }
+        if (value != fieldValue(i)) ++mismatches;
+    }
+    producer.join();
+
+    ASSERT_EQ(mismatches, 0);
+    pbb_spsc_align_read(spsc);
+    ASSERT_EQ(pbb_spsc_readable_bits(spsc), 0);
+}